@@ -1,6 +1,8 @@
 #ifndef BUSYBOX_H
 #define BUSYBOX_H
 
+#include "Busybox_Common.h"
+
 // Автоматический выбор реализации
 #if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
 
@@ -18,91 +20,260 @@
     #error "Unsupported platform"
 #endif
 
+// Модули подключаются по маске BUSYBOX_COMMANDS (см. Busybox_Config.h)
+#if BUSYBOX_HAS(HEAPPROF)
+#include "Busybox_Heap.h"
+#endif
+#if BUSYBOX_HAS(TOP)
+#include "Busybox_Top.h"
+#endif
+#if BUSYBOX_HAS(BENCH)
+#include "Busybox_Bench.h"
+#endif
+#if BUSYBOX_HAS(ASYNC)
+#include "Busybox_Async.h"
+#endif
+#include "Busybox_Map.h"
+#if BUSYBOX_HAS(PACK)
+#include "Busybox_Pack.h"
+#endif
+#include "Busybox_Wear.h"
+#include "Busybox_Rm.h"
+#if BUSYBOX_HAS(FSCK)
+#include "Busybox_Fsck.h"
+#endif
+#if BUSYBOX_HAS(SNAPSHOT)
+#include "Busybox_Snapshot.h"
+#endif
+#if BUSYBOX_HAS(DELTA)
+#include "Busybox_Copy.h"
+#endif
+#if BUSYBOX_HAS(KV)
+#include "Busybox_KV.h"
+#endif
+#if BUSYBOX_HAS(RING)
+#include "Busybox_Ring.h"
+#endif
+#if BUSYBOX_HAS(RECLOG)
+#include "Busybox_RecordLog.h"
+#endif
+#if BUSYBOX_HAS(TEXT)
+#include "Busybox_Text.h"
+#endif
+#if BUSYBOX_HAS(DUMP)
+#include "Busybox_Dump.h"
+#endif
+#if BUSYBOX_HAS(WATCH)
+#include "Busybox_Watch.h"
+#endif
+#if BUSYBOX_HAS(LS)
+#include "Busybox_Ls.h"
+#endif
+#if BUSYBOX_HAS(PART)
+#include "Busybox_Part.h"
+#endif
+
 namespace Busybox {
+
+#if !BUSYBOX_HAS(WATCH)
+    // Подписчиков на изменения нет
+    inline void _watchPublish(const char*, uint32_t, ChangeOp) {}
+#endif
+
+    // Файл изменён командой Busybox: сбросить кэши модулей, учесть запись, уведомить подписчиков
+    inline void _touched(const char* path, uint32_t bytes, ChangeOp op) {
+        _mapInvalidate(path);
+        _wearCommit(path, bytes);
+        _watchPublish(path, bytes, op);
+    }
+
+#if !BUSYBOX_HAS(PACK)
+    // Образ ресурсов исключён из сборки: ни один путь ему не принадлежит
+    inline bool _packOwns(const char*) { return false; }
+    inline void _packLs(const char*) {}
+    inline void _packTree(const char*, uint8_t, uint8_t) {}
+    inline bool _packStat(const char*, FileStat&) { return false; }
+#endif
+
+#if !BUSYBOX_HAS(RING)
+    inline bool _ringOwns(const char*) { return false; }
+    inline bool _ringOwns(File&) { return false; }
+    inline bool _ringOwns(const MapView&) { return false; }
+    inline bool _ringCat(const char*) { return false; }
+#endif
+
+    // Текстовое описание причины сброса
+    inline const char* resetReasonStr(uint8_t reason) {
+#if defined(ARDUINO_ARCH_ESP32)
+        switch (reason) {
+            case ESP_RST_POWERON:   return "Power On";
+            case ESP_RST_EXT:       return "External";
+            case ESP_RST_SW:        return "Software";
+            case ESP_RST_PANIC:     return "Panic";
+            case ESP_RST_INT_WDT:   return "Interrupt WDT";
+            case ESP_RST_TASK_WDT:  return "Task WDT";
+            case ESP_RST_WDT:       return "Other WDT";
+            case ESP_RST_DEEPSLEEP: return "Deep Sleep";
+            case ESP_RST_BROWNOUT:  return "Brownout";
+            case ESP_RST_SDIO:      return "SDIO";
+            default:                return "Unknown";
+        }
+#elif defined(ARDUINO_ARCH_ESP8266)
+        switch (reason) {
+            case REASON_DEFAULT_RST:       return "Power On";
+            case REASON_WDT_RST:           return "Hardware Watchdog";
+            case REASON_EXCEPTION_RST:     return "Exception";
+            case REASON_SOFT_WDT_RST:      return "Software Watchdog";
+            case REASON_SOFT_RESTART:      return "Software/System restart";
+            case REASON_DEEP_SLEEP_AWAKE:  return "Deep-Sleep Wake";
+            case REASON_EXT_SYS_RST:       return "External System";
+            default:                       return "Unknown";
+        }
+#else
+        return "Unknown";
+#endif
+    }
+
+    // Снимок системной информации за один проход, без форматирования строк
+    inline void sysinfo(SysInfo& info) {
+        memset(&info, 0, sizeof(info));
+
+#if defined(ARDUINO_ARCH_ESP32)
+        info.flashSize     = ESP.getFlashChipSize();
+        info.flashSpeed    = ESP.getFlashChipSpeed();
+        info.freeHeap      = ESP.getFreeHeap();
+        info.minFreeHeap   = ESP.getMinFreeHeap();
+        info.maxAllocHeap  = ESP.getMaxAllocHeap();
+        if (info.freeHeap)
+            info.heapFragmentation = 100 - (uint8_t)((uint64_t)info.maxAllocHeap * 100 / info.freeHeap);
+        info.psramSize     = ESP.getPsramSize();
+        info.freePsram     = ESP.getFreePsram();
+        info.maxAllocPsram = ESP.getMaxAllocPsram();
+        info.sketchSize    = ESP.getSketchSize();
+        info.freeSketch    = ESP.getFreeSketchSpace();
+        info.chipCores     = ESP.getChipCores();
+        info.cpuFreqMHz    = ESP.getCpuFreqMHz();
+        info.cycleCount    = ESP.getCycleCount();
+        info.resetReason   = esp_reset_reason();
+
+#elif defined(ARDUINO_ARCH_ESP8266)
+        info.flashSize     = ESP.getFlashChipRealSize();
+        info.flashSpeed    = ESP.getFlashChipSpeed();
+        info.flashMode     = ESP.getFlashChipMode();
+
+        uint32_t freeHeap;
+        uint32_t maxBlock;
+        uint8_t  frag;
+        ESP.getHeapStats(&freeHeap, &maxBlock, &frag);
+        info.freeHeap          = freeHeap;
+        info.maxAllocHeap      = maxBlock;
+        info.heapFragmentation = frag;
+        info.freeStack         = ESP.getFreeContStack();
+
+        info.sketchSize    = ESP.getSketchSize();
+        info.freeSketch    = ESP.getFreeSketchSpace();
+        info.chipId        = ESP.getChipId();
+        info.cpuFreqMHz    = ESP.getCpuFreqMHz();
+        info.cycleCount    = ESP.getCycleCount();
+        info.bootVersion   = ESP.getBootVersion();
+        info.bootMode      = ESP.getBootMode();
+        info.vcc           = ESP.getVcc();
+        info.resetReason   = ESP.getResetInfoPtr()->reason;
+
+#else
+        info.freeHeap      = ::freeMemory();
+#endif
+
+        info.uptimeMs = millis();
+    }
+
+#if BUSYBOX_HAS(SYSINFO)
     // Вывод информации о памяти
-    void sysinfo() {
+    inline void sysinfo() {
+        SysInfo info;
+        sysinfo(info);
+
         Serial.println("=== Memory Information ===");
         
 #if defined(ARDUINO_ARCH_ESP32)
         // Для ESP32
-        Serial.printf("Flash Size:   %d MB\n", ESP.getFlashChipSize() / (1024 * 1024));
-        Serial.printf("Flash Speed:  %d MHz\n", ESP.getFlashChipSpeed() / 1000000);
+        Serial.printf("Flash Size:   %d MB\n", info.flashSize / (1024 * 1024));
+        Serial.printf("Flash Speed:  %d MHz\n", info.flashSpeed / 1000000);
         
-        Serial.printf("Free Heap:    %d bytes\n", ESP.getFreeHeap());
-        Serial.printf("Min Free:     %d bytes\n", ESP.getMinFreeHeap());
-        Serial.printf("Max Alloc:    %d bytes\n", ESP.getMaxAllocHeap());
+        Serial.printf("Free Heap:    %d bytes\n", info.freeHeap);
+        Serial.printf("Min Free:     %d bytes\n", info.minFreeHeap);
+        Serial.printf("Max Alloc:    %d bytes\n", info.maxAllocHeap);
+        Serial.printf("Heap Frag:    %d%%\n", info.heapFragmentation);
         
-        Serial.printf("PSRAM Size:   %d bytes\n", ESP.getPsramSize());
-        Serial.printf("Free PSRAM:   %d bytes\n", ESP.getFreePsram());
-        Serial.printf("Max PSRAM:    %d bytes\n", ESP.getMaxAllocPsram());
+        Serial.printf("PSRAM Size:   %d bytes\n", info.psramSize);
+        Serial.printf("Free PSRAM:   %d bytes\n", info.freePsram);
+        Serial.printf("Max PSRAM:    %d bytes\n", info.maxAllocPsram);
         
-        Serial.printf("Sketch Size:  %d bytes\n", ESP.getSketchSize());
-        Serial.printf("Free Sketch:  %d bytes\n", ESP.getFreeSketchSpace());
+        Serial.printf("Sketch Size:  %d bytes\n", info.sketchSize);
+        Serial.printf("Free Sketch:  %d bytes\n", info.freeSketch);
 
 #elif defined(ARDUINO_ARCH_ESP8266)
         // Для ESP8266
-        Serial.printf("Flash Size:   %d MB\n", ESP.getFlashChipRealSize() / (1024 * 1024));
-        Serial.printf("Flash Speed:  %d MHz\n", ESP.getFlashChipSpeed() / 1000000);
-        Serial.printf("Flash Mode:   %s\n", ESP.getFlashChipMode() == FM_QIO ? "QIO" : 
-                                          ESP.getFlashChipMode() == FM_QOUT ? "QOUT" :
-                                          ESP.getFlashChipMode() == FM_DIO ? "DIO" :
-                                          ESP.getFlashChipMode() == FM_DOUT ? "DOUT" : "UNKNOWN");
+        Serial.printf("Flash Size:   %d MB\n", info.flashSize / (1024 * 1024));
+        Serial.printf("Flash Speed:  %d MHz\n", info.flashSpeed / 1000000);
+        Serial.printf("Flash Mode:   %s\n", info.flashMode == FM_QIO ? "QIO" : 
+                                          info.flashMode == FM_QOUT ? "QOUT" :
+                                          info.flashMode == FM_DIO ? "DIO" :
+                                          info.flashMode == FM_DOUT ? "DOUT" : "UNKNOWN");
         
-        Serial.printf("Free Heap:    %d bytes\n", ESP.getFreeHeap());
-        Serial.printf("Max Alloc:    %d bytes\n", ESP.getMaxFreeBlockSize());
-        Serial.printf("Heap Frag:    %d%%\n", ESP.getHeapFragmentation());
-        Serial.printf("Free Stack:   %d bytes\n", ESP.getFreeContStack());
+        Serial.printf("Free Heap:    %d bytes\n", info.freeHeap);
+        Serial.printf("Max Alloc:    %d bytes\n", info.maxAllocHeap);
+        Serial.printf("Heap Frag:    %d%%\n", info.heapFragmentation);
+        Serial.printf("Free Stack:   %d bytes\n", info.freeStack);
 
-        Serial.printf("Sketch Size:  %d bytes\n", ESP.getSketchSize());
-        Serial.printf("Free Sketch:  %d bytes\n", ESP.getFreeSketchSpace());
+        Serial.printf("Sketch Size:  %d bytes\n", info.sketchSize);
+        Serial.printf("Free Sketch:  %d bytes\n", info.freeSketch);
         Serial.printf("Sketch MD5:   %s\n", ESP.getSketchMD5().c_str());
 
 #else
         // Для других платформ
-        Serial.printf("Free Heap:    %d bytes\n", ::freeMemory());
+        Serial.printf("Free Heap:    %d bytes\n", info.freeHeap);
+#endif
+
+#if BUSYBOX_HAS(HEAPPROF)
+        // Минимум наибольшего свободного блока по данным heapprof
+        const HeapProfile& prof = _heapprof();
+        if (prof.total) {
+            Serial.printf("Largest LW:   %d bytes (heapprof, %u samples)\n",
+                          prof.lowWater[HEAP_INTERNAL], prof.total);
+        }
 #endif
 
         // Дополнительная системная информация
         Serial.println("=== System Information ===");
 #if defined(ARDUINO_ARCH_ESP32)
         Serial.printf("Chip Model:   %s\n", ESP.getChipModel());
-        Serial.printf("Chip Cores:   %u\n", ESP.getChipCores());
-        Serial.printf("CPU Freq:     %u MHz\n", ESP.getCpuFreqMHz());
-        Serial.printf("Cycle Count:  %u\n", ESP.getCycleCount());
+        Serial.printf("Chip Cores:   %u\n", info.chipCores);
+        Serial.printf("CPU Freq:     %u MHz\n", info.cpuFreqMHz);
+        Serial.printf("Cycle Count:  %u\n", info.cycleCount);
         
 #elif defined(ARDUINO_ARCH_ESP8266)
-        Serial.printf("Chip ID:      0x%08X\n", ESP.getChipId());
-        Serial.printf("CPU Freq:     %d MHz\n", ESP.getCpuFreqMHz());
+        Serial.printf("Chip ID:      0x%08X\n", info.chipId);
+        Serial.printf("CPU Freq:     %d MHz\n", info.cpuFreqMHz);
         Serial.printf("SDK Version:  %s\n", ESP.getSdkVersion());
         Serial.printf("Core Version: %s\n", ESP.getCoreVersion().c_str());
-        Serial.printf("Boot Version: %d\n", ESP.getBootVersion());
-        Serial.printf("Boot Mode:    %d\n", ESP.getBootMode());
-        Serial.printf("VCC:          %.2f V\n", ESP.getVcc() / 1024.0);
+        Serial.printf("Boot Version: %d\n", info.bootVersion);
+        Serial.printf("Boot Mode:    %d\n", info.bootMode);
+        Serial.printf("VCC:          %.2f V\n", info.vcc / 1024.0);
 #endif
 
         // Uptime
         Serial.println("=== Runtime Information ===");
-        unsigned long ms = millis();
-        unsigned long sec = ms / 1000;
+        unsigned long sec = info.uptimeMs / 1000;
         unsigned long min = sec / 60;
         unsigned long hr = min / 60;
         Serial.printf("Uptime:       %02lu:%02lu:%02lu\n", hr % 24, min % 60, sec % 60);
         
-#if defined(ARDUINO_ARCH_ESP32)
-        Serial.printf("Reset Reason: %s\n", esp_reset_reason() == ESP_RST_POWERON ? "Power On" :
-                                          esp_reset_reason() == ESP_RST_EXT ? "External" :
-                                          esp_reset_reason() == ESP_RST_SW ? "Software" :
-                                          esp_reset_reason() == ESP_RST_PANIC ? "Panic" :
-                                          esp_reset_reason() == ESP_RST_INT_WDT ? "Interrupt WDT" :
-                                          esp_reset_reason() == ESP_RST_TASK_WDT ? "Task WDT" :
-                                          esp_reset_reason() == ESP_RST_WDT ? "Other WDT" :
-                                          esp_reset_reason() == ESP_RST_DEEPSLEEP ? "Deep Sleep" :
-                                          esp_reset_reason() == ESP_RST_BROWNOUT ? "Brownout" :
-                                          esp_reset_reason() == ESP_RST_SDIO ? "SDIO" : "Unknown");
-#elif defined(ARDUINO_ARCH_ESP8266)
-        Serial.printf("Reset Reason: %s\n", ESP.getResetReason().c_str());
+#if defined(ARDUINO_ARCH_ESP32) || defined(ARDUINO_ARCH_ESP8266)
+        Serial.printf("Reset Reason: %s\n", resetReasonStr(info.resetReason));
 #endif
     }
+#endif
 }
 
 #endif
\ No newline at end of file
@@ -0,0 +1,346 @@
+#ifndef BUSYBOX_ASYNC_H
+#define BUSYBOX_ASYNC_H
+
+#include "Busybox_Common.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_heap_caps.h>
+#endif
+
+// Фоновое выполнение долгих команд (cp, rmrf, dump, ...) в отдельной задаче.
+// На ESP32 запросы передаются задаче-исполнителю через очередь FreeRTOS,
+// на ESP8266 выполняются сразу в вызывающем коде.
+
+// Длина очереди запросов
+#ifndef BUSYBOX_ASYNC_QUEUE
+#define BUSYBOX_ASYNC_QUEUE 8
+#endif
+
+// Максимальная длина пути в запросе
+#ifndef BUSYBOX_ASYNC_PATH
+#define BUSYBOX_ASYNC_PATH 96
+#endif
+
+// Размер буфера копирования задачи-исполнителя
+#ifndef BUSYBOX_ASYNC_BUFFER
+#define BUSYBOX_ASYNC_BUFFER 4096
+#endif
+
+// Стек задачи-исполнителя
+#ifndef BUSYBOX_ASYNC_STACK
+#define BUSYBOX_ASYNC_STACK 6144
+#endif
+
+namespace Busybox {
+
+    // Команды, которые можно выполнить в фоне
+    enum class AsyncOp : uint8_t {
+        Cp,
+        Mv,
+        Rm,
+        Rmrf,
+        Cat,
+        Dump
+    };
+
+    // Вызывается из задачи-исполнителя по завершении запроса
+    typedef void (*AsyncCallback)(uint32_t id, bool ok, void* arg);
+
+    struct AsyncRequest {
+        uint32_t      id;
+        uint32_t      postedUs;
+        AsyncCallback callback;
+        void*         arg;
+        AsyncOp       op;
+        char          src[BUSYBOX_ASYNC_PATH];
+        char          dst[BUSYBOX_ASYNC_PATH];
+    };
+
+    // Счётчики очереди и времени обслуживания
+    struct AsyncStats {
+        uint32_t posted;
+        uint32_t done;
+        uint32_t failed;
+        uint32_t rejected;          // очередь переполнена или исполнитель не запущен
+        uint32_t queueWaitUs;       // суммарное время в очереди
+        uint32_t serviceUs;         // суммарное время выполнения
+        uint32_t maxServiceUs;
+        uint16_t depth;             // запросов в очереди сейчас
+        uint16_t maxDepth;
+    };
+
+    struct AsyncState {
+        AsyncStats stats;
+        uint32_t   nextId;
+        volatile uint32_t lastDone;
+#if defined(ARDUINO_ARCH_ESP32)
+        QueueHandle_t queue;
+        SemaphoreHandle_t post;     // упорядочивает выдачу номеров и отправку в очередь
+        TaskHandle_t  task;
+        bool          starting;     // asyncBegin создаёт задачу (под _asyncLock)
+        uint8_t*      buffer;
+#endif
+    };
+
+    inline AsyncState& _async() {
+        static AsyncState state = {};
+        return state;
+    }
+
+    // Счётчики обновляют вызывающие задачи и исполнитель, читает asyncstat
+#if defined(ARDUINO_ARCH_ESP32)
+    inline portMUX_TYPE& _asyncMux() {
+        static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+        return mux;
+    }
+    inline void _asyncLock() { portENTER_CRITICAL(&_asyncMux()); }
+    inline void _asyncUnlock() { portEXIT_CRITICAL(&_asyncMux()); }
+#else
+    inline void _asyncLock() {}
+    inline void _asyncUnlock() {}
+#endif
+
+    inline void _asyncReject() {
+        _asyncLock();
+        _async().stats.rejected++;
+        _asyncUnlock();
+    }
+
+    // Копирование с большим буфером исполнителя
+    inline bool _asyncCopy(const char* sourcePath, const char* destPath, uint8_t* buffer, size_t len) {
+        CommandScope _scope("cp");
+        WriteLock _lock;
+        File source = _open(BUSYBOX_FS, sourcePath, "r");
+        if (!source) {
+            Serial.printf("cp: cannot open source '%s'\n", sourcePath);
+            return false;
+        }
+        File dest = _open(BUSYBOX_FS, destPath, "w");
+        if (!dest) {
+            Serial.printf("cp: cannot create '%s'\n", destPath);
+            source.close();
+            return false;
+        }
+
+        // Как в cp: копия короче источника (ошибка чтения или записи) — неудача
+        size_t expected = source.size();
+        size_t bytesCopied = 0;
+        while (true) {
+            size_t bytesRead = _read(source, buffer, len);
+            if (bytesRead == 0) break;
+            size_t bytesWritten = _write(dest, buffer, bytesRead);
+            bytesCopied += bytesWritten;
+            if (bytesWritten != bytesRead) break;
+        }
+        source.close();
+        dest.close();
+        _touched(destPath, bytesCopied);
+        if (bytesCopied != expected) {
+            Serial.printf("cp: copy of '%s' failed at offset %d\n", sourcePath, bytesCopied);
+            return false;
+        }
+        return true;
+    }
+
+    inline bool _asyncRun(const AsyncRequest& req, uint8_t* buffer, size_t len) {
+        switch (req.op) {
+            case AsyncOp::Cp:
+                return buffer ? _asyncCopy(req.src, req.dst, buffer, len) : cp(req.src, req.dst);
+            case AsyncOp::Mv:   return mv(req.src, req.dst);
+            case AsyncOp::Rm:   return rm(req.src);
+            case AsyncOp::Rmrf: return rmdir(req.src, true);
+#if BUSYBOX_HAS(CAT)
+            case AsyncOp::Cat:  return cat(req.src);
+#endif
+#if BUSYBOX_HAS(DUMP)
+            case AsyncOp::Dump: return dump(req.src);
+#endif
+            default:            break;     // команда исключена из сборки (BUSYBOX_COMMANDS)
+        }
+        return false;
+    }
+
+    inline void _asyncComplete(const AsyncRequest& req, bool ok, uint32_t serviceUs) {
+        AsyncState& st = _async();
+        _asyncLock();
+        st.stats.done++;
+        if (!ok) st.stats.failed++;
+        st.stats.serviceUs += serviceUs;
+        if (serviceUs > st.stats.maxServiceUs) st.stats.maxServiceUs = serviceUs;
+        _asyncUnlock();
+        st.lastDone = req.id;
+        if (req.callback) req.callback(req.id, ok, req.arg);
+    }
+
+#if defined(ARDUINO_ARCH_ESP32)
+
+    // Очередь передаётся параметром: st.queue устанавливается только после запуска задачи
+    inline void _asyncWorker(void* param) {
+        AsyncState& st = _async();
+        QueueHandle_t queue = (QueueHandle_t)param;
+        AsyncRequest req;
+        while (true) {
+            if (xQueueReceive(queue, &req, portMAX_DELAY) != pdTRUE) continue;
+            uint32_t t0 = micros();
+            uint16_t depth = uxQueueMessagesWaiting(queue);
+            _asyncLock();
+            st.stats.queueWaitUs += t0 - req.postedUs;
+            st.stats.depth = depth;
+            _asyncUnlock();
+            bool ok = _asyncRun(req, st.buffer, BUSYBOX_ASYNC_BUFFER);
+            _asyncComplete(req, ok, micros() - t0);
+        }
+    }
+
+    /// @brief Запуск задачи-исполнителя
+    /// @param core ядро, на котором работает задача (tskNO_AFFINITY — любое)
+    /// @param priority приоритет задачи
+    /// @return false если не удалось выделить очередь, буфер или задачу
+    inline bool asyncBegin(BaseType_t core = tskNO_AFFINITY, UBaseType_t priority = 1) {
+        AsyncState& st = _async();
+        // Запускает одна задача; остальные ждут её результата
+        while (true) {
+            _asyncLock();
+            bool running = st.task != nullptr;
+            bool busy = st.starting;
+            if (!running && !busy) st.starting = true;
+            _asyncUnlock();
+            if (running) return true;
+            if (!busy) break;
+            vTaskDelay(1);
+        }
+
+        // async() принимает запросы только при st.queue != nullptr, поэтому очередь
+        // публикуется последней, когда исполнитель уже запущен
+        SemaphoreHandle_t post = xSemaphoreCreateMutex();
+        QueueHandle_t queue = xQueueCreate(BUSYBOX_ASYNC_QUEUE, sizeof(AsyncRequest));
+        // Буфер во внутренней памяти: быстрее при работе с flash, чем PSRAM;
+        // без него cp выполняется обычной командой
+        uint8_t* buffer = (uint8_t*)heap_caps_malloc(BUSYBOX_ASYNC_BUFFER, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        st.post = post;
+        st.buffer = buffer;
+
+        TaskHandle_t task = nullptr;
+        if (!post || !queue ||
+            xTaskCreatePinnedToCore(_asyncWorker, "busybox", BUSYBOX_ASYNC_STACK, queue, priority, &task,
+                                    core) != pdPASS) {
+            if (queue) vQueueDelete(queue);
+            if (post) vSemaphoreDelete(post);
+            free(buffer);
+            _asyncLock();
+            st.post = nullptr;
+            st.buffer = nullptr;
+            st.starting = false;
+            _asyncUnlock();
+            return false;
+        }
+        _asyncLock();
+        st.task = task;
+        st.queue = queue;
+        st.starting = false;
+        _asyncUnlock();
+        return true;
+    }
+
+#else
+
+    inline bool asyncBegin(int core = -1, unsigned priority = 1) {
+        return true;
+    }
+
+#endif
+
+    /// @brief Поставить команду в очередь фонового исполнителя
+    /// @param op команда
+    /// @param src путь (источник для cp/mv)
+    /// @param dst путь назначения для cp/mv, иначе nullptr
+    /// @param callback вызывается из задачи-исполнителя по завершении
+    /// @param arg аргумент для callback
+    /// @return идентификатор запроса или 0, если запрос не принят
+    inline uint32_t async(AsyncOp op, const char* src, const char* dst = nullptr,
+                   AsyncCallback callback = nullptr, void* arg = nullptr) {
+        AsyncState& st = _async();
+        if (strlen(src) >= BUSYBOX_ASYNC_PATH || (dst && strlen(dst) >= BUSYBOX_ASYNC_PATH)) {
+            _asyncReject();
+            return 0;
+        }
+
+        AsyncRequest req;
+        req.op = op;
+        req.callback = callback;
+        req.arg = arg;
+        strcpy(req.src, src);
+        strcpy(req.dst, dst ? dst : "");
+        req.postedUs = micros();
+
+#if defined(ARDUINO_ARCH_ESP32)
+        if (!st.queue) {
+            _asyncReject();
+            return 0;
+        }
+
+        // Номер выдаётся и отправляется под одним мьютексом, чтобы порядок
+        // в очереди совпадал с порядком номеров (на этом основан asyncWait)
+        xSemaphoreTake(st.post, portMAX_DELAY);
+        req.id = st.nextId + 1;
+        if (req.id == 0) req.id = 1;
+        bool queued = xQueueSend(st.queue, &req, 0) == pdTRUE;
+        if (queued) st.nextId = req.id;
+        xSemaphoreGive(st.post);
+
+        if (!queued) {
+            _asyncReject();
+            return 0;
+        }
+        uint16_t depth = uxQueueMessagesWaiting(st.queue);
+        _asyncLock();
+        st.stats.posted++;
+        st.stats.depth = depth;
+        if (depth > st.stats.maxDepth) st.stats.maxDepth = depth;
+        _asyncUnlock();
+#else
+        req.id = st.nextId + 1;
+        if (req.id == 0) req.id = 1;
+        st.nextId = req.id;
+        st.stats.posted++;
+        uint32_t t0 = micros();
+        bool ok = _asyncRun(req, nullptr, 0);
+        _asyncComplete(req, ok, micros() - t0);
+#endif
+        return req.id;
+    }
+
+    /// @brief Ожидание завершения запроса (запросы выполняются по порядку)
+    /// @param id идентификатор, полученный от async
+    /// @param timeoutMs время ожидания, 0 — только проверить
+    /// @return true если запрос id выполнен
+    inline bool asyncWait(uint32_t id, uint32_t timeoutMs = 0) {
+        AsyncState& st = _async();
+        uint32_t start = millis();
+        while ((int32_t)(st.lastDone - id) < 0) {
+            if (millis() - start >= timeoutMs) return false;
+            delay(1);
+        }
+        return true;
+    }
+
+    // Вывод счётчиков очереди
+    inline void asyncstat() {
+        // Копия, чтобы не выводить счётчики, изменяемые исполнителем на ходу
+        _asyncLock();
+        AsyncStats s = _async().stats;
+        _asyncUnlock();
+        Serial.println("=== Async queue ===");
+        Serial.printf("Posted:       %lu (rejected %lu)\n", (unsigned long)s.posted, (unsigned long)s.rejected);
+        Serial.printf("Done:         %lu (failed %lu)\n", (unsigned long)s.done, (unsigned long)s.failed);
+        Serial.printf("Depth:        %u (max %u)\n", s.depth, s.maxDepth);
+        if (s.done) {
+            Serial.printf("Queue wait:   %lu us avg\n", (unsigned long)(s.queueWaitUs / s.done));
+            Serial.printf("Service time: %lu us avg, %lu us max\n",
+                          (unsigned long)(s.serviceUs / s.done), (unsigned long)s.maxServiceUs);
+        }
+    }
+
+} // namespace Busybox
+
+#endif
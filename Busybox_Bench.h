@@ -0,0 +1,271 @@
+#ifndef BUSYBOX_BENCH_H
+#define BUSYBOX_BENCH_H
+
+#include "Busybox_Common.h"
+
+// Число мелких файлов в тесте create/delete и итераций rename
+#ifndef BUSYBOX_BENCH_SMALL_FILES
+#define BUSYBOX_BENCH_SMALL_FILES 32
+#endif
+
+// Размер мелкого файла в тесте create/delete
+#define BUSYBOX_BENCH_SMALL_SIZE 32
+
+// Число корзин гистограммы задержек: по 4 корзины на каждую степень двойки
+#define BUSYBOX_BENCH_BUCKETS 124
+
+namespace Busybox {
+
+    // Гистограмма задержек в микросекундах с фиксированным числом корзин.
+    // До 8 мкс — точные значения, дальше по 4 корзины на октаву (точность ~25%).
+    struct LatencyHist {
+        uint32_t buckets[BUSYBOX_BENCH_BUCKETS];
+        uint32_t count;
+        uint32_t maxUs;
+        uint64_t totalUs;
+
+        void reset() {
+            memset(this, 0, sizeof(*this));
+        }
+
+        static uint8_t bucketOf(uint32_t us) {
+            if (us < 8) return us;
+            uint8_t e = 31 - __builtin_clz(us);
+            return 8 + (e - 3) * 4 + ((us >> (e - 2)) & 3);
+        }
+
+        // Верхняя граница значений корзины
+        static uint32_t bucketTop(uint8_t idx) {
+            if (idx < 8) return idx;
+            uint8_t e = (idx - 8) / 4 + 3;
+            uint8_t sub = (idx - 8) % 4;
+            return (((uint32_t)(4 + sub + 1)) << (e - 2)) - 1;
+        }
+
+        void add(uint32_t us) {
+            buckets[bucketOf(us)]++;
+            count++;
+            totalUs += us;
+            if (us > maxUs) maxUs = us;
+        }
+
+        // Перцентиль (0..100) по гистограмме
+        uint32_t percentile(uint8_t p) const {
+            if (count == 0) return 0;
+            uint32_t rank = ((uint64_t)count * p + 99) / 100;
+            if (rank == 0) rank = 1;
+            uint32_t seen = 0;
+            for (uint8_t i = 0; i < BUSYBOX_BENCH_BUCKETS; i++) {
+                seen += buckets[i];
+                if (seen >= rank) {
+                    uint32_t top = bucketTop(i);
+                    return top < maxUs ? top : maxUs;
+                }
+            }
+            return maxUs;
+        }
+    };
+
+    inline LatencyHist& _benchHist() {
+        static LatencyHist hist;
+        return hist;
+    }
+
+    inline void _benchPath(char* out, size_t len, const char* dir, const char* name) {
+        size_t dirLen = strlen(dir);
+        if (dirLen && dir[dirLen - 1] == '/') snprintf(out, len, "%s%s", dir, name);
+        else snprintf(out, len, "%s/%s", dir, name);
+    }
+
+    // Вывод строки результата; bytes == 0 — операции без объёма (выводится ops/s)
+    inline void _benchReport(const char* op, const LatencyHist& h, uint32_t bytes) {
+        uint32_t totalUs = h.totalUs ? (uint32_t)h.totalUs : 1;
+        if (bytes) {
+            Serial.printf("%-13s %8lu KB/s", op, (unsigned long)((uint64_t)bytes * 1000000 / totalUs / 1024));
+        } else {
+            Serial.printf("%-13s %7lu ops/s", op, (unsigned long)((uint64_t)h.count * 1000000 / totalUs));
+        }
+        Serial.printf(" %9lu %9lu %9lu\n", (unsigned long)h.percentile(50),
+                      (unsigned long)h.percentile(99), (unsigned long)h.maxUs);
+    }
+
+    // Последовательная запись, последовательное и случайное чтение одного файла
+    inline bool _benchFile(const char* path, uint32_t size, uint16_t blockSize, uint8_t* buffer) {
+        LatencyHist& h = _benchHist();
+
+        // Последовательная запись (закрытие входит в последнюю операцию)
+        h.reset();
+        File file = _open(BUSYBOX_FS, path, "w");
+        if (!file) {
+            Serial.printf("fsbench: cannot create '%s'\n", path);
+            return false;
+        }
+        uint32_t written = 0;
+        while (written < size) {
+            uint16_t chunk = size - written < blockSize ? size - written : blockSize;
+            uint32_t t0 = micros();
+            size_t n = _write(file, buffer, chunk);
+            if (written + chunk >= size) file.close();
+            h.add(micros() - t0);
+            if (n != chunk) {
+                Serial.println("fsbench: write failed (no space?)");
+                file.close();
+                return false;
+            }
+            written += chunk;
+            yield();
+        }
+        _benchReport("seq write", h, written);
+
+        // Последовательное чтение
+        h.reset();
+        file = _open(BUSYBOX_FS, path, "r");
+        if (!file) {
+            Serial.printf("fsbench: cannot open '%s'\n", path);
+            return false;
+        }
+        uint32_t readTotal = 0;
+        while (true) {
+            uint32_t t0 = micros();
+            size_t n = _read(file, buffer, blockSize);
+            if (n == 0) break;
+            h.add(micros() - t0);
+            readTotal += n;
+            yield();
+        }
+        _benchReport("seq read", h, readTotal);
+
+        // Случайное чтение выровненных блоков
+        h.reset();
+        uint32_t blocks = size / blockSize;
+        uint32_t rnd = 0x9E3779B9;
+        uint32_t randTotal = 0;
+        for (uint32_t i = 0; blocks && i < blocks; i++) {
+            rnd ^= rnd << 13;
+            rnd ^= rnd >> 17;
+            rnd ^= rnd << 5;
+            uint32_t t0 = micros();
+            file.seek((rnd % blocks) * blockSize);
+            size_t n = _read(file, buffer, blockSize);
+            h.add(micros() - t0);
+            randTotal += n;
+            yield();
+        }
+        file.close();
+        if (blocks) _benchReport("rand read", h, randTotal);
+
+        return true;
+    }
+
+    // Скорость создания/удаления мелких файлов и задержка rename
+    inline void _benchMeta(const char* dir, uint8_t* buffer) {
+        LatencyHist& h = _benchHist();
+        char path[64];
+        char path2[64];
+
+        h.reset();
+        uint16_t created = 0;
+        for (uint16_t i = 0; i < BUSYBOX_BENCH_SMALL_FILES; i++) {
+            char name[16];
+            snprintf(name, sizeof(name), "bbs%u.bin", i);
+            _benchPath(path, sizeof(path), dir, name);
+            uint32_t t0 = micros();
+            File file = _open(BUSYBOX_FS, path, "w");
+            if (!file) break;
+            _write(file, buffer, BUSYBOX_BENCH_SMALL_SIZE);
+            file.close();
+            h.add(micros() - t0);
+            created++;
+            yield();
+        }
+        _benchReport("small create", h, 0);
+
+        h.reset();
+        for (uint16_t i = 0; i < created; i++) {
+            char name[16];
+            snprintf(name, sizeof(name), "bbs%u.bin", i);
+            _benchPath(path, sizeof(path), dir, name);
+            uint32_t t0 = micros();
+            _remove(BUSYBOX_FS, path);
+            h.add(micros() - t0);
+            yield();
+        }
+        _benchReport("small delete", h, 0);
+
+        // rename туда и обратно
+        _benchPath(path, sizeof(path), dir, "bbr_a.bin");
+        _benchPath(path2, sizeof(path2), dir, "bbr_b.bin");
+        File file = _open(BUSYBOX_FS, path, "w");
+        if (!file) return;
+        _write(file, buffer, BUSYBOX_BENCH_SMALL_SIZE);
+        file.close();
+
+        h.reset();
+        for (uint16_t i = 0; i < BUSYBOX_BENCH_SMALL_FILES; i++) {
+            const char* from = (i & 1) ? path2 : path;
+            const char* to = (i & 1) ? path : path2;
+            uint32_t t0 = micros();
+            bool ok = _rename(BUSYBOX_FS, from, to);
+            h.add(micros() - t0);
+            if (!ok) break;
+            yield();
+        }
+        _benchReport("rename", h, 0);
+        _remove(BUSYBOX_FS, path);
+        _remove(BUSYBOX_FS, path2);
+    }
+
+    /// @brief Замер задержек и пропускной способности ФС. Временные файлы удаляются.
+    /// @param dir каталог для временных файлов
+    /// @param sizes размеры тестового файла
+    /// @param blockSizes размеры блока чтения/записи
+    /// @return false если тест не удалось выполнить
+    inline bool fsbench(const char* dir = "/",
+                 std::initializer_list<uint32_t> sizes = {65536},
+                 std::initializer_list<uint16_t> blockSizes = {128, 512, 4096}) {
+        CommandScope _scope("fsbench");
+        WriteLock _lock;
+        uint16_t maxBlock = BUSYBOX_BENCH_SMALL_SIZE;
+        for (auto bs : blockSizes) if (bs > maxBlock) maxBlock = bs;
+
+        uint8_t* buffer = (uint8_t*)malloc(maxBlock);
+        if (!buffer) {
+            Serial.printf("fsbench: cannot allocate %u bytes\n", maxBlock);
+            return false;
+        }
+        for (uint16_t i = 0; i < maxBlock; i++) buffer[i] = (uint8_t)(i * 31 + 7);
+
+        FsInfo info;
+        bool haveInfo = df(info);
+
+        char path[64];
+        _benchPath(path, sizeof(path), dir, "bb_bench.bin");
+
+        Serial.printf("=== fsbench: %s ===\n", dir);
+        bool success = true;
+        for (auto size : sizes) {
+            if (haveInfo && size > info.freeBytes / 2) {
+                Serial.printf("fsbench: skip size %lu, only %lu bytes free\n",
+                              (unsigned long)size, (unsigned long)info.freeBytes);
+                continue;
+            }
+            for (auto bs : blockSizes) {
+                if (bs == 0) continue;
+                Serial.printf("--- size %lu, block %u ---\n", (unsigned long)size, bs);
+                Serial.println("op                throughput    p50 us    p99 us    max us");
+                if (!_benchFile(path, size, bs, buffer)) success = false;
+                _remove(BUSYBOX_FS, path);
+            }
+        }
+
+        Serial.println("--- metadata ---");
+        Serial.println("op                throughput    p50 us    p99 us    max us");
+        _benchMeta(dir, buffer);
+
+        free(buffer);
+        return success;
+    }
+
+} // namespace Busybox
+
+#endif
@@ -0,0 +1,388 @@
+#ifndef BUSYBOX_CACHE_H
+#define BUSYBOX_CACHE_H
+
+#include "Busybox_Common.h"
+#include "Busybox_Stats.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_heap_caps.h>
+#endif
+
+// Блочный кэш чтения/записи для команд Busybox.
+// Команды читают файлы порциями по 1..128 байт; BlockReader превращает их
+// в чтения целыми блоками, выровненными по границе блока (страницы/сектора flash),
+// а BlockWriter копит запись до границы блока. Блоки берутся из общего пула,
+// который выделяется при первом использовании. Если свободного блока нет,
+// чтение идёт через небольшой буфер в объекте, а запись — напрямую.
+
+// Размер блока кэша (кратен странице flash, лучше — сектору)
+#ifndef BUSYBOX_CACHE_BLOCK
+#if defined(ARDUINO_ARCH_ESP32)
+#define BUSYBOX_CACHE_BLOCK 4096
+#else
+#define BUSYBOX_CACHE_BLOCK 512
+#endif
+#endif
+
+// Число блоков в пуле (cp занимает два: чтение и запись)
+#ifndef BUSYBOX_CACHE_BLOCKS
+#define BUSYBOX_CACHE_BLOCKS 2
+#endif
+
+// Размещать пул в PSRAM (1) или во внутренней памяти (0)
+#ifndef BUSYBOX_CACHE_PSRAM
+#define BUSYBOX_CACHE_PSRAM 0
+#endif
+
+// Максимальное число блоков, задаваемое cacheConfig
+#define BUSYBOX_CACHE_MAX_BLOCKS 8
+
+namespace Busybox {
+
+    // Счётчики кэша
+    struct CacheStats {
+        uint32_t hits;          // чтения, обслуженные из блока без обращения к ФС
+        uint32_t misses;        // чтения, потребовавшие обращения к ФС
+        uint32_t fills;         // загрузки блока
+        uint32_t flushes;       // выгрузки блока записи
+        uint32_t bytesRead;     // прочитано из ФС через кэш
+        uint32_t bytesWritten;  // записано в ФС через кэш
+        uint32_t poolEmpty;     // запросов блока при пустом пуле
+    };
+
+    struct CachePool {
+        uint8_t*   blocks[BUSYBOX_CACHE_MAX_BLOCKS];
+        bool       busy[BUSYBOX_CACHE_MAX_BLOCKS];
+        uint16_t   blockSize;
+        uint8_t    count;
+        bool       psram;
+        bool       allocated;
+        CacheStats stats;
+    };
+
+    inline CachePool& _cachePool() {
+        static CachePool pool = {{}, {}, BUSYBOX_CACHE_BLOCK, BUSYBOX_CACHE_BLOCKS, BUSYBOX_CACHE_PSRAM != 0};
+        return pool;
+    }
+
+#if defined(ARDUINO_ARCH_ESP32)
+    inline portMUX_TYPE& _cacheMux() {
+        static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+        return mux;
+    }
+    inline void _cacheLock() { portENTER_CRITICAL(&_cacheMux()); }
+    inline void _cacheUnlock() { portEXIT_CRITICAL(&_cacheMux()); }
+#else
+    inline void _cacheLock() {}
+    inline void _cacheUnlock() {}
+#endif
+
+    // Счётчики пула общие для всех задач и меняются только под _cacheLock
+    inline void _cacheCount(uint32_t& counter, uint32_t n = 1) {
+        _cacheLock();
+        counter += n;
+        _cacheUnlock();
+    }
+
+    inline uint8_t* _cacheAlloc(size_t size, bool psram) {
+#if defined(ARDUINO_ARCH_ESP32)
+        if (psram) {
+            uint8_t* p = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+            if (p) return p;
+        }
+        // Внутренняя память быстрее при обмене с flash
+        return (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+#else
+        return (uint8_t*)malloc(size);
+#endif
+    }
+
+    // Взять свободный блок пула, -1 если нет
+    inline int8_t _cacheAcquire() {
+        CachePool& p = _cachePool();
+        if (!p.allocated) {
+            // Выделение вне критической секции; гонка двух первых вызовов
+            // разрешается ниже — лишние блоки освобождаются
+            uint8_t* fresh[BUSYBOX_CACHE_MAX_BLOCKS] = {};
+            for (uint8_t i = 0; i < p.count; i++) fresh[i] = _cacheAlloc(p.blockSize, p.psram);
+            bool used = false;
+            _cacheLock();
+            if (!p.allocated) {
+                memcpy(p.blocks, fresh, sizeof(fresh));
+                p.allocated = true;
+                used = true;
+            }
+            _cacheUnlock();
+            if (!used) {
+                for (uint8_t i = 0; i < p.count; i++) free(fresh[i]);
+            }
+        }
+
+        int8_t found = -1;
+        _cacheLock();
+        for (uint8_t i = 0; i < p.count; i++) {
+            if (p.blocks[i] && !p.busy[i]) {
+                p.busy[i] = true;
+                found = i;
+                break;
+            }
+        }
+        if (found < 0) p.stats.poolEmpty++;
+        _cacheUnlock();
+        return found;
+    }
+
+    inline void _cacheRelease(int8_t index) {
+        if (index < 0) return;
+        _cacheLock();
+        _cachePool().busy[index] = false;
+        _cacheUnlock();
+    }
+
+    /// @brief Настройка пула блоков (применяется, когда ни один блок не занят)
+    /// @param blocks число блоков, 0 — отключить кэш
+    /// @param blockSize размер блока в байтах
+    /// @param psram размещать пул в PSRAM
+    /// @return false если блоки пула заняты
+    inline bool cacheConfig(uint8_t blocks, uint16_t blockSize = BUSYBOX_CACHE_BLOCK, bool psram = BUSYBOX_CACHE_PSRAM != 0) {
+        CachePool& p = _cachePool();
+        uint8_t* old[BUSYBOX_CACHE_MAX_BLOCKS];
+        _cacheLock();
+        for (uint8_t i = 0; i < p.count; i++) {
+            if (p.busy[i]) {
+                _cacheUnlock();
+                return false;
+            }
+        }
+        memcpy(old, p.blocks, sizeof(old));
+        memset(p.blocks, 0, sizeof(p.blocks));
+        p.count = blocks < BUSYBOX_CACHE_MAX_BLOCKS ? blocks : BUSYBOX_CACHE_MAX_BLOCKS;
+        p.blockSize = blockSize ? blockSize : BUSYBOX_CACHE_BLOCK;
+        p.psram = psram;
+        p.allocated = false;
+        _cacheUnlock();
+        for (uint8_t i = 0; i < BUSYBOX_CACHE_MAX_BLOCKS; i++) free(old[i]);
+        return true;
+    }
+
+    // Блок пула на время жизни объекта; если пул пуст — буфер вызывающего
+    class CacheBlock {
+    public:
+        CacheBlock(uint8_t* fallback, size_t fallbackSize) {
+            _index = _cacheAcquire();
+            data = _index >= 0 ? _cachePool().blocks[_index] : fallback;
+            size = _index >= 0 ? _cachePool().blockSize : fallbackSize;
+        }
+
+        ~CacheBlock() { _cacheRelease(_index); }
+
+        CacheBlock(const CacheBlock&) = delete;
+        CacheBlock& operator=(const CacheBlock&) = delete;
+
+        uint8_t* data;
+        size_t   size;
+
+    private:
+        int8_t _index;
+    };
+
+    // Последовательное чтение файла блоками с упреждением
+    class BlockReader {
+    public:
+        explicit BlockReader(File& file) : _file(file), _pos(0), _len(0) {
+            _index = _cacheAcquire();
+            if (_index >= 0) {
+                _buffer = _cachePool().blocks[_index];
+                _size = _cachePool().blockSize;
+            } else {
+                _buffer = _small;
+                _size = sizeof(_small);
+            }
+            _offset = file.position();
+        }
+
+        ~BlockReader() { _cacheRelease(_index); }
+
+        BlockReader(const BlockReader&) = delete;
+        BlockReader& operator=(const BlockReader&) = delete;
+
+        // Байт, ещё не выданных читателю
+        size_t available() {
+            return (_len - _pos) + _file.available();
+        }
+
+        // Следующая порция данных без копирования: до конца загруженного блока.
+        // Возвращает nullptr в конце файла.
+        const uint8_t* next(size_t& len) {
+            if (_pos < _len) {
+                _hit();
+            } else if (_fill()) {
+                _cacheCount(_cachePool().stats.misses);
+            } else {
+                len = 0;
+                return nullptr;
+            }
+            len = _len - _pos;
+            const uint8_t* data = _buffer + _pos;
+            _pos = _len;
+            return data;
+        }
+
+        size_t read(uint8_t* dst, size_t len) {
+            size_t done = 0;
+            bool direct = false;
+            while (done < len) {
+                if (_pos == _len) {
+                    // Длинное чтение с границы блока — сразу в буфер вызывающего
+                    size_t want = len - done;
+                    if (want >= _size && _offset % _size == 0) {
+                        want -= want % _size;
+                        size_t n = _read(_file, dst + done, want);
+                        _count(n);
+                        _offset += n;
+                        done += n;
+                        direct = true;
+                        if (n < want) break;
+                        continue;
+                    }
+                    if (!_fill()) break;
+                    direct = true;
+                }
+                size_t n = _len - _pos;
+                if (n > len - done) n = len - done;
+                memcpy(dst + done, _buffer + _pos, n);
+                _pos += n;
+                done += n;
+            }
+            if (!direct && done) _hit();
+            else if (direct) _cacheCount(_cachePool().stats.misses);
+            return done;
+        }
+
+        int read() {
+            if (_pos == _len) {
+                if (!_fill()) return -1;
+                _cacheCount(_cachePool().stats.misses);
+            } else {
+                _hit();
+            }
+            return _buffer[_pos++];
+        }
+
+    private:
+        // Загрузка следующего блока; первое чтение выравнивает позицию по границе блока
+        bool _fill() {
+            size_t want = _size - (_offset % _size);
+            size_t n = _read(_file, _buffer, want);
+            _pos = 0;
+            _len = n;
+            _offset += n;
+            _count(n);
+            if (n) _cacheCount(_cachePool().stats.fills);
+            return n > 0;
+        }
+
+        void _hit() { _cacheCount(_cachePool().stats.hits); }
+        void _count(size_t n) { _cacheCount(_cachePool().stats.bytesRead, n); }
+
+        File&    _file;
+        uint8_t* _buffer;
+        size_t   _size;
+        size_t   _pos;
+        size_t   _len;
+        uint32_t _offset;       // позиция в файле за концом загруженных данных
+        int8_t   _index;
+        uint8_t  _small[64];
+    };
+
+    // Запись в файл с накоплением до границы блока
+    class BlockWriter {
+    public:
+        explicit BlockWriter(File& file) : _file(file), _len(0), _failed(false) {
+            _index = _cacheAcquire();
+            _buffer = _index >= 0 ? _cachePool().blocks[_index] : nullptr;
+            _size = _index >= 0 ? _cachePool().blockSize : 0;
+            _offset = file.position();
+        }
+
+        ~BlockWriter() {
+            flush();
+            _cacheRelease(_index);
+        }
+
+        BlockWriter(const BlockWriter&) = delete;
+        BlockWriter& operator=(const BlockWriter&) = delete;
+
+        // Возвращает число принятых байт; ошибка записи обнаруживается в flush
+        size_t write(const uint8_t* src, size_t len) {
+            if (!_buffer) return _put(src, len);
+
+            size_t done = 0;
+            while (done < len && !_failed) {
+                // Пустой буфер на границе блока: целые блоки пишутся напрямую
+                if (_len == 0 && _offset % _size == 0 && len - done >= _size) {
+                    size_t n = (len - done) - (len - done) % _size;
+                    if (_put(src + done, n) != n) break;
+                    done += n;
+                    continue;
+                }
+                size_t room = _size - ((_offset + _len) % _size);
+                size_t n = len - done < room ? len - done : room;
+                memcpy(_buffer + _len, src + done, n);
+                _len += n;
+                done += n;
+                if (n == room) flush();
+            }
+            return done;
+        }
+
+        // Запись накопленных данных; false если ФС приняла не всё
+        bool flush() {
+            if (_len) {
+                _cacheCount(_cachePool().stats.flushes);
+                if (_put(_buffer, _len) != _len) _failed = true;
+                _len = 0;
+            }
+            return !_failed;
+        }
+
+    private:
+        size_t _put(const uint8_t* src, size_t len) {
+            size_t n = _write(_file, src, len);
+            _offset += n;
+            _cacheCount(_cachePool().stats.bytesWritten, n);
+            if (n != len) _failed = true;
+            return n;
+        }
+
+        File&    _file;
+        uint8_t* _buffer;
+        size_t   _size;
+        size_t   _len;
+        uint32_t _offset;       // позиция в файле начала накопленных данных
+        int8_t   _index;
+        bool     _failed;
+    };
+
+    /// @brief Вывод счётчиков блочного кэша
+    /// @param reset обнулить счётчики после вывода
+    inline void cachestat(bool reset = false) {
+        CachePool& p = _cachePool();
+        _cacheLock();
+        CacheStats s = p.stats;
+        if (reset) memset(&p.stats, 0, sizeof(p.stats));
+        _cacheUnlock();
+        uint32_t reads = s.hits + s.misses;
+        Serial.printf("cache: %u x %u bytes (%s%s)\n", p.count, p.blockSize,
+                      p.psram ? "PSRAM" : "internal", p.allocated ? "" : ", not allocated");
+        Serial.printf("  reads %lu, hits %lu (%lu%%), fills %lu, %lu bytes\n",
+                      (unsigned long)reads, (unsigned long)s.hits,
+                      (unsigned long)(reads ? (uint64_t)s.hits * 100 / reads : 0),
+                      (unsigned long)s.fills, (unsigned long)s.bytesRead);
+        Serial.printf("  flushes %lu, %lu bytes, pool empty %lu\n",
+                      (unsigned long)s.flushes, (unsigned long)s.bytesWritten, (unsigned long)s.poolEmpty);
+    }
+
+} // namespace Busybox
+
+#endif
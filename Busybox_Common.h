@@ -0,0 +1,126 @@
+#ifndef BUSYBOX_COMMON_H
+#define BUSYBOX_COMMON_H
+
+#include <Arduino.h>
+#include "Busybox_Config.h"
+
+// Общие типы для всех реализаций файловых систем
+
+// FS.h подключает реализация ФС; здесь хватает объявления
+namespace fs { class File; }
+
+// Суффиксы временных файлов атомарной записи: файл пишется в PATH.bbtmp, дописанный
+// переименовывается в PATH.bbnew (отметка готовности), затем заменяет PATH.
+// Суффиксы свои, чтобы fsck не трогал чужие *.tmp; длина обоих должна совпадать.
+#ifndef BUSYBOX_TMP_SUFFIX
+#define BUSYBOX_TMP_SUFFIX ".bbtmp"
+#endif
+#ifndef BUSYBOX_TMP_DONE_SUFFIX
+#define BUSYBOX_TMP_DONE_SUFFIX ".bbnew"
+#endif
+
+namespace Busybox {
+
+    // Информация о файловой системе (заполняется df)
+    struct FsInfo {
+        uint32_t totalBytes;
+        uint32_t usedBytes;
+        uint32_t freeBytes;
+    };
+
+    // Информация о файле/директории (заполняется stat)
+    struct FileStat {
+        uint32_t size;          // размер файла (0 для директорий)
+        uint32_t lastWrite;     // время последней записи, 0 если ФС не поддерживает
+        bool     isDir;
+    };
+
+    // Снимок системной информации (заполняется sysinfo).
+    // Поля, не поддерживаемые платформой, остаются нулевыми,
+    // так что раскладка структуры одинакова на ESP32 и ESP8266.
+    struct SysInfo {
+        uint32_t flashSize;
+        uint32_t flashSpeed;
+        uint32_t freeHeap;
+        uint32_t minFreeHeap;       // ESP32
+        uint32_t maxAllocHeap;
+        uint32_t psramSize;         // ESP32
+        uint32_t freePsram;         // ESP32
+        uint32_t maxAllocPsram;     // ESP32
+        uint32_t sketchSize;
+        uint32_t freeSketch;
+        uint32_t freeStack;         // ESP8266
+        uint32_t chipId;            // ESP8266
+        uint32_t cycleCount;
+        uint32_t uptimeMs;
+        uint16_t cpuFreqMHz;
+        uint16_t vcc;               // ESP8266, в единицах 1/1024 В
+        uint8_t  chipCores;         // ESP32
+        uint8_t  heapFragmentation; // %
+        uint8_t  flashMode;         // ESP8266
+        uint8_t  bootVersion;       // ESP8266
+        uint8_t  bootMode;          // ESP8266
+        uint8_t  resetReason;       // код причины сброса платформы
+    };
+
+    // Отображение содержимого файла в память (см. Busybox_Map.h)
+    struct MapView {
+        const uint8_t* data;
+        uint32_t       size;
+        uint8_t        slot;        // слот кэша или BUSYBOX_MAP_DIRECT для прямого отображения
+
+        explicit operator bool() const { return data != nullptr; }
+    };
+
+    inline MapView map(const char* path, bool cache = true);
+    inline void unmap(MapView& view);
+
+    // Пути упакованного образа ресурсов (см. Busybox_Pack.h)
+    inline bool _packOwns(const char* path);
+    inline void _packLs(const char* path);
+    inline void _packTree(const char* path, uint8_t levels, uint8_t indent);
+    inline bool _packStat(const char* path, FileStat& st);
+
+    // Кольцевой журнал для cat (см. Busybox_Ring.h)
+    inline bool _ringOwns(const char* path);
+    inline bool _ringOwns(fs::File& file);
+    inline bool _ringOwns(const MapView& view);
+    inline bool _ringCat(const char* path);
+
+    // Условия удаления по маске (см. Busybox_Rm.h); нулевые поля не ограничивают
+    struct RmFilter {
+        uint32_t minAge;        // не моложе, секунд с последней записи (нужны часы и время в ФС)
+        uint32_t minSize;       // не меньше, байт
+        uint32_t maxSize;       // не больше, байт
+        bool     dryRun;        // только подсчитать, не удалять
+    };
+
+    // Итоги удаления по маске
+    struct RmReport {
+        uint32_t matched;       // файлов подошло под маску и условия
+        uint32_t removed;       // удалено
+        uint32_t failed;        // не удалось удалить
+        uint32_t bytes;         // освобождено байт (размер удалённых файлов)
+    };
+
+    // Удаление по маске; rm(path) всегда удаляет путь буквально, даже с символами * ? [
+    inline uint32_t rmglob(const char* pattern, const RmFilter& filter = RmFilter(), RmReport* report = nullptr);
+
+    // Вид изменения для подписчиков (см. Busybox_Watch.h)
+    enum class ChangeOp : uint8_t {
+        Write,      // файл создан или перезаписан
+        Append,     // дописан в конец
+        Remove,     // удалён
+        MoveFrom,   // переименован: старый путь
+        MoveTo,     // переименован: новый путь
+        Mkdir,      // создана директория
+        Rmdir       // удалена директория
+    };
+
+    // Уведомление общих модулей об изменении файла командами Busybox
+    // (bytes — сколько байт записано, 0 для удаления/переименования)
+    inline void _touched(const char* path, uint32_t bytes = 0, ChangeOp op = ChangeOp::Write);
+
+} // namespace Busybox
+
+#endif
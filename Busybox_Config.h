@@ -0,0 +1,52 @@
+#ifndef BUSYBOX_CONFIG_H
+#define BUSYBOX_CONFIG_H
+
+// Выбор команд при сборке.
+// Маска BUSYBOX_COMMANDS задаётся в скетче ПЕРЕД подключением библиотеки; команды,
+// не попавшие в маску, не компилируются вовсе. Базовые команды (begin, format, stat,
+// df, rm, mv, cp, write, append, mkdir, rmdir, rmrf, map, кэш) доступны всегда.
+//
+//     #define BUSYBOX_COMMANDS (BUSYBOX_CMD_LS | BUSYBOX_CMD_CAT)
+//     #include <Busybox.h>
+
+#define BUSYBOX_CMD_LS          (1UL << 0)      // ls, ls(path, LsOpts)
+#define BUSYBOX_CMD_TREE        (1UL << 1)      // tree
+#define BUSYBOX_CMD_CAT         (1UL << 2)      // cat
+#define BUSYBOX_CMD_DUMP        (1UL << 3)      // dump, dump(path, DumpMode)
+#define BUSYBOX_CMD_VIEW        (1UL << 4)      // view, view1
+#define BUSYBOX_CMD_SYSINFO     (1UL << 5)      // sysinfo
+#define BUSYBOX_CMD_HEAPPROF    (1UL << 6)      // heapprof
+#define BUSYBOX_CMD_TOP         (1UL << 7)      // top
+#define BUSYBOX_CMD_BENCH       (1UL << 8)      // fsbench
+#define BUSYBOX_CMD_ASYNC       (1UL << 9)      // очередь фоновых команд
+#define BUSYBOX_CMD_PACK        (1UL << 10)     // упакованный образ ресурсов
+#define BUSYBOX_CMD_WEAR        (1UL << 11)     // отчёт wear (учёт записи — BUSYBOX_WEAR)
+#define BUSYBOX_CMD_FSCK        (1UL << 12)     // fsck
+#define BUSYBOX_CMD_SNAPSHOT    (1UL << 13)     // snapshot, diff
+#define BUSYBOX_CMD_DELTA       (1UL << 14)     // cp(src, dst, CpMode): delta, конвейер, между ФС
+#define BUSYBOX_CMD_KV          (1UL << 15)     // хранилище ключ-значение KV
+#define BUSYBOX_CMD_RING        (1UL << 16)     // кольцевой журнал RingFile, tail
+#define BUSYBOX_CMD_RECLOG      (1UL << 17)     // журнал записей RecordLog, query
+#define BUSYBOX_CMD_TEXT        (1UL << 18)     // wc, uniq, sort
+#define BUSYBOX_CMD_WATCH       (1UL << 19)     // события изменений Watcher
+#define BUSYBOX_CMD_PART        (1UL << 20)     // part, partdump, partrestore, coredump (ESP32)
+
+#define BUSYBOX_CMD_ALL         0xFFFFFFFFUL
+
+#ifndef BUSYBOX_COMMANDS
+#define BUSYBOX_COMMANDS BUSYBOX_CMD_ALL
+#endif
+
+// Проверка в препроцессоре: #if BUSYBOX_HAS(CAT)
+#define BUSYBOX_HAS(cmd) ((BUSYBOX_COMMANDS & BUSYBOX_CMD_##cmd) != 0)
+
+namespace Busybox {
+
+    // Проверка в коде скетча: if constexpr (Busybox::hasCommand(BUSYBOX_CMD_CAT))
+    constexpr bool hasCommand(unsigned long cmd) {
+        return (BUSYBOX_COMMANDS & cmd) != 0;
+    }
+
+} // namespace Busybox
+
+#endif
@@ -0,0 +1,364 @@
+#ifndef BUSYBOX_COPY_H
+#define BUSYBOX_COPY_H
+
+#include "Busybox_Common.h"
+
+// Режимы копирования поверх cp из реализации ФС.
+//
+// Delta: источник и приёмник сравниваются поблочно, перезаписываются только
+// отличающиеся блоки. Оба файла локальные, поэтому блоки сравниваются напрямую
+// (memcmp): контрольные суммы нужны, когда одна из сторон удалённая, а сдвинутые
+// данные при записи на месте всё равно пришлось бы переписать до конца файла.
+// Если размеры различаются, выполняется обычное копирование.
+//
+// LittleFS хранит файл как список блоков с обратными ссылками, поэтому при
+// изменении блока перезаписывается и весь хвост файла после него; выигрыш
+// тем больше, чем ближе к концу файла изменения. FAT и SPIFFS перезаписывают
+// только изменённые сектора/страницы.
+//
+// Pipelined: чтение и запись идут параллельно. На двухъядерном ESP32 источник
+// читает отдельная задача на другом ядре, задачи обмениваются двумя буферами
+// через очереди FreeRTOS: пока один буфер записывается, второй заполняется.
+// Время копирования приближается ко времени более медленной стороны, а не к
+// сумме задержек чтения и записи. Больше всего выигрыш при копировании между
+// разными носителями (SD/FFat -> LittleFS); в пределах одной SPI flash запись
+// и стирание на время операции останавливают оба ядра, и параллельно идёт
+// только работа драйверов ФС. На одноядерных ESP32-S2/C3 и ESP8266 второе ядро
+// не даёт выигрыша, и копирование выполняется последовательно.
+
+// Размер каждого из двух буферов конвейера
+#ifndef BUSYBOX_CP_PIPE_BLOCK
+#define BUSYBOX_CP_PIPE_BLOCK 4096
+#endif
+
+// Стек задачи чтения
+#ifndef BUSYBOX_CP_PIPE_STACK
+#define BUSYBOX_CP_PIPE_STACK 3072
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32) && !defined(CONFIG_FREERTOS_UNICORE) && portNUM_PROCESSORS > 1
+#define BUSYBOX_CP_PIPE_TASK 1
+#else
+#define BUSYBOX_CP_PIPE_TASK 0
+#endif
+
+namespace Busybox {
+
+    enum class CpMode : uint8_t {
+        Full,       // обычное копирование
+        Delta,      // перезапись только отличающихся блоков
+        Pipelined   // чтение и запись параллельно на разных ядрах
+    };
+
+    // Итоги копирования
+    struct CpReport {
+        uint32_t written;       // записано байт
+        uint32_t skipped;       // байт, совпавших с приёмником
+        uint32_t blocks;        // перезаписано блоков
+        uint32_t firstChange;   // смещение первого изменённого блока (0xFFFFFFFF — изменений нет)
+        bool     full;          // выполнено полное копирование
+        uint32_t us;            // длительность копирования
+        uint32_t waitUs;        // Pipelined: запись ждала данных от чтения
+    };
+
+    // Поблочное сравнение и перезапись; false если нужна полная копия или произошла ошибка
+    inline bool _cpDelta(fs::FS& sourceFs, const char* sourcePath, fs::FS& destFs, const char* destPath,
+                         CpReport& r, bool& fallback) {
+        // Отображение есть только у файлов основной ФС
+        MapView view = {nullptr, 0, 0};
+        if (&sourceFs == &BUSYBOX_FS) view = map(sourcePath, false);
+        File source;
+        uint32_t size;
+        if (view) {
+            size = view.size;
+        } else {
+            source = _open(sourceFs, sourcePath, "r");
+            if (!source) {
+                Serial.printf("cp: cannot open source '%s'\n", sourcePath);
+                return false;
+            }
+            size = source.size();
+        }
+
+        File dest = _open(destFs, destPath, "r");
+        if (!dest || dest.isDirectory() || dest.size() != size) {
+            // Приёмника нет или размер другой: полное копирование
+            dest.close();
+            source.close();
+            unmap(view);
+            fallback = true;
+            return false;
+        }
+        dest.close();
+        dest = _open(destFs, destPath, "r+");
+        if (!dest) {
+            Serial.printf("cp: cannot open '%s' for update\n", destPath);
+            source.close();
+            unmap(view);
+            return false;
+        }
+
+        uint8_t smallA[128];
+        uint8_t smallB[128];
+        CacheBlock blockA(smallA, sizeof(smallA));
+        CacheBlock blockB(smallB, sizeof(smallB));
+        size_t blockSize = blockA.size < blockB.size ? blockA.size : blockB.size;
+
+        bool ok = true;
+        uint32_t pos = 0;
+        while (pos < size) {
+            size_t n = size - pos < blockSize ? size - pos : blockSize;
+            const uint8_t* src = view ? view.data + pos : blockA.data;
+            if ((!view && _read(source, blockA.data, n) != n) || _read(dest, blockB.data, n) != n) {
+                ok = false;
+                break;
+            }
+            if (memcmp(src, blockB.data, n) == 0) {
+                r.skipped += n;
+            } else {
+                if (r.firstChange == 0xFFFFFFFF) r.firstChange = pos;
+                if (!dest.seek(pos) || _write(dest, src, n) != n) {
+                    ok = false;
+                    break;
+                }
+                r.written += n;
+                r.blocks++;
+            }
+            pos += n;
+            yield();
+        }
+
+        source.close();
+        dest.close();
+        unmap(view);
+        if (!ok) Serial.printf("cp: update of '%s' failed at offset %lu\n", destPath, (unsigned long)pos);
+        return ok;
+    }
+
+    // Буфер конвейера: длина данных (0 — конец файла) и время чтения
+    struct CpPipeSlot {
+        uint32_t len;
+        uint32_t us;
+    };
+
+    // Состояние конвейера. Очереди создаются один раз и не удаляются: задача
+    // чтения может ещё находиться внутри xQueueSend, когда запись уже получила
+    // последний буфер.
+    struct CpPipe {
+        File*         source;
+        uint8_t*      buffers[2];
+        CpPipeSlot    slots[2];
+        volatile bool abort;
+#if BUSYBOX_CP_PIPE_TASK
+        QueueHandle_t empty;        // свободные буферы: запись -> чтение
+        QueueHandle_t filled;       // заполненные буферы: чтение -> запись
+        SemaphoreHandle_t busy;     // конвейер один на всю программу
+#endif
+    };
+
+    inline CpPipe& _cpPipe() {
+        static CpPipe pipe = [] {
+            CpPipe p = {};
+#if BUSYBOX_CP_PIPE_TASK
+            p.empty = xQueueCreate(2, sizeof(uint8_t));
+            p.filled = xQueueCreate(2, sizeof(uint8_t));
+            p.busy = xSemaphoreCreateMutex();
+#endif
+            return p;
+        }();
+        return pipe;
+    }
+
+    // Заполнение буфера i из источника
+    inline void _cpFill(CpPipe& p, uint8_t i) {
+        if (p.abort) {
+            p.slots[i].len = 0;
+            return;
+        }
+        // Статистика чтения учитывается в задаче записи: таблица статистики
+        // не рассчитана на одновременное обновление из двух задач
+        uint32_t t0 = micros();
+        p.slots[i].len = p.source->read(p.buffers[i], BUSYBOX_CP_PIPE_BLOCK);
+        p.slots[i].us = micros() - t0;
+    }
+
+#if BUSYBOX_CP_PIPE_TASK
+
+    inline void _cpReader(void*) {
+        CpPipe& p = _cpPipe();
+        uint8_t i;
+        while (xQueueReceive(p.empty, &i, portMAX_DELAY) == pdTRUE) {
+            _cpFill(p, i);
+            bool last = p.slots[i].len == 0;
+            xQueueSend(p.filled, &i, portMAX_DELAY);
+            if (last) break;
+        }
+        vTaskDelete(nullptr);
+    }
+
+    // Конвейерная запись; false если конвейер занят или задачу не удалось запустить
+    inline bool _cpPipeRun(CpPipe& p, File& dest, CpReport& r) {
+        xQueueReset(p.empty);
+        xQueueReset(p.filled);
+        uint8_t i = 0;
+        xQueueSend(p.empty, &i, 0);
+        i = 1;
+        xQueueSend(p.empty, &i, 0);
+
+        // Чтение — на другом ядре с тем же приоритетом, что у вызывающей задачи
+        BaseType_t core = xPortGetCoreID() ? 0 : 1;
+        if (xTaskCreatePinnedToCore(_cpReader, "bb-cp", BUSYBOX_CP_PIPE_STACK, nullptr,
+                                    uxTaskPriorityGet(nullptr), nullptr, core) != pdPASS) {
+            return false;
+        }
+
+        while (true) {
+            uint32_t t0 = micros();
+            xQueueReceive(p.filled, &i, portMAX_DELAY);
+            r.waitUs += micros() - t0;
+            CpPipeSlot slot = p.slots[i];
+            if (!slot.len) break;
+#ifdef BUSYBOX_STATS
+            _statsOp(OP_READ, slot.us, slot.len);
+#endif
+            // После ошибки записи буферы возвращаются, пока чтение не завершится
+            if (!p.abort) {
+                if (_write(dest, p.buffers[i], slot.len) == slot.len) {
+                    r.written += slot.len;
+                } else {
+                    p.abort = true;
+                }
+            }
+            xQueueSend(p.empty, &i, portMAX_DELAY);
+        }
+        return true;
+    }
+
+#endif
+
+    // Потоковое копирование между любыми ФС: конвейером, если он доступен, иначе последовательно
+    inline bool _cpStream(fs::FS& sourceFs, const char* sourcePath, fs::FS& destFs, const char* destPath,
+                          bool pipelined, CpReport& r) {
+        File source = _open(sourceFs, sourcePath, "r");
+        if (!source || source.isDirectory()) {
+            Serial.printf("cp: cannot open source '%s'\n", sourcePath);
+            return false;
+        }
+        File dest = _open(destFs, destPath, "w");
+        if (!dest) {
+            Serial.printf("cp: cannot create '%s'\n", destPath);
+            source.close();
+            return false;
+        }
+        uint32_t size = source.size();
+
+        bool piped = false;
+        bool failed = false;
+#if BUSYBOX_CP_PIPE_TASK
+        CpPipe& p = _cpPipe();
+        if (pipelined && xSemaphoreTake(p.busy, 0) == pdTRUE) {
+            p.buffers[0] = _cacheAlloc(BUSYBOX_CP_PIPE_BLOCK, false);
+            p.buffers[1] = _cacheAlloc(BUSYBOX_CP_PIPE_BLOCK, false);
+            p.source = &source;
+            p.abort = false;
+            if (p.buffers[0] && p.buffers[1]) piped = _cpPipeRun(p, dest, r);
+            failed = piped && p.abort;
+            free(p.buffers[0]);
+            free(p.buffers[1]);
+            p.buffers[0] = p.buffers[1] = nullptr;
+            p.source = nullptr;
+            xSemaphoreGive(p.busy);
+        }
+#endif
+
+        if (!piped) {
+            BlockReader reader(source);
+            BlockWriter writer(dest);
+            size_t bytesRead;
+            while (const uint8_t* buffer = reader.next(bytesRead)) {
+                if (writer.write(buffer, bytesRead) != bytesRead) break;
+            }
+            // Принятое writer ещё может не дойти до ФС: считается только записанное
+            failed = !writer.flush();
+            r.written = dest.position();
+        }
+
+        source.close();
+        dest.close();
+        if (&destFs == &BUSYBOX_FS) _touched(destPath, r.written);
+
+        bool ok = !failed && r.written == size;
+        if (!ok) {
+            Serial.printf("cp: copy of '%s' failed at offset %lu\n", sourcePath, (unsigned long)r.written);
+        }
+        return ok;
+    }
+
+    /// @brief Копирование файла между файловыми системами в заданном режиме
+    /// @param sourceFs ФС источника (LittleFS, FFat, SD, ...)
+    /// @param sourcePath источник
+    /// @param destFs ФС приёмника
+    /// @param destPath приёмник
+    /// @param mode Full — последовательно, Delta — перезапись только изменённых блоков,
+    ///        Pipelined — чтение и запись параллельно на разных ядрах
+    /// @param report если не nullptr, сюда копируются итоги
+    inline bool cp(fs::FS& sourceFs, const char* sourcePath, fs::FS& destFs, const char* destPath,
+                   CpMode mode = CpMode::Full, CpReport* report = nullptr) {
+        CommandScope _scope("cp");
+        WriteLock _lock;
+        CpReport r = {0, 0, 0, 0xFFFFFFFF, false, 0, 0};
+        uint32_t t0 = micros();
+        bool local = &sourceFs == &BUSYBOX_FS && &destFs == &BUSYBOX_FS;
+        bool ok = false;
+        bool fallback = mode != CpMode::Delta;
+
+        if (mode == CpMode::Delta) {
+            ok = _cpDelta(sourceFs, sourcePath, destFs, destPath, r, fallback);
+            if (r.written && &destFs == &BUSYBOX_FS) _touched(destPath, r.written);
+            if (ok) {
+                Serial.printf("cp: '%s' -> '%s' (delta: %lu written in %lu blocks, %lu skipped)\n",
+                              sourcePath, destPath, (unsigned long)r.written, (unsigned long)r.blocks,
+                              (unsigned long)r.skipped);
+            }
+        }
+
+        if (fallback) {
+            r = {0, 0, 0, 0, true, 0, 0};
+            if (local && mode != CpMode::Pipelined) {
+                // Основная ФС: обычный cp, который умеет копировать из отображения
+                ok = cp(sourcePath, destPath);
+                File dest = _open(BUSYBOX_FS, destPath, "r");
+                r.written = dest ? dest.size() : 0;
+            } else {
+                ok = _cpStream(sourceFs, sourcePath, destFs, destPath, mode == CpMode::Pipelined, r);
+                uint32_t us = micros() - t0;
+                if (ok) {
+                    Serial.printf("cp: '%s' -> '%s' (%lu bytes, %lu KB/s",
+                                  sourcePath, destPath, (unsigned long)r.written,
+                                  (unsigned long)(us ? (uint64_t)r.written * 1000000 / 1024 / us : 0));
+                    if (mode == CpMode::Pipelined) {
+                        Serial.printf(", write waited %lu ms", (unsigned long)(r.waitUs / 1000));
+                    }
+                    Serial.printf(")\n");
+                }
+            }
+        }
+
+        r.us = micros() - t0;
+        if (report) *report = r;
+        return ok;
+    }
+
+    /// @brief Копирование файла в заданном режиме
+    /// @param sourcePath источник
+    /// @param destPath приёмник
+    /// @param mode Full — как cp(src, dst), Delta — перезапись только изменённых блоков,
+    ///        Pipelined — чтение и запись параллельно на разных ядрах
+    /// @param report если не nullptr, сюда копируются итоги
+    inline bool cp(const char* sourcePath, const char* destPath, CpMode mode, CpReport* report = nullptr) {
+        return cp(BUSYBOX_FS, sourcePath, BUSYBOX_FS, destPath, mode, report);
+    }
+
+} // namespace Busybox
+
+#endif
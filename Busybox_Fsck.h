@@ -0,0 +1,187 @@
+#ifndef BUSYBOX_FSCK_H
+#define BUSYBOX_FSCK_H
+
+#include "Busybox_Common.h"
+#include "Busybox_Util.h"
+#include "Busybox_Walk.h"
+
+// Проверка целостности файловой системы.
+// Обход дерева через TreeWalker (Busybox_Walk.h), так что расход памяти
+// ограничен глубиной BUSYBOX_WALK_DEPTH и длиной пути BUSYBOX_WALK_PATH.
+// Каждый файл читается до конца и сверяется с размером из директории.
+// Временные файлы атомарной записи Busybox, оставшиеся после сбоя, в режиме
+// Repair исправляются: недописанный PATH.bbtmp удаляется, дописанный PATH.bbnew
+// (см. _tmpCommit) заменяет PATH. Другие файлы, в том числе *.tmp, не трогаются.
+// Обход использует только интерфейс fs::FS, поэтому fsck можно запустить
+// и для другой ФС (SD, FFat рядом с LittleFS, образ в RAM на компьютере).
+// Блокировка и уведомления _touched относятся только к BUSYBOX_FS.
+
+// Число временных файлов, исправляемых за один проход
+#ifndef BUSYBOX_FSCK_ORPHANS
+#define BUSYBOX_FSCK_ORPHANS 4
+#endif
+
+namespace Busybox {
+
+    enum class FsckMode : uint8_t {
+        Check,      // только отчёт
+        Repair      // исправить временные файлы
+    };
+
+    // Итоги проверки
+    struct FsckReport {
+        uint32_t dirs;
+        uint32_t files;
+        uint32_t bytes;         // прочитано байт
+        uint32_t errors;        // файлы, которые не открываются или читаются не полностью
+        uint32_t skipped;       // слишком глубокие директории и длинные пути
+        uint32_t orphans;       // найдено временных файлов
+        uint32_t repaired;      // исправлено временных файлов
+    };
+
+    // Вызывается после проверки каждого файла
+    typedef void (*FsckProgress)(const char* path, const FsckReport& report, void* arg);
+
+    struct FsckState {
+        char       orphans[BUSYBOX_FSCK_ORPHANS][BUSYBOX_WALK_PATH];
+        uint8_t    orphanCount;
+        FsckReport report;
+    };
+
+    inline bool _fsckHasSuffix(const char* name, const char* suffix) {
+        size_t n = strlen(name);
+        size_t s = strlen(suffix);
+        return n > s && strcmp(name + n - s, suffix) == 0;
+    }
+
+    inline bool _fsckIsTemp(const char* name) {
+        return _fsckHasSuffix(name, BUSYBOX_TMP_SUFFIX) || _fsckHasSuffix(name, BUSYBOX_TMP_DONE_SUFFIX);
+    }
+
+    // Чтение файла до конца; false если прочитано не столько, сколько указано в директории
+    inline bool _fsckRead(File& file, FsckReport& report) {
+        uint32_t size = file.size();
+        uint32_t total = 0;
+        BlockReader reader(file);
+        size_t len;
+        while (reader.next(len)) {
+            total += len;
+            yield();
+        }
+        report.bytes += total;
+        return total == size;
+    }
+
+    // Временный файл: недописанный удаляется, дописанный заменяет основной
+    inline bool _fsckRepair(fs::FS& fs, const char* temp) {
+        // Кэш map(), учёт износа и Watcher знают только пути BUSYBOX_FS
+        bool own = &fs == &BUSYBOX_FS;
+        if (_fsckHasSuffix(temp, BUSYBOX_TMP_SUFFIX)) {
+            Serial.printf("fsck: removing incomplete '%s'\n", temp);
+            if (!_remove(fs, temp)) return false;
+            if (own) _touched(temp, 0, ChangeOp::Remove);
+            return true;
+        }
+        char target[BUSYBOX_WALK_PATH];
+        size_t n = strlen(temp) - strlen(BUSYBOX_TMP_DONE_SUFFIX);
+        memcpy(target, temp, n);
+        target[n] = '\0';
+        Serial.printf("fsck: restoring '%s' -> '%s'\n", temp, target);
+        if (fs.exists(target) && !_remove(fs, target)) return false;
+        if (!_rename(fs, temp, target)) return false;
+        if (own) {
+            _touched(temp, 0, ChangeOp::MoveFrom);
+            _touched(target, 0, ChangeOp::MoveTo);
+        }
+        return true;
+    }
+
+    inline void _fsckWalk(fs::FS& fs, const char* root, FsckMode mode, FsckState& st,
+                   FsckProgress progress, void* arg) {
+        FsckReport& r = st.report;
+        TreeWalker walker(fs, "fsck");
+        if (!walker.begin(root)) {
+            Serial.printf("fsck: cannot open directory '%s'\n", root);
+            r.errors++;
+            return;
+        }
+
+        while (File entry = walker.next()) {
+            const char* path = walker.path();
+            r.files++;
+            if (!_fsckRead(entry, r)) {
+                Serial.printf("fsck: '%s' is shorter than %u bytes\n", path, (unsigned)entry.size());
+                r.errors++;
+            }
+            entry.close();
+
+            if (_fsckIsTemp(walker.name())) {
+                r.orphans++;
+                Serial.printf("fsck: orphaned temp file '%s'\n", path);
+                // Исправление откладывается до конца обхода: директории сейчас открыты
+                if (mode == FsckMode::Repair && st.orphanCount < BUSYBOX_FSCK_ORPHANS) {
+                    strcpy(st.orphans[st.orphanCount++], path);
+                }
+            }
+
+            if (progress) progress(path, r, arg);
+        }
+        r.dirs = walker.dirs;
+        r.skipped = walker.skipped;
+    }
+
+    // Обход и, в режиме Repair, исправление временных файлов
+    inline void _fsckRun(fs::FS& fs, const char* root, FsckMode mode, FsckState& st,
+                  FsckProgress progress, void* arg) {
+        _fsckWalk(fs, root, mode, st, progress, arg);
+        for (uint8_t i = 0; i < st.orphanCount; i++) {
+            if (_fsckRepair(fs, st.orphans[i])) st.report.repaired++;
+        }
+    }
+
+    /// @brief Проверка целостности ФС
+    /// @param fs файловая система
+    /// @param mode Check — только отчёт, Repair — исправить временные файлы
+    /// @param progress вызывается после каждого файла (может быть nullptr)
+    /// @param arg аргумент для progress
+    /// @param report если не nullptr, сюда копируются итоги
+    /// @return true если ошибок нет и не осталось временных файлов
+    inline bool fsck(fs::FS& fs, FsckMode mode = FsckMode::Check, FsckProgress progress = nullptr,
+              void* arg = nullptr, FsckReport* report = nullptr, const char* root = "/") {
+        CommandScope _scope("fsck");
+        FsckState st = {};
+
+        if (&fs != &BUSYBOX_FS) {
+            // Блокировка Busybox защищает только BUSYBOX_FS
+            _fsckRun(fs, root, mode, st, progress, arg);
+        } else if (mode == FsckMode::Repair) {
+            WriteLock _lock;
+            _fsckRun(fs, root, mode, st, progress, arg);
+        } else {
+            ReadLock _lock;
+            _fsckRun(fs, root, mode, st, progress, arg);
+        }
+
+        const FsckReport& r = st.report;
+        Serial.printf("fsck: %lu dirs, %lu files, %lu bytes, %lu errors, %lu skipped, %lu orphans",
+                      (unsigned long)r.dirs, (unsigned long)r.files, (unsigned long)r.bytes,
+                      (unsigned long)r.errors, (unsigned long)r.skipped, (unsigned long)r.orphans);
+        if (mode == FsckMode::Repair) Serial.printf(" (%lu repaired)", (unsigned long)r.repaired);
+        Serial.println();
+        if (mode == FsckMode::Repair && r.repaired < r.orphans) {
+            Serial.println("fsck: not all temp files were repaired, run again");
+        }
+
+        if (report) *report = r;
+        return r.errors == 0 && r.orphans == r.repaired;
+    }
+
+    /// @brief Проверка целостности смонтированной ФС Busybox
+    inline bool fsck(FsckMode mode = FsckMode::Check, FsckProgress progress = nullptr, void* arg = nullptr,
+              FsckReport* report = nullptr) {
+        return fsck(BUSYBOX_FS, mode, progress, arg, report);
+    }
+
+} // namespace Busybox
+
+#endif
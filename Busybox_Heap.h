@@ -0,0 +1,210 @@
+#ifndef BUSYBOX_HEAP_H
+#define BUSYBOX_HEAP_H
+
+#include "Busybox_Common.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_heap_caps.h>
+#endif
+
+// Глубина кольцевого буфера выборок heapprof
+#ifndef BUSYBOX_HEAPPROF_DEPTH
+#define BUSYBOX_HEAPPROF_DEPTH 32
+#endif
+
+// Число корзин гистограммы фрагментации (по 100/N процентов)
+#define BUSYBOX_HEAPPROF_BUCKETS 10
+
+namespace Busybox {
+
+    // Режим работы heapprof
+    enum class HeapProf : uint8_t {
+        Sample,     // только сделать выборку
+        Report,     // сделать выборку и вывести отчёт
+        Reset       // очистить накопленную статистику
+    };
+
+    // Типы памяти, которые отслеживает профилировщик
+    enum HeapCap : uint8_t {
+        HEAP_INTERNAL,
+        HEAP_PSRAM,
+        HEAP_DMA,
+        HEAP_CAP_COUNT
+    };
+
+    // Состояние одного типа памяти в момент выборки
+    struct HeapSample {
+        uint32_t freeBytes;
+        uint32_t largestBlock;
+        uint32_t minFree;       // минимум свободной памяти с момента загрузки
+        uint32_t freeBlocks;    // число свободных блоков (0 если неизвестно)
+    };
+
+    struct HeapProfile {
+        uint32_t   ms[BUSYBOX_HEAPPROF_DEPTH];
+        HeapSample samples[BUSYBOX_HEAPPROF_DEPTH][HEAP_CAP_COUNT];
+        uint16_t   histogram[HEAP_CAP_COUNT][BUSYBOX_HEAPPROF_BUCKETS];
+        uint32_t   lowWater[HEAP_CAP_COUNT];      // минимум largestBlock за всё время
+        uint32_t   total;                         // всего выборок с последнего Reset
+        uint16_t   head;                          // индекс следующей записи
+        uint16_t   count;                         // выборок в кольце
+    };
+
+    // Накопленная статистика профилировщика (одна на программу)
+    inline HeapProfile& _heapprof() {
+        static HeapProfile profile = {};
+        return profile;
+    }
+
+    inline const char* _heapCapName(uint8_t cap) {
+        switch (cap) {
+            case HEAP_INTERNAL: return "Internal";
+            case HEAP_PSRAM:    return "PSRAM";
+            case HEAP_DMA:      return "DMA";
+            default:            return "?";
+        }
+    }
+
+    // Фрагментация в процентах: доля свободной памяти, недоступная одним блоком
+    inline uint8_t _heapFrag(const HeapSample& s) {
+        if (s.freeBytes == 0) return 0;
+        return 100 - (uint8_t)((uint64_t)s.largestBlock * 100 / s.freeBytes);
+    }
+
+    // Снять состояние одного типа памяти
+    inline bool _heapSample(uint8_t cap, HeapSample& s) {
+        memset(&s, 0, sizeof(s));
+#if defined(ARDUINO_ARCH_ESP32)
+        uint32_t caps = cap == HEAP_PSRAM ? MALLOC_CAP_SPIRAM :
+                        cap == HEAP_DMA   ? MALLOC_CAP_DMA :
+                                            MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT;
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, caps);
+        if (info.total_free_bytes == 0 && info.total_allocated_bytes == 0) return false;
+        s.freeBytes    = info.total_free_bytes;
+        s.largestBlock = info.largest_free_block;
+        s.minFree      = info.minimum_free_bytes;
+        s.freeBlocks   = info.free_blocks;
+        return true;
+#elif defined(ARDUINO_ARCH_ESP8266)
+        if (cap != HEAP_INTERNAL) return false;
+        uint32_t freeBytes;
+        uint32_t largest;
+        uint8_t  frag;
+        ESP.getHeapStats(&freeBytes, &largest, &frag);
+        s.freeBytes    = freeBytes;
+        s.largestBlock = largest;
+        // ESP8266 не хранит минимум, считаем его по своим выборкам
+        HeapProfile& p = _heapprof();
+        uint32_t prevMin = p.count ? p.samples[(p.head + BUSYBOX_HEAPPROF_DEPTH - 1) % BUSYBOX_HEAPPROF_DEPTH][cap].minFree : freeBytes;
+        s.minFree      = freeBytes < prevMin ? freeBytes : prevMin;
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    // Добавить выборку по всем типам памяти в кольцевой буфер
+    inline void _heapprofSample() {
+        HeapProfile& p = _heapprof();
+        if (p.total == 0) {
+            for (uint8_t cap = 0; cap < HEAP_CAP_COUNT; cap++) p.lowWater[cap] = UINT32_MAX;
+        }
+
+        HeapSample* row = p.samples[p.head];
+        for (uint8_t cap = 0; cap < HEAP_CAP_COUNT; cap++) {
+            if (!_heapSample(cap, row[cap])) continue;
+
+            uint8_t bucket = _heapFrag(row[cap]) * BUSYBOX_HEAPPROF_BUCKETS / 100;
+            if (bucket >= BUSYBOX_HEAPPROF_BUCKETS) bucket = BUSYBOX_HEAPPROF_BUCKETS - 1;
+            if (p.histogram[cap][bucket] < UINT16_MAX) p.histogram[cap][bucket]++;
+
+            if (row[cap].largestBlock < p.lowWater[cap]) p.lowWater[cap] = row[cap].largestBlock;
+        }
+        p.ms[p.head] = millis();
+
+        p.head = (p.head + 1) % BUSYBOX_HEAPPROF_DEPTH;
+        if (p.count < BUSYBOX_HEAPPROF_DEPTH) p.count++;
+        p.total++;
+    }
+
+    // Вывод отчёта по накопленным выборкам
+    inline void _heapprofReport() {
+        HeapProfile& p = _heapprof();
+        if (p.count == 0) {
+            Serial.println("heapprof: no samples");
+            return;
+        }
+
+        uint16_t first = (p.head + BUSYBOX_HEAPPROF_DEPTH - p.count) % BUSYBOX_HEAPPROF_DEPTH;
+        uint16_t last = (p.head + BUSYBOX_HEAPPROF_DEPTH - 1) % BUSYBOX_HEAPPROF_DEPTH;
+
+        Serial.printf("=== Heap Profile: %u samples, window %lu s ===\n",
+                      p.total, (unsigned long)((p.ms[last] - p.ms[first]) / 1000));
+        Serial.println("Heap      Free      Largest   MinFree   LowWater  Blocks  Frag");
+
+        for (uint8_t cap = 0; cap < HEAP_CAP_COUNT; cap++) {
+            const HeapSample& s = p.samples[last][cap];
+            if (s.freeBytes == 0 && s.largestBlock == 0) continue;
+            Serial.printf("%-9s %-9u %-9u %-9u %-9u %-7u %u%%\n", _heapCapName(cap),
+                          s.freeBytes, s.largestBlock, s.minFree, p.lowWater[cap],
+                          s.freeBlocks, _heapFrag(s));
+        }
+
+        // Тренд за окно кольцевого буфера
+        Serial.println("=== Trend (window) ===");
+        for (uint8_t cap = 0; cap < HEAP_CAP_COUNT; cap++) {
+            const HeapSample& a = p.samples[first][cap];
+            const HeapSample& b = p.samples[last][cap];
+            if (b.freeBytes == 0 && b.largestBlock == 0) continue;
+
+            uint32_t minLargest = UINT32_MAX;
+            for (uint16_t i = 0; i < p.count; i++) {
+                uint32_t largest = p.samples[(first + i) % BUSYBOX_HEAPPROF_DEPTH][cap].largestBlock;
+                if (largest < minLargest) minLargest = largest;
+            }
+            Serial.printf("%-9s free %+ld, largest %+ld, min largest %u\n", _heapCapName(cap),
+                          (long)b.freeBytes - (long)a.freeBytes,
+                          (long)b.largestBlock - (long)a.largestBlock, minLargest);
+        }
+
+        // Гистограмма фрагментации за всё время
+        Serial.println("=== Fragmentation histogram ===");
+        for (uint8_t cap = 0; cap < HEAP_CAP_COUNT; cap++) {
+            uint32_t sum = 0;
+            for (uint8_t i = 0; i < BUSYBOX_HEAPPROF_BUCKETS; i++) sum += p.histogram[cap][i];
+            if (sum == 0) continue;
+
+            Serial.printf("%s:\n", _heapCapName(cap));
+            for (uint8_t i = 0; i < BUSYBOX_HEAPPROF_BUCKETS; i++) {
+                uint16_t n = p.histogram[cap][i];
+                Serial.printf("  %3u-%3u%% %6u ", i * 100 / BUSYBOX_HEAPPROF_BUCKETS,
+                              (i + 1) * 100 / BUSYBOX_HEAPPROF_BUCKETS - 1, n);
+                uint8_t bar = (uint32_t)n * 40 / sum;
+                for (uint8_t j = 0; j < bar; j++) Serial.print('#');
+                Serial.println();
+            }
+        }
+    }
+
+    // Профилировщик фрагментации кучи.
+    // Вызывайте периодически с HeapProf::Sample (например, раз в секунду из loop),
+    // отчёт — HeapProf::Report.
+    inline void heapprof(HeapProf mode = HeapProf::Report) {
+        switch (mode) {
+            case HeapProf::Sample:
+                _heapprofSample();
+                break;
+            case HeapProf::Report:
+                _heapprofSample();
+                _heapprofReport();
+                break;
+            case HeapProf::Reset:
+                memset(&_heapprof(), 0, sizeof(HeapProfile));
+                break;
+        }
+    }
+
+} // namespace Busybox
+
+#endif
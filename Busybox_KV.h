@@ -0,0 +1,495 @@
+#ifndef BUSYBOX_KV_H
+#define BUSYBOX_KV_H
+
+#include "Busybox_Common.h"
+#include "Busybox_Util.h"
+
+// Хранилище ключ-значение в одном файле-журнале.
+//
+// Журнал (little-endian):
+//   KVHeader
+//   записи: KVRecord; char key[keyLen]; uint8_t value[valueLen]
+//
+// Изменение ключа дописывает запись в конец журнала, удаление — запись с флагом
+// KV_DELETED. Запись не перезаписывает файл целиком, как write(), а добавляет
+// несколько десятков байт в хвостовой блок. CRC-32 записи покрывает заголовок
+// (кроме самого CRC), ключ и значение. Недописанная при потере питания запись
+// в конце журнала не проходит проверку и отбрасывается при открытии.
+//
+// В памяти хранится хеш-таблица {hash ключа, смещение записи} на
+// BUSYBOX_KV_SLOTS ключей (8 байт на слот), она строится при открытии одним
+// проходом по журналу. Для чтения записей хранилище держит один открытый файл
+// журнала: get() читает значение через него прямо в буфер вызывающего, без
+// открытия файла и выделения памяти. После записи файл переоткрывается при
+// следующем чтении, чтобы увидеть дописанные данные.
+//
+// Устаревшие записи накапливаются; compact() переписывает живые записи в
+// PATH.bbtmp и заменяет им PATH. Прерванное сжатие восстанавливается
+// при открытии (по тем же правилам, что и fsck).
+
+// Размер хеш-таблицы (максимум ключей — на один меньше)
+#ifndef BUSYBOX_KV_SLOTS
+#define BUSYBOX_KV_SLOTS 64
+#endif
+
+// Максимальная длина ключа
+#ifndef BUSYBOX_KV_KEY
+#define BUSYBOX_KV_KEY 32
+#endif
+
+// Максимальная длина пути журнала (с суффиксом временного файла)
+#ifndef BUSYBOX_KV_PATH
+#define BUSYBOX_KV_PATH 64
+#endif
+
+// Сжатие в maintain(): доля мусора в журнале, % ...
+#ifndef BUSYBOX_KV_COMPACT_PERCENT
+#define BUSYBOX_KV_COMPACT_PERCENT 50
+#endif
+
+// ... и не меньше стольких байт
+#ifndef BUSYBOX_KV_COMPACT_MIN
+#define BUSYBOX_KV_COMPACT_MIN 4096
+#endif
+
+// Размер журнала, при котором put() сжимает его сразу, не дожидаясь maintain()
+#ifndef BUSYBOX_KV_MAX
+#define BUSYBOX_KV_MAX 65536
+#endif
+
+#define BUSYBOX_KV_MAGIC   0x564B4242     // "BBKV"
+#define BUSYBOX_KV_VERSION 1
+
+namespace Busybox {
+
+    struct KVHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t reserved;
+    };
+
+    enum KVFlags : uint8_t {
+        KV_DELETED = 0x01
+    };
+
+    struct KVRecord {
+        uint32_t crc;
+        uint8_t  keyLen;
+        uint8_t  flags;
+        uint16_t valueLen;
+    };
+
+    struct KVSlot {
+        uint32_t hash;
+        uint32_t offset;        // смещение записи в журнале, 0 — слот свободен
+    };
+
+    class KV {
+    public:
+        explicit KV(const char* path) : _path(path), _count(0), _end(0), _garbage(0), _ready(false) {
+            memset(_slots, 0, sizeof(_slots));
+        }
+
+        /// @brief Открытие журнала: восстановление после прерванного сжатия,
+        /// построение индекса, отбрасывание недописанной записи
+        /// @return false если журнал нельзя прочитать или создать
+        bool begin() {
+            CommandScope _scope("kv");
+            WriteLock _lock;
+            _reader.close();
+            _tmpRecover(_path, "kv");
+            _ready = _load(true);
+            return _ready;
+        }
+
+        /// @brief Чтение значения в буфер вызывающего
+        /// @param value буфер; если короче значения — значение обрезается
+        /// @return длина значения или -1 если ключа нет
+        int32_t get(const char* key, void* value, size_t len) {
+            CommandScope _scope("kv");
+            // Позиция общего файла чтения — состояние, поэтому чтения не параллельны
+            WriteLock _lock;
+            KVRecord r;
+            if (_find(key, nullptr, &r) < 0) return -1;
+            size_t n = r.valueLen < len ? r.valueLen : len;
+            return _read(_reader, (uint8_t*)value, n) == n ? r.valueLen : -1;
+        }
+
+        /// @brief Чтение строкового значения с завершающим нулём
+        /// @return false если ключа нет или буфер мал
+        bool get(const char* key, char* value, size_t size) {
+            if (!size) return false;
+            int32_t n = get(key, (void*)value, size - 1);
+            if (n < 0 || (size_t)n >= size) {
+                value[0] = '\0';
+                return false;
+            }
+            value[n] = '\0';
+            return true;
+        }
+
+        bool has(const char* key) {
+            CommandScope _scope("kv");
+            WriteLock _lock;
+            return _find(key, nullptr, nullptr) >= 0;
+        }
+
+        /// @brief Запись значения (новый ключ или замена)
+        bool put(const char* key, const void* value, size_t len) {
+            CommandScope _scope("kv");
+            WriteLock _lock;
+            size_t keyLen = strlen(key);
+            if (!_ready || !keyLen || keyLen > BUSYBOX_KV_KEY || len > 0xFFFF) {
+                Serial.printf("kv: invalid put of '%s'\n", key);
+                return false;
+            }
+
+            uint32_t old = 0;
+            int slot = _find(key, &old, nullptr);
+            if (slot < 0 && _count >= BUSYBOX_KV_SLOTS - 1) {
+                Serial.printf("kv: index full (%u keys), '%s' not stored\n", (unsigned)_count, key);
+                return false;
+            }
+
+            uint32_t offset;
+            if (!_append(key, keyLen, value, len, 0, offset)) return false;
+            if (slot >= 0) {
+                _slots[slot].offset = offset;
+                _garbage += old;
+            } else {
+                _insert(_hash32(key, keyLen), offset);
+            }
+            if (_end >= BUSYBOX_KV_MAX && _garbage) _compact();
+            return true;
+        }
+
+        bool put(const char* key, const char* value) {
+            return put(key, value, strlen(value));
+        }
+
+        /// @brief Удаление ключа
+        /// @return false если ключа нет или запись не удалась
+        bool del(const char* key) {
+            CommandScope _scope("kv");
+            WriteLock _lock;
+            uint32_t old = 0;
+            int slot = _find(key, &old, nullptr);
+            if (slot < 0) return false;
+            uint32_t offset;
+            if (!_append(key, strlen(key), nullptr, 0, KV_DELETED, offset)) return false;
+            _erase(slot);
+            _garbage += old + (_end - offset);
+            return true;
+        }
+
+        /// @brief Переписывание журнала без устаревших записей
+        bool compact() {
+            CommandScope _scope("kv");
+            WriteLock _lock;
+            return _ready && _compact();
+        }
+
+        /// @brief Сжатие, если мусора больше порога; вызывать из loop() или фоновой задачи
+        /// @return true если журнал был сжат
+        bool maintain() {
+            CommandScope _scope("kv");
+            WriteLock _lock;
+            if (!_ready || _garbage < BUSYBOX_KV_COMPACT_MIN ||
+                (uint64_t)_garbage * 100 < (uint64_t)_end * BUSYBOX_KV_COMPACT_PERCENT) return false;
+            return _compact();
+        }
+
+        uint16_t count() const { return _count; }
+        uint32_t size() const { return _end; }
+        uint32_t garbage() const { return _garbage; }
+
+        // Вывод состояния журнала
+        void stat() {
+            Serial.printf("kv '%s': %u keys (max %u), log %lu bytes, garbage %lu bytes (%lu%%)\n",
+                          _path, (unsigned)_count, (unsigned)(BUSYBOX_KV_SLOTS - 1), (unsigned long)_end,
+                          (unsigned long)_garbage, (unsigned long)(_end ? (uint64_t)_garbage * 100 / _end : 0));
+        }
+
+    private:
+        // Построение индекса одним проходом по журналу; repair — переписать
+        // журнал без недописанного хвоста (иначе такой журнал не открывается)
+        bool _load(bool repair) {
+            memset(_slots, 0, sizeof(_slots));
+            _count = 0;
+            _garbage = 0;
+            _end = sizeof(KVHeader);
+            // Ключи в _probe сравниваются через _reader: одно открытие на весь проход
+            _reader.close();
+
+            File file = _open(BUSYBOX_FS, _path, "r");
+            if (!file) return _create();
+
+            KVHeader h;
+            if (_read(file, (uint8_t*)&h, sizeof(h)) != sizeof(h) ||
+                h.magic != BUSYBOX_KV_MAGIC || h.version != BUSYBOX_KV_VERSION) {
+                file.close();
+                Serial.printf("kv: '%s' is not a key-value log\n", _path);
+                return false;
+            }
+
+            uint32_t fileSize = file.size();
+            bool torn = false;
+            {
+                BlockReader reader(file);
+                KVRecord r;
+                char key[BUSYBOX_KV_KEY + 1];
+                uint8_t chunk[64];
+                while (_end < fileSize) {
+                    if (reader.read((uint8_t*)&r, sizeof(r)) != sizeof(r) ||
+                        !r.keyLen || r.keyLen > BUSYBOX_KV_KEY ||
+                        reader.read((uint8_t*)key, r.keyLen) != r.keyLen) {
+                        torn = true;
+                        break;
+                    }
+                    uint32_t crc = _crc32(key, r.keyLen, _crc32(&r.keyLen, sizeof(r) - sizeof(r.crc)));
+                    size_t left = r.valueLen;
+                    while (left) {
+                        size_t n = left < sizeof(chunk) ? left : sizeof(chunk);
+                        if (reader.read(chunk, n) != n) break;
+                        crc = _crc32(chunk, n, crc);
+                        left -= n;
+                    }
+                    if (left || crc != r.crc) {
+                        torn = true;
+                        break;
+                    }
+                    _apply(key, r, _end);
+                    _end += sizeof(r) + r.keyLen + r.valueLen;
+                }
+            }
+            file.close();
+
+            if (torn) {
+                // Хвост после последней целой записи отбрасывается переписыванием журнала
+                Serial.printf("kv: '%s' damaged at offset %lu, %lu bytes dropped\n",
+                              _path, (unsigned long)_end, (unsigned long)(fileSize - _end));
+                if (!repair) return false;
+                _garbage += fileSize - _end;
+                _end = fileSize;
+                return _compact();
+            }
+            return true;
+        }
+
+        bool _create() {
+            File file = _open(BUSYBOX_FS, _path, "w");
+            if (!file) {
+                Serial.printf("kv: cannot create '%s'\n", _path);
+                return false;
+            }
+            KVHeader h = {BUSYBOX_KV_MAGIC, BUSYBOX_KV_VERSION, 0};
+            bool ok = _write(file, (const uint8_t*)&h, sizeof(h)) == sizeof(h);
+            file.close();
+            _touched(_path, sizeof(h));
+            return ok;
+        }
+
+        // Учёт записи журнала при построении индекса
+        void _apply(const char* key, const KVRecord& r, uint32_t offset) {
+            uint32_t size = sizeof(r) + r.keyLen + r.valueLen;
+            uint32_t hash = _hash32(key, r.keyLen);
+            KVRecord old;
+            int slot = _probe(hash, key, r.keyLen, old);
+            if (slot >= 0) {
+                _garbage += sizeof(old) + old.keyLen + old.valueLen;
+                if (r.flags & KV_DELETED) {
+                    _erase(slot);
+                    _garbage += size;
+                } else {
+                    _slots[slot].offset = offset;
+                }
+            } else if (r.flags & KV_DELETED) {
+                _garbage += size;
+            } else if (_count < BUSYBOX_KV_SLOTS - 1) {
+                _insert(hash, offset);
+            } else {
+                Serial.printf("kv: index full, key '%.*s' ignored\n", r.keyLen, key);
+                _garbage += size;
+            }
+        }
+
+        // Поиск слота ключа при построении индекса; old — заголовок прежней записи
+        int _probe(uint32_t hash, const char* key, uint8_t keyLen, KVRecord& old) {
+            for (uint16_t i = 0, s = hash % BUSYBOX_KV_SLOTS; i < BUSYBOX_KV_SLOTS; i++, s = (s + 1) % BUSYBOX_KV_SLOTS) {
+                if (!_slots[s].offset) return -1;
+                if (_slots[s].hash == hash && _keyAt(_slots[s].offset, key, keyLen, &old)) return s;
+            }
+            return -1;
+        }
+
+        // Слот ключа или -1; size — размер найденной записи, r — её заголовок;
+        // при успехе _reader установлен на начало значения
+        int _find(const char* key, uint32_t* size, KVRecord* r) {
+            if (!_ready) return -1;
+            size_t keyLen = strlen(key);
+            if (!keyLen || keyLen > BUSYBOX_KV_KEY) return -1;
+            uint32_t hash = _hash32(key, keyLen);
+            for (uint16_t i = 0, s = hash % BUSYBOX_KV_SLOTS; i < BUSYBOX_KV_SLOTS; i++, s = (s + 1) % BUSYBOX_KV_SLOTS) {
+                if (!_slots[s].offset) return -1;
+                if (_slots[s].hash != hash) continue;
+                KVRecord found;
+                if (_keyAt(_slots[s].offset, key, keyLen, &found)) {
+                    if (size) *size = sizeof(found) + found.keyLen + found.valueLen;
+                    if (r) *r = found;
+                    return s;
+                }
+            }
+            return -1;
+        }
+
+        // Сравнение ключа записи по смещению; при совпадении _reader установлен
+        // на начало значения
+        bool _keyAt(uint32_t offset, const char* key, uint8_t keyLen, KVRecord* out) {
+            // Файл открывается при первом чтении после открытия журнала или записи
+            if (!_reader) _reader = _open(BUSYBOX_FS, _path, "r");
+            KVRecord r;
+            char stored[BUSYBOX_KV_KEY];
+            bool match = _reader && _reader.seek(offset) &&
+                         _read(_reader, (uint8_t*)&r, sizeof(r)) == sizeof(r) && r.keyLen == keyLen &&
+                         _read(_reader, (uint8_t*)stored, keyLen) == keyLen && memcmp(stored, key, keyLen) == 0;
+            if (match && out) *out = r;
+            return match;
+        }
+
+        uint32_t _recordSize(File& file, uint32_t offset) {
+            KVRecord r;
+            if (!file || !file.seek(offset) || _read(file, (uint8_t*)&r, sizeof(r)) != sizeof(r)) return 0;
+            return sizeof(r) + r.keyLen + r.valueLen;
+        }
+
+        void _insert(uint32_t hash, uint32_t offset) {
+            uint16_t s = hash % BUSYBOX_KV_SLOTS;
+            while (_slots[s].offset) s = (s + 1) % BUSYBOX_KV_SLOTS;
+            _slots[s].hash = hash;
+            _slots[s].offset = offset;
+            _count++;
+        }
+
+        // Удаление из таблицы с открытой адресацией: последующие записи цепочки
+        // сдвигаются назад, чтобы поиск не обрывался на освободившемся слоте
+        void _erase(int slot) {
+            uint16_t hole = slot;
+            uint16_t s = hole;
+            while (true) {
+                s = (s + 1) % BUSYBOX_KV_SLOTS;
+                if (!_slots[s].offset) break;
+                uint16_t home = _slots[s].hash % BUSYBOX_KV_SLOTS;
+                // Запись можно перенести в дыру, если её исходный слот не лежит между дырой и ней
+                bool between = hole <= s ? (home > hole && home <= s) : (home > hole || home <= s);
+                if (!between) {
+                    _slots[hole] = _slots[s];
+                    hole = s;
+                }
+            }
+            _slots[hole].offset = 0;
+            _count--;
+        }
+
+        // Дописывание записи в конец журнала
+        bool _append(const char* key, size_t keyLen, const void* value, size_t len, uint8_t flags, uint32_t& offset) {
+            KVRecord r = {0, (uint8_t)keyLen, flags, (uint16_t)len};
+            r.crc = _crc32(value, len, _crc32(key, keyLen, _crc32(&r.keyLen, sizeof(r) - sizeof(r.crc))));
+
+            // Открытый для чтения файл может не увидеть дописанное
+            _reader.close();
+            File file = _open(BUSYBOX_FS, _path, "a");
+            if (!file) {
+                Serial.printf("kv: cannot open '%s'\n", _path);
+                return false;
+            }
+            offset = file.size();
+            bool ok = _write(file, (const uint8_t*)&r, sizeof(r)) == sizeof(r) &&
+                      _write(file, (const uint8_t*)key, keyLen) == keyLen &&
+                      (!len || _write(file, (const uint8_t*)value, len) == len);
+            file.close();
+            uint32_t size = sizeof(r) + keyLen + len;
+            _touched(_path, size);
+            if (!ok) {
+                // Недописанная запись не пройдёт проверку CRC и будет отброшена при открытии
+                Serial.printf("kv: write to '%s' failed\n", _path);
+                _garbage += size;
+                _end = offset + size;
+                return false;
+            }
+            _end = offset + size;
+            return true;
+        }
+
+        // Копирование живых записей в PATH.bbtmp и замена журнала
+        bool _compact() {
+            _reader.close();
+            char tempPath[BUSYBOX_KV_PATH];
+            if (!_tmpPath(_path, tempPath, sizeof(tempPath))) return false;
+            File source = _open(BUSYBOX_FS, _path, "r");
+            File dest = _open(BUSYBOX_FS, tempPath, "w");
+            if (!source || !dest) {
+                source.close();
+                dest.close();
+                Serial.printf("kv: cannot compact '%s'\n", _path);
+                return false;
+            }
+
+            uint32_t before = _end;
+            uint32_t pos = sizeof(KVHeader);
+            KVHeader h = {BUSYBOX_KV_MAGIC, BUSYBOX_KV_VERSION, 0};
+            bool ok = _write(dest, (const uint8_t*)&h, sizeof(h)) == sizeof(h);
+            {
+                uint8_t small[128];
+                CacheBlock block(small, sizeof(small));
+                BlockWriter writer(dest);
+                for (uint16_t s = 0; ok && s < BUSYBOX_KV_SLOTS; s++) {
+                    if (!_slots[s].offset) continue;
+                    uint32_t left = _recordSize(source, _slots[s].offset);
+                    ok = left && source.seek(_slots[s].offset);
+                    _slots[s].offset = pos;
+                    pos += left;
+                    while (ok && left) {
+                        size_t n = left < block.size ? left : block.size;
+                        ok = _read(source, block.data, n) == n && writer.write(block.data, n) == n;
+                        left -= n;
+                    }
+                    yield();
+                }
+                ok = writer.flush() && ok;
+            }
+            source.close();
+            dest.close();
+
+            if (ok) {
+                // Если питание пропадёт во время замены, begin() закончит её по PATH.bbnew
+                ok = _tmpCommit(BUSYBOX_FS, _path);
+            } else {
+                _remove(BUSYBOX_FS, tempPath);
+            }
+            _touched(_path, pos);
+
+            if (!ok) {
+                // Смещения в индексе уже изменены: строим его заново по журналу
+                Serial.printf("kv: compaction of '%s' failed\n", _path);
+                _tmpRecover(_path, "kv");
+                _ready = _load(false);
+                return false;
+            }
+            _end = pos;
+            _garbage = 0;
+            Serial.printf("kv: '%s' compacted, %lu -> %lu bytes\n", _path, (unsigned long)before, (unsigned long)pos);
+            return true;
+        }
+
+        const char* _path;
+        File        _reader;        // файл журнала для чтения записей, закрыт после записи
+        KVSlot      _slots[BUSYBOX_KV_SLOTS];
+        uint16_t    _count;
+        uint32_t    _end;           // размер журнала
+        uint32_t    _garbage;       // байт устаревших записей
+        bool        _ready;
+    };
+
+} // namespace Busybox
+
+#endif
@@ -2,24 +2,38 @@
 #define BUSYBOX_LFS_H
 
 #include <LittleFS.h>
+#include "Busybox_Common.h"
+#include "Busybox_Stats.h"
+#include "Busybox_Cache.h"
+
+// Объект файловой системы для общих модулей
+#define BUSYBOX_FS LittleFS
 
 #pragma message("++++++++++++++++++++++ Using LitleFS file system ++++++++++++++++++")
 
 namespace Busybox {
 
     // Инициализация файловой системы
-    bool begin(bool formatOnFail = false) {
+    inline bool begin(bool formatOnFail = false) {
         return LittleFS.begin(formatOnFail);
     }
 
     // Форматирование файловой системы
-    bool format() {
+    inline bool format() {
+        WriteLock _lock;
         return LittleFS.format();
     }
 
       // Классический ls с полными путями
-    void ls(const char* path = "/") {
-        File root = LittleFS.open(path);
+#if BUSYBOX_HAS(LS)
+    inline void ls(const char* path = "/") {
+        CommandScope _scope("ls");
+        ReadLock _lock;
+        if (_packOwns(path)) {
+            _packLs(path);
+            return;
+        }
+        File root = _open(LittleFS, path);
         if (!root) {
             Serial.printf("ls: cannot access '%s'\n", path);
             return;
@@ -30,7 +44,7 @@ namespace Busybox {
             return;
         }
 
-        File file = root.openNextFile();
+        File file = _next(root);
         while (file) {
 
             #if defined(ARDUINO_ARCH_ESP32)
@@ -47,14 +61,22 @@ namespace Busybox {
                 Serial.printf("%-25s %6d bytes\n", fullPath.c_str(), file.size());
             }
             file.close();
-            file = root.openNextFile();
+            file = _next(root);
         }
         root.close();
     }
+#endif
 
 
 // Древовидный вывод
-    void tree(const char* path = "/", uint8_t levels = 0, uint8_t indent = 0) {
+#if BUSYBOX_HAS(TREE)
+    inline void tree(const char* path = "/", uint8_t levels = 0, uint8_t indent = 0) {
+        CommandScope _scope("tree");
+        ReadLock _lock;
+        if (_packOwns(path)) {
+            _packTree(path, levels, indent);
+            return;
+        }
         String indentStr = "";
         for (int i = 0; i < indent; i++) {
             indentStr += "  ";
@@ -62,7 +84,7 @@ namespace Busybox {
         
         Serial.printf("%sListing directory: %s\n", indentStr.c_str(), path);
 
-        File root = LittleFS.open(path);
+        File root = _open(LittleFS, path);
         if (!root) {
             Serial.printf("%sFailed to open directory\n", indentStr.c_str());
             return;
@@ -73,7 +95,7 @@ namespace Busybox {
             return;
         }
 
-        File file = root.openNextFile();
+        File file = _next(root);
         bool foundAny = false;
         
         while (file) {
@@ -102,12 +124,13 @@ namespace Busybox {
                 foundAny = true;
             }
             
-            file = root.openNextFile();
+            file = _next(root);
         }
         
         Serial.printf("%s%s\n", indentStr.c_str(), foundAny ? "└── End" : "└── (empty)");
         root.close();
     }
+#endif
 
     // // Список файлов и директорий с улучшенным форматированием
     // void tree(const char* path = "/", uint8_t levels = 0, uint8_t indent = 0) {
@@ -175,8 +198,11 @@ namespace Busybox {
     // }
 
     //Удаление файла
-    bool rm(const char* path) {
-        if (LittleFS.remove(path)) {
+    inline bool rm(const char* path) {
+        CommandScope _scope("rm");
+        WriteLock _lock;
+        if (_remove(LittleFS, path)) {
+            _touched(path, 0, ChangeOp::Remove);
             Serial.printf("File '%s' removed successfully\n", path);
             return true;
         } else {
@@ -185,8 +211,10 @@ namespace Busybox {
         }
     }
 
-    uint8_t rm(std::initializer_list<const char*> listPath ){
-        uint8_t count = 0;
+    inline uint32_t rm(std::initializer_list<const char*> listPath ){
+        CommandScope _scope("rm");
+        WriteLock _lock;
+        uint32_t count = 0;
         for ( auto path : listPath){
             if ( rm(path)) count++;
         }
@@ -198,11 +226,13 @@ namespace Busybox {
     /// @param secondPath 
     /// @param  ...
     /// @return deleted files
-    uint8_t rm(const char* firstPath, const char* secondPath, ...) {
+    inline uint32_t rm(const char* firstPath, const char* secondPath, ...) {
+        CommandScope _scope("rm");
+        WriteLock _lock;
         va_list args;
         const char* path = firstPath;
-        uint8_t deleted = 0;
-        uint8_t total = 1;
+        uint32_t deleted = 0;
+        uint32_t total = 1;
 
         bool allSuccess = rm(firstPath);
         deleted += allSuccess;
@@ -222,17 +252,20 @@ namespace Busybox {
         
         va_end(args);
         if ( deleted > 1 )
-            Serial.printf("Files deleted: %d from %d\n", deleted, total);
+            Serial.printf("Files deleted: %lu from %lu\n", (unsigned long)deleted, (unsigned long)total);
         return deleted;
     }
 
 
-    bool rmrf(const char* path);
+    inline bool rmrf(const char* path);
     // Удаление директории (рекурсивное с флагом force)
-    bool rmdir(const char* path, bool force = false) {
+    inline bool rmdir(const char* path, bool force = false) {
+        CommandScope _scope("rmdir");
+        WriteLock _lock;
         if (!force) {
             // Простое удаление пустой директории
             if (LittleFS.rmdir(path)) {
+                _touched(path, 0, ChangeOp::Rmdir);
                 Serial.printf("Directory '%s' removed successfully\n", path);
                 return true;
             } else {
@@ -247,8 +280,10 @@ namespace Busybox {
 
 
     // Рекурсивное удаление директории с содержимым (аналог rm -rf)
-    bool rmrf(const char* path) {
-        File root = LittleFS.open(path);
+    inline bool rmrf(const char* path) {
+        CommandScope _scope("rmrf");
+        WriteLock _lock;
+        File root = _open(LittleFS, path);
         if (!root) {
             Serial.printf("Cannot open '%s'\n", path);
             return false;
@@ -260,7 +295,7 @@ namespace Busybox {
         }
 
         bool success = true;
-        File file = root.openNextFile();
+        File file = _next(root);
         
         while (file) {
             const char* itemName = file.name();
@@ -283,7 +318,7 @@ namespace Busybox {
             file.close();
 
             if (LittleFS.exists(fullPath)) {
-                File checkFile = LittleFS.open(fullPath);
+                File checkFile = _open(LittleFS, fullPath);
                 if (checkFile) {
                     if (checkFile.isDirectory()) {
                         checkFile.close();
@@ -298,11 +333,12 @@ namespace Busybox {
                     }
                 }
             }
-            file = root.openNextFile();
+            file = _next(root);
         }
         root.close();
 
         if (success && LittleFS.rmdir(path)) {
+            _touched(path, 0, ChangeOp::Rmdir);
             Serial.printf("Directory '%s' removed recursively\n", path);
             return true;
         } else {
@@ -311,30 +347,56 @@ namespace Busybox {
         }
     }
 
+#if BUSYBOX_HAS(CAT)
     // Вывод содержимого файла
-    bool cat(const char* path) {
-        File file = LittleFS.open(path, "r");
+    inline bool cat(const char* path) {
+        CommandScope _scope("cat");
+        ReadLock _lock;
+        // Признак кольцевого журнала читается из уже открытого файла или отображения
+        MapView view = map(path, false);
+        if (view && _ringOwns(view)) {
+            unmap(view);
+            return _ringCat(path);
+        }
+        if (view) {
+            Serial.printf("--- %s ---\n", path);
+            Serial.write(view.data, view.size);
+            Serial.println();
+            unmap(view);
+            return true;
+        }
+
+        File file = _open(LittleFS, path, "r");
         if (!file) {
             Serial.printf("cat: cannot open '%s'\n", path);
             return false;
         }
+        if (_ringOwns(file)) {
+            file.close();
+            return _ringCat(path);
+        }
 
         Serial.printf("--- %s ---\n", path);
-        while (file.available()) {
-            char buf[64];
-            auto len = file.readBytes(buf, 64);
-
-            Serial.write(buf, len); //file.read());
-            delay(0);
+        {
+            BlockReader reader(file);
+            size_t len;
+            while (const uint8_t* buf = reader.next(len)) {
+                Serial.write(buf, len); //file.read());
+                delay(0);
+            }
         }
         Serial.println();
         file.close();
         return true;
     }
+#endif
 
+#if BUSYBOX_HAS(DUMP)
     // Вывод содержимого файла в hex-формате
-    bool dump(const char* path, uint8_t bytesPerLine = 16) {
-        File file = LittleFS.open(path, "r");
+    inline bool dump(const char* path, uint8_t bytesPerLine = 16) {
+        CommandScope _scope("dump");
+        ReadLock _lock;
+        File file = _open(LittleFS, path, "r");
         if (!file) {
             Serial.printf("dump: cannot open '%s'\n", path);
             return false;
@@ -343,12 +405,13 @@ namespace Busybox {
         Serial.printf("Hex dump of '%s' (%d bytes):\n", path, file.size());
         
         size_t offset = 0;
-        while (file.available()) {
+        BlockReader reader(file);
+        while (reader.available()) {
             Serial.printf("%08X: ", offset);
             
             for (uint8_t i = 0; i < bytesPerLine; i++) {
-                if (file.available()) {
-                    uint8_t b = file.read();
+                if (reader.available()) {
+                    uint8_t b = reader.read();
                     Serial.printf("%02X ", b);
                     offset++;
                 } else {
@@ -363,10 +426,14 @@ namespace Busybox {
         file.close();
         return true;
     }
+#endif
 
+#if BUSYBOX_HAS(VIEW)
     // // Просмотр файла с правильной обработкой переноса кириллицы
-    void view(const char* path, uint16_t bytesPerLine = 16) {
-        File file = LittleFS.open(path, "r");
+    inline void view(const char* path, uint16_t bytesPerLine = 16) {
+        CommandScope _scope("view");
+        ReadLock _lock;
+        File file = _open(LittleFS, path, "r");
         if (!file) {
             Serial.printf("view: cannot open '%s'\n", path);
             return;
@@ -379,12 +446,13 @@ namespace Busybox {
         size_t globalOffset = 0;
         uint8_t carryOver = 0;
         bool hasCarryOver = false;
+        BlockReader reader(file);
         
-        while (file.available() || hasCarryOver) {
+        while (reader.available() || hasCarryOver) {
             yield();
             // Читаем данные для текущей строки (только новые байты)
             uint8_t buffer[16] = {0};
-            uint8_t bytesInBuffer = file.read(buffer, bytesPerLine);
+            uint8_t bytesInBuffer = reader.read(buffer, bytesPerLine);
             
             if (bytesInBuffer == 0 && !hasCarryOver) break;
             
@@ -519,8 +587,10 @@ namespace Busybox {
     }
 
     // Просмотр файла с правильной обработкой переноса кириллицы
-    void view1(const char* path, uint16_t bytesPerLine = 16) {
-        File file = LittleFS.open(path, "r");
+    inline void view1(const char* path, uint16_t bytesPerLine = 16) {
+        CommandScope _scope("view1");
+        ReadLock _lock;
+        File file = _open(LittleFS, path, "r");
         if (!file) {
             Serial.printf("view: cannot open '%s'\n", path);
             return;
@@ -533,11 +603,12 @@ namespace Busybox {
         size_t globalOffset = 0;
         uint8_t carryOver = 0;
         bool hasCarryOver = false;
+        BlockReader reader(file);
         
-        while (file.available() || hasCarryOver) {
+        while (reader.available() || hasCarryOver) {
             // Читаем данные для текущей строки (только новые байты)
             uint8_t buffer[16] = {0};
-            uint8_t bytesInBuffer = file.read(buffer, bytesPerLine);
+            uint8_t bytesInBuffer = reader.read(buffer, bytesPerLine);
             
             if (bytesInBuffer == 0 && !hasCarryOver) break;
             
@@ -665,10 +736,15 @@ namespace Busybox {
         file.close();
         Serial.println("--------  --------------------------------  ----------------");
     }
+#endif
 
     // Переименование/перемещение файла
-    bool mv(const char* oldPath, const char* newPath) {
-        if (LittleFS.rename(oldPath, newPath)) {
+    inline bool mv(const char* oldPath, const char* newPath) {
+        CommandScope _scope("mv");
+        WriteLock _lock;
+        if (_rename(LittleFS, oldPath, newPath)) {
+            _touched(oldPath, 0, ChangeOp::MoveFrom);
+            _touched(newPath, 0, ChangeOp::MoveTo);
             Serial.printf("'%s' moved to '%s'\n", oldPath, newPath);
             return true;
         } else {
@@ -678,38 +754,65 @@ namespace Busybox {
     }
 
     // Копирование файла
-    bool cp(const char* sourcePath, const char* destPath) {
-        File source = LittleFS.open(sourcePath, "r");
-        if (!source) {
-            Serial.printf("cp: cannot open source '%s'\n", sourcePath);
-            return false;
+    inline bool cp(const char* sourcePath, const char* destPath) {
+        CommandScope _scope("cp");
+        WriteLock _lock;
+        // Отображённый источник копируется одной записью
+        MapView view = map(sourcePath, false);
+        File source;
+        if (!view) {
+            source = _open(LittleFS, sourcePath, "r");
+            if (!source) {
+                Serial.printf("cp: cannot open source '%s'\n", sourcePath);
+                return false;
+            }
         }
 
-        File dest = LittleFS.open(destPath, "w");
+        File dest = _open(LittleFS, destPath, "w");
         if (!dest) {
             Serial.printf("cp: cannot create '%s'\n", destPath);
+            unmap(view);
             source.close();
             return false;
         }
 
         size_t bytesCopied = 0;
-        uint8_t buffer[128];
-        while (source.available()) {
-            size_t bytesRead = source.read(buffer, sizeof(buffer));
-            dest.write(buffer, bytesRead);
-            bytesCopied += bytesRead;
+        size_t expected = 0;
+        bool ok = true;
+        if (view) {
+            expected = view.size;
+            bytesCopied = _write(dest, view.data, view.size);
+            unmap(view);
+        } else {
+            expected = source.size();
+            BlockReader reader(source);
+            BlockWriter writer(dest);
+            size_t bytesRead;
+            while (const uint8_t* buffer = reader.next(bytesRead)) {
+                if (writer.write(buffer, bytesRead) != bytesRead) break;
+            }
+            ok = writer.flush();
+            bytesCopied = dest.position();
         }
 
         source.close();
         dest.close();
+        _touched(destPath, bytesCopied);
+        if (!ok || bytesCopied != expected) {
+            Serial.printf("cp: copy of '%s' failed at offset %d\n", sourcePath, bytesCopied);
+            return false;
+        }
 
         Serial.printf("cp: '%s' -> '%s' (%d bytes)\n", sourcePath, destPath, bytesCopied);
         return true;
     }
 
     // Создание директории
-    bool mkdir(const char* path) {
+    inline bool mkdir(const char* path) {
+        CommandScope _scope("mkdir");
+        WriteLock _lock;
         if (LittleFS.mkdir(path)) {
+            _touched(path, 0, ChangeOp::Mkdir);
             Serial.printf("Directory '%s' created successfully\n", path);
             return true;
         } else {
@@ -719,15 +822,18 @@ namespace Busybox {
     }
 
     // Запись текста в файл
-    bool write(const char* path, const char* content) {
-        File file = LittleFS.open(path, "w");
+    inline bool write(const char* path, const char* content) {
+        CommandScope _scope("write");
+        WriteLock _lock;
+        File file = _open(LittleFS, path, "w");
         if (!file) {
             Serial.printf("write: cannot create '%s'\n", path);
             return false;
         }
 
-        size_t bytesWritten = file.print(content);
+        size_t bytesWritten = _write(file, content);
         file.close();
+        _touched(path, bytesWritten);
 
         bool success = (bytesWritten == strlen(content));
         Serial.printf("write: %d bytes to '%s' %s\n", bytesWritten, path, success ? "OK" : "FAILED");
@@ -735,55 +841,78 @@ namespace Busybox {
     }
 
     // Добавление текста в конец файла
-    bool append(const char* path, const char* content) {
-        File file = LittleFS.open(path, "a");
+    inline bool append(const char* path, const char* content) {
+        CommandScope _scope("append");
+        WriteLock _lock;
+        File file = _open(LittleFS, path, "a");
         if (!file) {
             Serial.printf("append: cannot open '%s'\n", path);
             return false;
         }
 
-        size_t bytesWritten = file.print(content);
+        size_t bytesWritten = _write(file, content);
         file.close();
+        _touched(path, bytesWritten, ChangeOp::Append);
 
         bool success = (bytesWritten == strlen(content));
         Serial.printf("append: %d bytes to '%s' %s\n", bytesWritten, path, success ? "OK" : "FAILED");
         return success;
     }
 
+    // Получение информации о файле без вывода
+    inline bool stat(const char* path, FileStat& st) {
+        CommandScope _scope("stat");
+        ReadLock _lock;
+        if (_packOwns(path)) return _packStat(path, st);
+        if (!LittleFS.exists(path)) return false;
+        File file = _open(LittleFS, path, "r");
+        if (!file) return false;
+        st.isDir = file.isDirectory();
+        st.size = st.isDir ? 0 : file.size();
+        st.lastWrite = file.getLastWrite();
+        file.close();
+        return true;
+    }
+
     // Получение информации о файле
-    bool stat(const char* path) {
-        if (LittleFS.exists(path)) {
-            File file = LittleFS.open(path, "r");
-            if (file) {
-                Serial.printf( "%s: %s\n", file.isDirectory() ? "Dir" : "File", path );
-                if (!file.isDirectory()) Serial.printf("Size: %d bytes\n", file.size());
-                file.close();
-                return true;
-            }
+    inline bool stat(const char* path) {
+        FileStat st;
+        if (!stat(path, st)) {
+            Serial.printf("'%s' not found\n", path);
+            return false;
         }
-        Serial.printf("'%s' not found\n", path);
-        return false;
+        Serial.printf( "%s: %s\n", st.isDir ? "Dir" : "File", path );
+        if (!st.isDir) Serial.printf("Size: %d bytes\n", st.size);
+        return true;
     }
 
-    // Получение свободного места
-    void df() {
+    // Получение свободного места без вывода
+    inline bool df(FsInfo& info) {
 #if defined(ARDUINO_ARCH_ESP8266)
         FSInfo fs_info;
-        if (!LittleFS.info(fs_info)) {
+        if (!LittleFS.info(fs_info)) return false;
+        info.totalBytes = fs_info.totalBytes;
+        info.usedBytes = fs_info.usedBytes;
+#else
+        info.totalBytes = LittleFS.totalBytes();
+        info.usedBytes = LittleFS.usedBytes();
+#endif
+        info.freeBytes = info.totalBytes - info.usedBytes;
+        return true;
+    }
+
+    // Получение свободного места
+    inline void df() {
+        FsInfo info;
+        if (!df(info)) {
             Serial.println("df: failed to get filesystem info");
             return;
         }
-        size_t totalBytes = fs_info.totalBytes;
-        size_t usedBytes = fs_info.usedBytes;
-#else
-        size_t totalBytes = LittleFS.totalBytes();
-        size_t usedBytes = LittleFS.usedBytes();
-#endif
 
         Serial.println("Filesystem info:");
-        Serial.printf("Total: %d bytes\n", totalBytes);
-        Serial.printf("Used:  %d bytes\n", usedBytes);
-        Serial.printf("Free:  %d bytes\n", totalBytes - usedBytes);
+        Serial.printf("Total: %d bytes\n", info.totalBytes);
+        Serial.printf("Used:  %d bytes\n", info.usedBytes);
+        Serial.printf("Free:  %d bytes\n", info.freeBytes);
     }
 
 } // namespace BusyboxLFS
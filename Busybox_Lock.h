@@ -0,0 +1,246 @@
+#ifndef BUSYBOX_LOCK_H
+#define BUSYBOX_LOCK_H
+
+#include "Busybox_Common.h"
+
+// Блокировка файловой системы для вызова команд из нескольких задач FreeRTOS.
+// Включается определением BUSYBOX_LOCKING перед подключением библиотеки.
+// Читающие команды (ls, tree, cat, dump, view, stat) выполняются параллельно,
+// изменяющие (rm, rmrf, mv, cp, write, append, ...) — монопольно.
+// Повторный захват той же задачей (rmrf -> rm, tree -> tree) допускается.
+// Изменяющая команда внутри чтения той же задачи (rm из обработчика ls, запись
+// из progress fsck) не блокирует задачу саму на себя: на время записи её доля
+// чтения отпускается (дожидаясь других читателей) и затем захватывается снова,
+// так что обход, внутри которого менялась ФС, видит эти изменения. Читающие
+// задачи отслеживаются в таблице на BUSYBOX_LOCK_READERS; для задач сверх неё
+// такая запись изнутри чтения по-прежнему блокируется навсегда.
+// На ESP8266 задач нет, и блокировка сводится к пустым объектам.
+
+#if defined(BUSYBOX_LOCKING) && defined(ARDUINO_ARCH_ESP32)
+#define BUSYBOX_LOCK_ENABLED 1
+#else
+#define BUSYBOX_LOCK_ENABLED 0
+#endif
+
+// Число одновременно читающих задач, для которых известен владелец
+#ifndef BUSYBOX_LOCK_READERS
+#define BUSYBOX_LOCK_READERS 8
+#endif
+
+namespace Busybox {
+
+    // Счётчики ожидания блокировки
+    struct LockStats {
+        uint32_t reads;             // захватов на чтение
+        uint32_t writes;            // захватов на запись
+        uint32_t readWaitUs;        // суммарное ожидание читателей
+        uint32_t writeWaitUs;       // суммарное ожидание писателей
+        uint32_t maxWaitUs;         // максимальное ожидание
+    };
+
+#if BUSYBOX_LOCK_ENABLED
+
+    // Читающая задача и глубина её вложенных захватов
+    struct LockReader {
+        TaskHandle_t task;
+        uint16_t     depth;
+    };
+
+    // Блокировка "много читателей / один писатель" для смонтированной ФС
+    class RwLock {
+    public:
+        void lockRead() {
+            TaskHandle_t self = xTaskGetCurrentTaskHandle();
+            if (_owner == self) {
+                // Чтение внутри собственной записи
+                _depth++;
+                return;
+            }
+            init();
+            uint32_t t0 = micros();
+            xSemaphoreTake(_mutex, portMAX_DELAY);
+            LockReader* reader = find(self);
+            if (reader) {
+                // Повторное чтение той же задачей
+                reader->depth++;
+                xSemaphoreGive(_mutex);
+                return;
+            }
+            if (++_readers == 1) xSemaphoreTake(_write, portMAX_DELAY);
+            reader = find(nullptr);
+            if (reader) {
+                reader->task = self;
+                reader->depth = 1;
+            }
+            account(micros() - t0, false);
+            xSemaphoreGive(_mutex);
+        }
+
+        void unlockRead() {
+            TaskHandle_t self = xTaskGetCurrentTaskHandle();
+            if (_owner == self) {
+                _depth--;
+                return;
+            }
+            xSemaphoreTake(_mutex, portMAX_DELAY);
+            LockReader* reader = find(self);
+            if (reader && --reader->depth) {
+                xSemaphoreGive(_mutex);
+                return;
+            }
+            if (reader) reader->task = nullptr;
+            if (--_readers == 0) xSemaphoreGive(_write);
+            xSemaphoreGive(_mutex);
+        }
+
+        void lockWrite() {
+            TaskHandle_t self = xTaskGetCurrentTaskHandle();
+            if (_owner == self) {
+                _depth++;
+                return;
+            }
+            init();
+            // Запись изнутри собственного чтения: доля чтения отпускается,
+            // иначе задача ждала бы сама себя
+            uint16_t reads = releaseRead(self);
+            uint32_t t0 = micros();
+            xSemaphoreTake(_write, portMAX_DELAY);
+            _owner = self;
+            _depth = 1;
+            _reads = reads;
+            account(micros() - t0, true);
+        }
+
+        void unlockWrite() {
+            if (--_depth == 0) {
+                uint16_t reads = _reads;
+                _reads = 0;
+                _owner = nullptr;
+                xSemaphoreGive(_write);
+                if (reads) restoreRead(reads);
+            }
+        }
+
+        LockStats stats;
+
+    private:
+        void init() {
+            static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+            if (_write) return;
+            SemaphoreHandle_t mutex = xSemaphoreCreateMutex();
+            SemaphoreHandle_t write = xSemaphoreCreateBinary();
+            xSemaphoreGive(write);
+            portENTER_CRITICAL(&mux);
+            bool mine = _write == nullptr;
+            if (mine) {
+                _mutex = mutex;
+                _write = write;
+            }
+            portEXIT_CRITICAL(&mux);
+            if (!mine) {
+                vSemaphoreDelete(mutex);
+                vSemaphoreDelete(write);
+            }
+        }
+
+        // Поиск читателя (nullptr — свободный слот), вызывается под _mutex
+        LockReader* find(TaskHandle_t task) {
+            for (uint8_t i = 0; i < BUSYBOX_LOCK_READERS; i++) {
+                if (_readerTable[i].task == task) return &_readerTable[i];
+            }
+            return nullptr;
+        }
+
+        // Полное освобождение чтения задачи; возвращает глубину захвата (0 — задача не читает)
+        uint16_t releaseRead(TaskHandle_t self) {
+            xSemaphoreTake(_mutex, portMAX_DELAY);
+            LockReader* reader = find(self);
+            uint16_t reads = 0;
+            if (reader) {
+                reads = reader->depth;
+                reader->task = nullptr;
+                if (--_readers == 0) xSemaphoreGive(_write);
+            }
+            xSemaphoreGive(_mutex);
+            return reads;
+        }
+
+        // Возврат чтения, отпущенного в lockWrite
+        void restoreRead(uint16_t reads) {
+            lockRead();
+            xSemaphoreTake(_mutex, portMAX_DELAY);
+            LockReader* reader = find(xTaskGetCurrentTaskHandle());
+            if (reader) reader->depth = reads;
+            else _readers += reads - 1;     // без слота каждый unlockRead снимает по одному
+            xSemaphoreGive(_mutex);
+        }
+
+        // Вызывается под _mutex или под записью, поэтому счётчики не требуют защиты
+        void account(uint32_t us, bool write) {
+            if (write) {
+                stats.writes++;
+                stats.writeWaitUs += us;
+            } else {
+                stats.reads++;
+                stats.readWaitUs += us;
+            }
+            if (us > stats.maxWaitUs) stats.maxWaitUs = us;
+        }
+
+        SemaphoreHandle_t     _mutex = nullptr;     // защищает _readers
+        SemaphoreHandle_t     _write = nullptr;     // свободен, если нет ни читателей, ни писателя
+        volatile TaskHandle_t _owner = nullptr;     // задача, владеющая записью
+        uint16_t              _readers = 0;
+        uint16_t              _depth = 0;
+        uint16_t              _reads = 0;           // глубина чтения владельца, отпущенного на время записи
+        LockReader            _readerTable[BUSYBOX_LOCK_READERS] = {};
+    };
+
+    // Блокировка смонтированной файловой системы
+    inline RwLock& _fsLock() {
+        static RwLock lock;
+        return lock;
+    }
+
+    class ReadLock {
+    public:
+        ReadLock() { _fsLock().lockRead(); }
+        ~ReadLock() { _fsLock().unlockRead(); }
+    };
+
+    class WriteLock {
+    public:
+        WriteLock() { _fsLock().lockWrite(); }
+        ~WriteLock() { _fsLock().unlockWrite(); }
+    };
+
+    // Счётчики ожидания блокировки; reset обнуляет их
+    inline LockStats lockStats(bool reset = false) {
+        WriteLock lock;
+        LockStats copy = _fsLock().stats;
+        if (reset) memset(&_fsLock().stats, 0, sizeof(LockStats));
+        return copy;
+    }
+
+#else
+
+    class ReadLock {
+    public:
+        ReadLock() {}
+    };
+
+    class WriteLock {
+    public:
+        WriteLock() {}
+    };
+
+    inline LockStats lockStats(bool reset = false) {
+        LockStats empty = {};
+        return empty;
+    }
+
+#endif
+
+} // namespace Busybox
+
+#endif
@@ -0,0 +1,267 @@
+#ifndef BUSYBOX_LS_H
+#define BUSYBOX_LS_H
+
+#include "Busybox_Common.h"
+#include "Busybox_Util.h"
+#include <time.h>
+
+// ls с подробным форматом, сортировкой и постраничным выводом.
+//
+// Директория не читается в память целиком. Для отсортированного вывода за
+// один проход по директории отбираются limit первых записей после курсора
+// (куча на limit элементов), так что память не зависит от числа файлов.
+// Курсор хранит ключ последней выданной записи (значение сортировки и имя),
+// следующая страница начинается строго после него. Без сортировки курсор —
+// число уже выданных записей в порядке openNextFile.
+//
+// Имя записи хранится обрезанным до BUSYBOX_LS_NAME - 1 символов (в LittleFS
+// имя до 255). Имена, совпадающие после обрезки, упорядочиваются по хешу
+// полного имени; только если совпал и хеш, курсор может пропустить одну из
+// таких записей. Для полной строгости — BUSYBOX_LS_NAME 256.
+
+// Максимальная длина имени (длинные имена обрезаются)
+#ifndef BUSYBOX_LS_NAME
+#define BUSYBOX_LS_NAME 64
+#endif
+
+// Размер страницы отсортированного вывода, если limit не задан
+#ifndef BUSYBOX_LS_PAGE
+#define BUSYBOX_LS_PAGE 32
+#endif
+
+namespace Busybox {
+
+    enum class LsSort : uint8_t {
+        None,       // порядок openNextFile
+        Name,
+        Size,
+        Time        // время последней записи
+    };
+
+    struct LsOpts {
+        bool     longFormat;    // ls -l: размер и время изменения
+        LsSort   sort;
+        bool     reverse;       // обратный порядок (ls -r)
+        uint16_t limit;         // записей за вызов, 0 — все
+    };
+
+    struct LsEntry {
+        char     name[BUSYBOX_LS_NAME];     // имя без пути
+        uint32_t nameHash;                  // FNV-1a полного имени: порядок обрезанных имён
+        uint32_t size;                      // 0 для директорий
+        uint32_t lastWrite;                 // 0 если ФС не хранит время
+        bool     isDir;
+    };
+
+    // Позиция постраничного вывода. Перед первой страницей — LsCursor{},
+    // между вызовами не изменяется; опции всех страниц должны совпадать.
+    struct LsCursor {
+        LsEntry  last;          // последняя выданная запись
+        uint32_t offset;        // выдано записей
+        bool     done;          // записей больше нет
+    };
+
+    // Получатель записей; false — остановить вывод
+    typedef bool (*LsSink)(const LsEntry& entry, void* arg);
+
+    inline int _lsCompare(const LsEntry& a, const LsEntry& b, const LsOpts& opts) {
+        int c = 0;
+        if (opts.sort == LsSort::Size && a.size != b.size) c = a.size < b.size ? -1 : 1;
+        if (opts.sort == LsSort::Time && a.lastWrite != b.lastWrite) c = a.lastWrite < b.lastWrite ? -1 : 1;
+        // Имена в директории различны, поэтому порядок строгий и курсор однозначен;
+        // обрезанные имена различаются хешем полного имени
+        if (!c) c = strcmp(a.name, b.name);
+        if (!c && a.nameHash != b.nameHash) c = a.nameHash < b.nameHash ? -1 : 1;
+        return opts.reverse ? -c : c;
+    }
+
+    inline void _lsEntry(File& file, LsEntry& e) {
+        const char* name = file.name();
+        const char* slash = strrchr(name, '/');
+        if (slash) name = slash + 1;
+        strncpy(e.name, name, sizeof(e.name) - 1);
+        e.name[sizeof(e.name) - 1] = '\0';
+        e.nameHash = _hash32(name);
+        e.isDir = file.isDirectory();
+        e.size = e.isDir ? 0 : file.size();
+        e.lastWrite = file.getLastWrite();
+    }
+
+    // Куча с наибольшей (последней по порядку) из отобранных записей в вершине
+    inline void _lsSiftDown(LsEntry* heap, uint16_t count, uint16_t i, const LsOpts& opts) {
+        while (true) {
+            uint16_t top = i;
+            uint16_t left = 2 * i + 1;
+            uint16_t right = left + 1;
+            if (left < count && _lsCompare(heap[left], heap[top], opts) > 0) top = left;
+            if (right < count && _lsCompare(heap[right], heap[top], opts) > 0) top = right;
+            if (top == i) return;
+            LsEntry t = heap[i];
+            heap[i] = heap[top];
+            heap[top] = t;
+            i = top;
+        }
+    }
+
+    inline void _lsSiftUp(LsEntry* heap, uint16_t i, const LsOpts& opts) {
+        while (i) {
+            uint16_t parent = (i - 1) / 2;
+            if (_lsCompare(heap[i], heap[parent], opts) <= 0) return;
+            LsEntry t = heap[i];
+            heap[i] = heap[parent];
+            heap[parent] = t;
+            i = parent;
+        }
+    }
+
+    // Страница без сортировки: пропуск cursor.offset записей
+    inline uint32_t _lsPlain(File& root, const LsOpts& opts, LsCursor& cursor, LsSink sink, void* arg) {
+        uint32_t index = 0;
+        uint32_t sent = 0;
+        LsEntry e;
+        cursor.done = true;
+        while (File file = _next(root)) {
+            if (index++ < cursor.offset) continue;
+            if (opts.limit && sent == opts.limit) {
+                // Есть ещё записи
+                cursor.done = false;
+                break;
+            }
+            _lsEntry(file, e);
+            file.close();
+            sent++;
+            cursor.offset++;
+            cursor.last = e;
+            if (!sink(e, arg)) {
+                cursor.done = false;
+                break;
+            }
+        }
+        return sent;
+    }
+
+    // Страница с сортировкой: limit первых записей после курсора за один проход
+    inline uint32_t _lsSorted(File& root, const LsOpts& opts, LsCursor& cursor, LsSink sink, void* arg,
+                              uint16_t limit) {
+        LsEntry* heap = (LsEntry*)malloc(limit * sizeof(LsEntry));
+        if (!heap) {
+            Serial.println("ls: out of memory");
+            return 0;
+        }
+        uint16_t count = 0;
+        uint32_t matched = 0;
+        LsEntry e;
+        while (File file = _next(root)) {
+            _lsEntry(file, e);
+            file.close();
+            if (cursor.offset && _lsCompare(e, cursor.last, opts) <= 0) continue;
+            matched++;
+            if (count < limit) {
+                heap[count] = e;
+                _lsSiftUp(heap, count++, opts);
+            } else if (_lsCompare(e, heap[0], opts) < 0) {
+                heap[0] = e;
+                _lsSiftDown(heap, count, 0, opts);
+            }
+        }
+
+        // Извлечение из кучи даёт записи с конца
+        for (uint16_t n = count; n > 1; n--) {
+            LsEntry t = heap[0];
+            heap[0] = heap[n - 1];
+            heap[n - 1] = t;
+            _lsSiftDown(heap, n - 1, 0, opts);
+        }
+
+        uint32_t sent = 0;
+        cursor.done = matched <= limit;
+        for (uint16_t i = 0; i < count; i++) {
+            sent++;
+            cursor.offset++;
+            cursor.last = heap[i];
+            if (!sink(heap[i], arg)) {
+                cursor.done = false;
+                break;
+            }
+        }
+        free(heap);
+        return sent;
+    }
+
+    /// @brief Постраничный обход директории с сортировкой
+    /// @param path директория
+    /// @param opts сортировка и размер страницы
+    /// @param cursor позиция (nullptr — с начала); после вызова указывает на последнюю выданную запись
+    /// @param sink получатель записей
+    /// @param arg аргумент для sink
+    /// @return число выданных записей
+    inline uint32_t ls(const char* path, const LsOpts& opts, LsCursor* cursor, LsSink sink, void* arg) {
+        CommandScope _scope("ls");
+        ReadLock _lock;
+        LsCursor start = {};
+        LsCursor& c = cursor ? *cursor : start;
+        if (c.done) return 0;
+
+        File root = _open(BUSYBOX_FS, path);
+        if (!root || !root.isDirectory()) {
+            Serial.printf("ls: cannot access '%s'\n", path);
+            return 0;
+        }
+        uint32_t sent = 0;
+        if (opts.sort == LsSort::None) {
+            sent = _lsPlain(root, opts, c, sink, arg);
+        } else {
+            // Без limit — страницами по BUSYBOX_LS_PAGE, каждая за отдельный проход
+            uint16_t page = opts.limit ? opts.limit : BUSYBOX_LS_PAGE;
+            while (true) {
+                uint32_t before = c.offset;
+                sent += _lsSorted(root, opts, c, sink, arg, page);
+                if (opts.limit || c.done || c.offset - before < page) break;
+                root.close();
+                root = _open(BUSYBOX_FS, path);
+                if (!root) break;
+            }
+        }
+        root.close();
+        return sent;
+    }
+
+    inline bool _lsPrint(const LsEntry& e, void* arg) {
+        const LsOpts& opts = *(const LsOpts*)arg;
+        if (!opts.longFormat) {
+            if (e.isDir) Serial.printf("%s/\n", e.name);
+            else Serial.printf("%-25s %6lu bytes\n", e.name, (unsigned long)e.size);
+            return true;
+        }
+        char when[20] = "-";
+        if (e.lastWrite) {
+            time_t t = e.lastWrite;
+            struct tm tm;
+            localtime_r(&t, &tm);
+            strftime(when, sizeof(when), "%Y-%m-%d %H:%M", &tm);
+        }
+        if (e.isDir) Serial.printf("d %10s  %-16s  %s/\n", "", when, e.name);
+        else Serial.printf("- %10lu  %-16s  %s\n", (unsigned long)e.size, when, e.name);
+        return true;
+    }
+
+    /// @brief Вывод директории: ls -l, сортировка, страницы
+    /// @param path директория
+    /// @param opts формат, сортировка и размер страницы
+    /// @param cursor позиция для следующей страницы (nullptr — с начала)
+    /// @return число выведенных записей
+    inline uint32_t ls(const char* path, const LsOpts& opts, LsCursor* cursor = nullptr) {
+        if (_packOwns(path)) {
+            _packLs(path);
+            return 0;
+        }
+        uint32_t sent = ls(path, opts, cursor, _lsPrint, (void*)&opts);
+        if (cursor && !cursor->done) {
+            Serial.printf("ls: %lu shown, more after '%s'\n", (unsigned long)cursor->offset, cursor->last.name);
+        }
+        return sent;
+    }
+
+} // namespace Busybox
+
+#endif
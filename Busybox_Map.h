@@ -0,0 +1,292 @@
+#ifndef BUSYBOX_MAP_H
+#define BUSYBOX_MAP_H
+
+#include "Busybox_Common.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_heap_caps.h>
+#endif
+
+// Доступ к содержимому файлов только для чтения без копирования через буферы.
+// Если у пути есть поставщик прямого отображения (например, упакованный образ
+// во flash), map() возвращает указатель прямо в отображённую память.
+// Иначе файл целиком читается в кэш из BUSYBOX_MAP_SLOTS слотов (PSRAM, если есть)
+// и остаётся там до изменения файла командами Busybox или вытеснения. Попадание
+// в кэш не обращается к ФС: после записи в обход Busybox (напрямую через LittleFS)
+// нужно вызвать mapflush(). С BUSYBOX_MAP_REVALIDATE 1 каждое попадание сверяет
+// размер и время записи файла — это лишнее открытие файла, и изменение того же
+// размера в ту же секунду (или на SPIFFS, где времени записи нет) так не обнаружить.
+
+// Число слотов кэша
+#ifndef BUSYBOX_MAP_SLOTS
+#define BUSYBOX_MAP_SLOTS 4
+#endif
+
+// Максимальный размер файла, который кладётся в кэш
+#ifndef BUSYBOX_MAP_MAX
+#define BUSYBOX_MAP_MAX 32768
+#endif
+
+// Максимальная длина пути в кэше
+#ifndef BUSYBOX_MAP_PATH
+#define BUSYBOX_MAP_PATH 64
+#endif
+
+// Сверять копию в кэше с файлом при каждом map()
+#ifndef BUSYBOX_MAP_REVALIDATE
+#define BUSYBOX_MAP_REVALIDATE 0
+#endif
+
+// Слот MapView без кэша: прямое отображение
+#define BUSYBOX_MAP_DIRECT 0xFF
+
+namespace Busybox {
+
+    // Поставщик прямого отображения: заполняет view и возвращает true,
+    // если путь можно отдать без копирования
+    typedef bool (*MapProvider)(const char* path, MapView& view);
+
+    struct MapSlot {
+        char     path[BUSYBOX_MAP_PATH];
+        uint8_t* data;
+        uint32_t size;
+        uint32_t lastWrite;     // время записи файла при загрузке
+        uint32_t lastUse;
+        uint16_t refs;
+    };
+
+    struct MapCache {
+        MapSlot     slots[BUSYBOX_MAP_SLOTS];
+        MapProvider provider;
+        uint32_t    tick;
+        uint32_t    hits;
+        uint32_t    misses;
+        uint32_t    direct;
+    };
+
+    inline MapCache& _mapCache() {
+        static MapCache cache = {};
+        return cache;
+    }
+
+#if defined(ARDUINO_ARCH_ESP32)
+    inline portMUX_TYPE& _mapMux() {
+        static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+        return mux;
+    }
+    inline void _mapLock() { portENTER_CRITICAL(&_mapMux()); }
+    inline void _mapUnlock() { portEXIT_CRITICAL(&_mapMux()); }
+#else
+    inline void _mapLock() {}
+    inline void _mapUnlock() {}
+#endif
+
+    inline uint8_t* _mapAlloc(size_t size) {
+#if defined(ARDUINO_ARCH_ESP32)
+        // Кэш только для чтения: PSRAM подходит и не отнимает внутреннюю память
+        uint8_t* p = (uint8_t*)heap_caps_malloc(size, MALLOC_CAP_SPIRAM);
+        if (p) return p;
+#endif
+        return (uint8_t*)malloc(size);
+    }
+
+    // Регистрация поставщика прямого отображения (nullptr — отключить)
+    inline void mapProvider(MapProvider provider) {
+        _mapCache().provider = provider;
+    }
+
+    // Поиск пути в кэше, вызывается под _mapLock
+    inline int8_t _mapFind(const char* path) {
+        MapCache& c = _mapCache();
+        for (uint8_t i = 0; i < BUSYBOX_MAP_SLOTS; i++) {
+            if (c.slots[i].data && strcmp(c.slots[i].path, path) == 0) return i;
+        }
+        return -1;
+    }
+
+    // Освобождение отображения, полученного от map
+    inline void unmap(MapView& view) {
+        if (view.data && view.slot != BUSYBOX_MAP_DIRECT) {
+            _mapLock();
+            MapSlot& s = _mapCache().slots[view.slot];
+            if (s.refs) s.refs--;
+            uint8_t* orphan = nullptr;
+            // Файл был изменён, пока отображение было занято
+            if (s.refs == 0 && s.path[0] == '\0') {
+                orphan = s.data;
+                s.data = nullptr;
+            }
+            _mapUnlock();
+            if (orphan) free(orphan);
+        }
+        view.data = nullptr;
+        view.size = 0;
+    }
+
+    // Сброс кэша для изменённого файла
+    inline void _mapInvalidate(const char* path) {
+        uint8_t* freed = nullptr;
+        _mapLock();
+        int8_t found = _mapFind(path);
+        if (found >= 0) {
+            MapSlot& s = _mapCache().slots[found];
+            if (s.refs == 0) {
+                freed = s.data;
+                s.data = nullptr;
+            }
+            // Занятый слот освободится в unmap, но новым map уже не найдётся
+            s.path[0] = '\0';
+        }
+        _mapUnlock();
+        if (freed) free(freed);
+    }
+
+    // Файл не менялся с загрузки в кэш: те же размер и время записи
+    inline bool _mapFresh(const char* path, uint32_t size, uint32_t lastWrite) {
+#if BUSYBOX_MAP_REVALIDATE
+        ReadLock _lock;
+        File file = _open(BUSYBOX_FS, path, "r");
+        bool fresh = file && !file.isDirectory() && file.size() == size && file.getLastWrite() == lastWrite;
+        file.close();
+        return fresh;
+#else
+        return true;    // изменения командами Busybox сбрасывают слот через _touched
+#endif
+    }
+
+    /// @brief Содержимое файла в памяти только для чтения
+    /// @param path путь к файлу
+    /// @param cache читать файл в кэш, если нет прямого отображения и файла ещё нет в кэше
+    /// @return view.data == nullptr если отобразить не удалось; после использования вызвать unmap
+    inline MapView map(const char* path, bool cache) {
+        MapCache& c = _mapCache();
+        MapView view = {nullptr, 0, BUSYBOX_MAP_DIRECT};
+
+        if (c.provider && c.provider(path, view)) {
+            view.slot = BUSYBOX_MAP_DIRECT;
+            c.direct++;
+            return view;
+        }
+
+        uint32_t stamp = 0;
+        _mapLock();
+        int8_t found = _mapFind(path);
+        if (found >= 0) {
+            MapSlot& s = c.slots[found];
+            s.refs++;
+            s.lastUse = ++c.tick;
+            stamp = s.lastWrite;
+            view.data = s.data;
+            view.size = s.size;
+            view.slot = found;
+        }
+        _mapUnlock();
+        if (view.data) {
+            // С BUSYBOX_MAP_REVALIDATE: файл мог быть изменён в обход Busybox
+            if (_mapFresh(path, view.size, stamp)) {
+                _mapLock();
+                c.hits++;
+                _mapUnlock();
+                return view;
+            }
+            unmap(view);
+            _mapInvalidate(path);
+        }
+        if (!cache || strlen(path) >= BUSYBOX_MAP_PATH) return view;
+
+        // Чтение файла целиком в новый буфер
+        uint8_t* data = nullptr;
+        uint32_t size = 0;
+        uint32_t lastWrite = 0;
+        {
+            ReadLock _lock;
+            File file = _open(BUSYBOX_FS, path, "r");
+            if (!file || file.isDirectory()) return view;
+            size = file.size();
+            lastWrite = file.getLastWrite();
+            if (size > BUSYBOX_MAP_MAX) {
+                file.close();
+                return view;
+            }
+            data = _mapAlloc(size ? size : 1);
+            if (!data) {
+                file.close();
+                return view;
+            }
+            uint32_t done = 0;
+            while (done < size) {
+                size_t n = _read(file, data + done, size - done);
+                if (n == 0) break;
+                done += n;
+            }
+            file.close();
+            if (done != size) {
+                free(data);
+                return view;
+            }
+        }
+
+        // Установка в свободный или давно не используемый слот без ссылок
+        uint8_t* evicted = nullptr;
+        _mapLock();
+        c.misses++;
+        int8_t victim = -1;
+        for (uint8_t i = 0; i < BUSYBOX_MAP_SLOTS; i++) {
+            MapSlot& s = c.slots[i];
+            if (!s.data) {
+                victim = i;
+                break;
+            }
+            if (s.refs == 0 && (victim < 0 || s.lastUse < c.slots[victim].lastUse)) victim = i;
+        }
+        if (victim >= 0) {
+            MapSlot& s = c.slots[victim];
+            evicted = s.data;
+            strcpy(s.path, path);
+            s.data = data;
+            s.size = size;
+            s.lastWrite = lastWrite;
+            s.refs = 1;
+            s.lastUse = ++c.tick;
+            view.data = data;
+            view.size = size;
+            view.slot = victim;
+        }
+        _mapUnlock();
+
+        if (evicted) free(evicted);
+        if (victim < 0) free(data);
+        return view;
+    }
+
+    // Освобождение всех незанятых слотов кэша
+    inline void mapflush() {
+        for (uint8_t i = 0; i < BUSYBOX_MAP_SLOTS; i++) {
+            uint8_t* freed = nullptr;
+            _mapLock();
+            MapSlot& s = _mapCache().slots[i];
+            if (s.data && s.refs == 0) {
+                freed = s.data;
+                s.data = nullptr;
+            }
+            _mapUnlock();
+            if (freed) free(freed);
+        }
+    }
+
+    // Вывод состояния кэша
+    inline void mapstat() {
+        MapCache& c = _mapCache();
+        Serial.printf("map: %lu hits, %lu misses, %lu direct\n",
+                      (unsigned long)c.hits, (unsigned long)c.misses, (unsigned long)c.direct);
+        for (uint8_t i = 0; i < BUSYBOX_MAP_SLOTS; i++) {
+            const MapSlot& s = c.slots[i];
+            if (!s.data) continue;
+            Serial.printf("  [%u] %-32s %6lu bytes, refs %u\n", i,
+                          s.path[0] ? s.path : "(stale)", (unsigned long)s.size, s.refs);
+        }
+    }
+
+} // namespace Busybox
+
+#endif
@@ -0,0 +1,337 @@
+#ifndef BUSYBOX_PACK_H
+#define BUSYBOX_PACK_H
+
+#include "Busybox_Common.h"
+#include "Busybox_Util.h"
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_partition.h>
+#include <esp_idf_version.h>
+#if ESP_IDF_VERSION_MAJOR < 5
+// ESP-IDF 4.x: отображение разделов через spi_flash_mmap
+typedef spi_flash_mmap_handle_t esp_partition_mmap_handle_t;
+#define ESP_PARTITION_MMAP_DATA SPI_FLASH_MMAP_DATA
+#define esp_partition_munmap    spi_flash_munmap
+#endif
+#endif
+
+// Упакованный образ ресурсов только для чтения (формат BBPK).
+// Образ собирается на компьютере утилитой tools/bbpack.py из каталога
+// и прошивается в отдельный раздел flash или встраивается в прошивку.
+// Файлы образа видны командам ls/cat/stat/tree и map() под префиксом BUSYBOX_PACK_MOUNT.
+//
+// Формат (little-endian, все смещения от начала образа):
+//   PackHeader
+//   PackEntry[count]        — отсортированы по пути (побайтно)
+//   uint16_t[hashSlots]     — открытая адресация: индекс записи + 1, 0 — пусто
+//   пути записей            — строки с завершающим нулём, начинаются с '/'
+//   данные файлов           — каждый файл выровнен на align байт
+
+#ifndef BUSYBOX_PACK_MOUNT
+#define BUSYBOX_PACK_MOUNT "/rom"
+#endif
+
+#define BUSYBOX_PACK_MAGIC   0x4B504242     // "BBPK"
+#define BUSYBOX_PACK_VERSION 1
+
+namespace Busybox {
+
+    struct PackHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t align;
+        uint32_t count;
+        uint32_t hashSlots;         // степень двойки
+        uint32_t entriesOffset;
+        uint32_t hashOffset;
+        uint32_t namesOffset;
+        uint32_t totalSize;
+    };
+
+    struct PackEntry {
+        uint32_t nameOffset;        // от начала таблицы путей
+        uint32_t dataOffset;
+        uint32_t size;
+        uint32_t hash;              // FNV-1a пути
+    };
+
+    struct PackImage {
+        const uint8_t*    base;
+        const PackHeader* header;
+        const PackEntry*  entries;
+        const uint16_t*   slots;
+        const char*       names;
+#if defined(ARDUINO_ARCH_ESP32)
+        esp_partition_mmap_handle_t mmap;
+        bool              mapped;
+#endif
+    };
+
+    inline PackImage& _pack() {
+        static PackImage image = {};
+        return image;
+    }
+
+    inline const char* _packName(const PackEntry& e) {
+        return _pack().names + e.nameOffset;
+    }
+
+    // Путь внутри образа или nullptr, если путь не относится к образу
+    inline const char* _packPath(const char* path) {
+        if (!_pack().header) return nullptr;
+        size_t len = strlen(BUSYBOX_PACK_MOUNT);
+        if (strncmp(path, BUSYBOX_PACK_MOUNT, len) != 0) return nullptr;
+        if (path[len] == '\0') return "/";
+        if (path[len] != '/') return nullptr;
+        return path + len;
+    }
+
+    inline bool _packOwns(const char* path) {
+        return _packPath(path) != nullptr;
+    }
+
+    // Поиск файла по хешу, O(1) в среднем
+    inline const PackEntry* _packFind(const char* inner) {
+        const PackImage& img = _pack();
+        uint32_t hash = _hash32(inner);
+        uint32_t mask = img.header->hashSlots - 1;
+        for (uint32_t i = hash & mask, n = 0; n <= mask; i = (i + 1) & mask, n++) {
+            uint16_t slot = img.slots[i];
+            if (slot == 0) return nullptr;
+            const PackEntry& e = img.entries[slot - 1];
+            if (e.hash == hash && strcmp(_packName(e), inner) == 0) return &e;
+        }
+        return nullptr;
+    }
+
+    // Первая запись с путём >= prefix (записи отсортированы)
+    inline uint32_t _packLowerBound(const char* prefix) {
+        const PackImage& img = _pack();
+        uint32_t lo = 0;
+        uint32_t hi = img.header->count;
+        while (lo < hi) {
+            uint32_t mid = (lo + hi) / 2;
+            if (strcmp(_packName(img.entries[mid]), prefix) < 0) lo = mid + 1;
+            else hi = mid;
+        }
+        return lo;
+    }
+
+    // Префикс каталога с завершающим '/'
+    inline void _packDirPrefix(char* out, size_t len, const char* inner) {
+        size_t n = strlen(inner);
+        snprintf(out, len, (n && inner[n - 1] == '/') ? "%s" : "%s/", inner);
+    }
+
+    inline bool _packMap(const char* path, MapView& view) {
+        const char* inner = _packPath(path);
+        if (!inner) return false;
+        const PackEntry* e = _packFind(inner);
+        if (!e) return false;
+        view.data = _pack().base + e->dataOffset;
+        view.size = e->size;
+        return true;
+    }
+
+    // Проверка образа: заголовок, затем каждая запись и слот хеш-таблицы,
+    // чтобы _packFind и _packMap не выходили за образ на повреждённых данных.
+    // Суммы считаются в 64 битах: смещения из образа не должны переполняться.
+    inline bool _packValid(const uint8_t* image, size_t size) {
+        const PackHeader* h = (const PackHeader*)image;
+        if (size < sizeof(PackHeader) || h->magic != BUSYBOX_PACK_MAGIC || h->version != BUSYBOX_PACK_VERSION ||
+            h->totalSize > size || h->totalSize < sizeof(PackHeader) ||
+            h->hashSlots == 0 || (h->hashSlots & (h->hashSlots - 1)) ||
+            h->entriesOffset % alignof(PackEntry) || h->hashOffset % alignof(uint16_t)) {
+            return false;
+        }
+        uint64_t total = h->totalSize;
+        if ((uint64_t)h->entriesOffset + (uint64_t)h->count * sizeof(PackEntry) > total ||
+            (uint64_t)h->hashOffset + (uint64_t)h->hashSlots * sizeof(uint16_t) > total ||
+            h->namesOffset >= total) {
+            return false;
+        }
+
+        const PackEntry* entries = (const PackEntry*)(image + h->entriesOffset);
+        const char* names = (const char*)(image + h->namesOffset);
+        size_t namesSize = total - h->namesOffset;
+        for (uint32_t i = 0; i < h->count; i++) {
+            const PackEntry& e = entries[i];
+            if (e.nameOffset >= namesSize ||
+                !memchr(names + e.nameOffset, '\0', namesSize - e.nameOffset) ||
+                (uint64_t)e.dataOffset + e.size > total) {
+                return false;
+            }
+        }
+        const uint16_t* slots = (const uint16_t*)(image + h->hashOffset);
+        for (uint32_t i = 0; i < h->hashSlots; i++) {
+            // Слот хранит индекс записи + 1, 0 — пустой
+            if (slots[i] != 0 && slots[i] - 1u >= h->count) return false;
+        }
+        return true;
+    }
+
+    // Проверка и подключение образа, лежащего в памяти
+    inline bool _packAttach(const uint8_t* image, size_t size) {
+        if (!_packValid(image, size)) {
+            Serial.println("pack: invalid image");
+            return false;
+        }
+        const PackHeader* h = (const PackHeader*)image;
+
+        PackImage& img = _pack();
+        img.base = image;
+        img.entries = (const PackEntry*)(image + h->entriesOffset);
+        img.slots = (const uint16_t*)(image + h->hashOffset);
+        img.names = (const char*)(image + h->namesOffset);
+        img.header = h;
+        mapProvider(_packMap);
+        return true;
+    }
+
+    /// @brief Подключение образа из памяти (RAM или отображённой flash)
+    /// @param image начало образа, выровненное на 4 байта
+    /// @param size размер доступной области
+    inline bool packBegin(const uint8_t* image, size_t size) {
+        return _packAttach(image, size);
+    }
+
+#if defined(ARDUINO_ARCH_ESP32)
+    /// @brief Подключение образа из раздела flash через esp_partition_mmap
+    /// @param label метка раздела данных в таблице разделов
+    inline bool packBegin(const char* label) {
+        const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                               ESP_PARTITION_SUBTYPE_ANY, label);
+        if (!part) {
+            Serial.printf("pack: partition '%s' not found\n", label);
+            return false;
+        }
+        const void* ptr = nullptr;
+        esp_partition_mmap_handle_t handle;
+        if (esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &ptr, &handle) != ESP_OK) {
+            Serial.printf("pack: cannot map partition '%s'\n", label);
+            return false;
+        }
+        if (!_packAttach((const uint8_t*)ptr, part->size)) {
+            esp_partition_munmap(handle);
+            return false;
+        }
+        _pack().mmap = handle;
+        _pack().mapped = true;
+        return true;
+    }
+#endif
+
+    // Отключение образа
+    inline void packEnd() {
+        PackImage& img = _pack();
+        if (!img.header) return;
+        mapProvider(nullptr);
+#if defined(ARDUINO_ARCH_ESP32)
+        if (img.mapped) esp_partition_munmap(img.mmap);
+#endif
+        memset(&img, 0, sizeof(img));
+    }
+
+    // ls для путей образа
+    inline void _packLs(const char* path) {
+        const PackImage& img = _pack();
+        char prefix[96];
+        _packDirPrefix(prefix, sizeof(prefix), _packPath(path));
+        size_t prefixLen = strlen(prefix);
+
+        const char* lastDir = nullptr;
+        size_t lastDirLen = 0;
+        bool found = false;
+        for (uint32_t i = _packLowerBound(prefix); i < img.header->count; i++) {
+            const char* name = _packName(img.entries[i]);
+            if (strncmp(name, prefix, prefixLen) != 0) break;
+            found = true;
+
+            const char* rest = name + prefixLen;
+            const char* slash = strchr(rest, '/');
+            if (slash) {
+                // Подкаталог: записи одного подкаталога идут подряд
+                size_t dirLen = slash - name;
+                if (lastDir && dirLen == lastDirLen && strncmp(lastDir, name, dirLen) == 0) continue;
+                lastDir = name;
+                lastDirLen = dirLen;
+                char dir[96];
+                snprintf(dir, sizeof(dir), "%s%.*s/", BUSYBOX_PACK_MOUNT, (int)dirLen, name);
+                Serial.printf("%-32s [Dir]\n", dir);
+            } else {
+                char full[96];
+                snprintf(full, sizeof(full), "%s%s", BUSYBOX_PACK_MOUNT, name);
+                Serial.printf("%-25s %6d bytes\n", full, img.entries[i].size);
+            }
+        }
+        if (!found) {
+            if (_packFind(_packPath(path))) Serial.println("Not a directory");
+            else Serial.printf("ls: cannot access '%s'\n", path);
+        }
+    }
+
+    inline void _packTree(const char* path, uint8_t levels, uint8_t indent) {
+        const PackImage& img = _pack();
+        char indentStr[2 * 16 + 1];
+        uint8_t n = indent < 16 ? indent : 16;
+        memset(indentStr, ' ', 2 * n);
+        indentStr[2 * n] = '\0';
+
+        Serial.printf("%sListing directory: %s\n", indentStr, path);
+
+        char prefix[96];
+        _packDirPrefix(prefix, sizeof(prefix), _packPath(path));
+        size_t prefixLen = strlen(prefix);
+
+        const char* lastDir = nullptr;
+        size_t lastDirLen = 0;
+        bool foundAny = false;
+        for (uint32_t i = _packLowerBound(prefix); i < img.header->count; i++) {
+            const char* name = _packName(img.entries[i]);
+            if (strncmp(name, prefix, prefixLen) != 0) break;
+            foundAny = true;
+
+            const char* rest = name + prefixLen;
+            const char* slash = strchr(rest, '/');
+            if (slash) {
+                size_t dirLen = slash - name;
+                if (lastDir && dirLen == lastDirLen && strncmp(lastDir, name, dirLen) == 0) continue;
+                lastDir = name;
+                lastDirLen = dirLen;
+                Serial.printf("%s├── DIR : %.*s/\n", indentStr, (int)(slash - rest), rest);
+                if (levels > 0) {
+                    char sub[96];
+                    snprintf(sub, sizeof(sub), "%s%.*s", BUSYBOX_PACK_MOUNT, (int)dirLen, name);
+                    _packTree(sub, levels - 1, indent + 1);
+                }
+            } else {
+                Serial.printf("%s├── FILE: %-20s  SIZE: %d\n", indentStr, rest, img.entries[i].size);
+            }
+        }
+        Serial.printf("%s%s\n", indentStr, foundAny ? "└── End" : "└── (empty)");
+    }
+
+    inline bool _packStat(const char* path, FileStat& st) {
+        const char* inner = _packPath(path);
+        const PackEntry* e = _packFind(inner);
+        st.lastWrite = 0;
+        if (e) {
+            st.isDir = false;
+            st.size = e->size;
+            return true;
+        }
+        // Каталог существует, если есть хотя бы одна запись с его префиксом
+        char prefix[96];
+        _packDirPrefix(prefix, sizeof(prefix), inner);
+        uint32_t i = _packLowerBound(prefix);
+        if (i < _pack().header->count && strncmp(_packName(_pack().entries[i]), prefix, strlen(prefix)) == 0) {
+            st.isDir = true;
+            st.size = 0;
+            return true;
+        }
+        return false;
+    }
+
+} // namespace Busybox
+
+#endif
@@ -0,0 +1,299 @@
+#ifndef BUSYBOX_PART_H
+#define BUSYBOX_PART_H
+
+#include "Busybox_Common.h"
+
+// Разделы flash целиком (только ESP32): таблица разделов, выгрузка и
+// восстановление образов (nvs, coredump, раздел ФС) и копирование coredump
+// в файл.
+//
+// Раздел читается и пишется через esp_partition_read/write блоками
+// BUSYBOX_PART_BLOCK, выровненными по секторам, — это быстрее обхода файлов и
+// захватывает то, чего не видно через файловый API (метаданные ФС, NVS).
+// Каждая передача сопровождается CRC-32 (как в zlib). Восстанавливаются только
+// разделы данных. Образ читается из файла, поэтому раздел, на котором смонтирована
+// BUSYBOX_FS, из неё же восстановить нельзя: образ стирался бы во время чтения.
+// Такой раздел восстанавливается из другой ФС (SD, FFat) после BUSYBOX_FS.end().
+
+#if defined(ARDUINO_ARCH_ESP32)
+#include <esp_partition.h>
+
+// Размер буфера чтения/записи раздела, кратен сектору
+#ifndef BUSYBOX_PART_BLOCK
+#define BUSYBOX_PART_BLOCK 8192
+#endif
+
+// Сектор стирания flash
+#define BUSYBOX_PART_SECTOR 4096
+
+// Метка раздела BUSYBOX_FS (по умолчанию begin() у FFat — "ffat", у LittleFS и SPIFFS — "spiffs")
+#ifndef BUSYBOX_PART_FS_LABEL
+#if defined(BUSYBOX_FATFS_H)
+#define BUSYBOX_PART_FS_LABEL "ffat"
+#else
+#define BUSYBOX_PART_FS_LABEL "spiffs"
+#endif
+#endif
+
+static_assert(BUSYBOX_PART_BLOCK % BUSYBOX_PART_SECTOR == 0, "BUSYBOX_PART_BLOCK must be a multiple of the flash sector");
+
+namespace Busybox {
+
+    // Получатель данных раздела; false — прервать выгрузку
+    typedef bool (*PartSink)(const uint8_t* data, size_t len, void* arg);
+
+    inline const char* _partSubtypeStr(const esp_partition_t* p) {
+        if (p->type == ESP_PARTITION_TYPE_APP) {
+            if (p->subtype == 0x00) return "factory";
+            if (p->subtype >= 0x10 && p->subtype < 0x20) return "ota";
+            if (p->subtype == 0x20) return "test";
+            return "?";
+        }
+        switch ((uint8_t)p->subtype) {
+            case 0x00: return "ota";
+            case 0x01: return "phy";
+            case 0x02: return "nvs";
+            case 0x03: return "coredump";
+            case 0x04: return "nvs_keys";
+            case 0x05: return "efuse";
+            case 0x81: return "fat";
+            case 0x82: return "spiffs";
+            case 0x83: return "littlefs";
+        }
+        return "?";
+    }
+
+    // Раздел по метке: сначала разделы данных, затем приложений
+    inline const esp_partition_t* _partFind(const char* label) {
+        const esp_partition_t* p = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+        if (!p) p = esp_partition_find_first(ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_ANY, label);
+        if (!p) Serial.printf("part: partition '%s' not found\n", label);
+        return p;
+    }
+
+    // Чтение первых size байт раздела блоками; sink может быть nullptr (только CRC)
+    inline bool _partStream(const esp_partition_t* part, uint32_t size, PartSink sink, void* arg, uint32_t& crc) {
+        uint8_t* buffer = _cacheAlloc(BUSYBOX_PART_BLOCK, false);
+        if (!buffer) {
+            Serial.println("part: out of memory");
+            return false;
+        }
+        bool ok = true;
+        crc = 0;
+        for (uint32_t pos = 0; pos < size; pos += BUSYBOX_PART_BLOCK) {
+            size_t n = size - pos < BUSYBOX_PART_BLOCK ? size - pos : BUSYBOX_PART_BLOCK;
+            if (esp_partition_read(part, pos, buffer, n) != ESP_OK) {
+                Serial.printf("part: read error in '%s' at 0x%lX\n", part->label, (unsigned long)pos);
+                ok = false;
+                break;
+            }
+            crc = _crc32(buffer, n, crc);
+            if (sink && !sink(buffer, n, arg)) {
+                ok = false;
+                break;
+            }
+            yield();
+        }
+        free(buffer);
+        return ok;
+    }
+
+    /// @brief Вывод таблицы разделов
+    inline void part() {
+        CommandScope _scope("part");
+        Serial.println("Label            Type Subtype     Offset       Size");
+        const esp_partition_type_t types[] = {ESP_PARTITION_TYPE_APP, ESP_PARTITION_TYPE_DATA};
+        for (esp_partition_type_t type : types) {
+            esp_partition_iterator_t it = esp_partition_find(type, ESP_PARTITION_SUBTYPE_ANY, nullptr);
+            while (it) {
+                const esp_partition_t* p = esp_partition_get(it);
+                Serial.printf("%-16s %-4s %-9s 0x%06lX %10lu%s\n", p->label,
+                              type == ESP_PARTITION_TYPE_APP ? "app" : "data", _partSubtypeStr(p),
+                              (unsigned long)p->address, (unsigned long)p->size, p->encrypted ? " encrypted" : "");
+                it = esp_partition_next(it);
+            }
+        }
+    }
+
+    /// @brief Выгрузка раздела целиком в функцию-получатель
+    /// @param label метка раздела
+    /// @param sink получатель блоков (до BUSYBOX_PART_BLOCK байт)
+    /// @param arg аргумент для sink
+    /// @param crc если не nullptr, сюда записывается CRC-32 выгруженных данных
+    /// @return false если раздел не найден, ошибка чтения или sink прервал выгрузку
+    inline bool partdump(const char* label, PartSink sink, void* arg, uint32_t* crc = nullptr) {
+        CommandScope _scope("partdump");
+        ReadLock _lock;
+        const esp_partition_t* part = _partFind(label);
+        if (!part) return false;
+        uint32_t c;
+        bool ok = _partStream(part, part->size, sink, arg, c);
+        if (crc) *crc = c;
+        return ok;
+    }
+
+#if BUSYBOX_HAS(DUMP)
+    inline bool _partEncode(const uint8_t* data, size_t len, void* arg) {
+        ((DumpEncoder*)arg)->write(data, len);
+        return true;
+    }
+
+    /// @brief Вывод раздела в Serial в компактном формате dump (Base64, Raw, IntelHex)
+    /// @param label метка раздела
+    /// @param mode формат; заголовок "BBB64|BBRAW|BBHEX SIZE CRC32 LABEL" для tools/bbdump.py
+    inline bool partdump(const char* label, DumpMode mode) {
+        CommandScope _scope("partdump");
+        ReadLock _lock;
+        if (mode == DumpMode::Hex) {
+            Serial.println("partdump: use DumpMode::Base64, Raw or IntelHex");
+            return false;
+        }
+        const esp_partition_t* part = _partFind(label);
+        if (!part) return false;
+        // CRC нужен в заголовке: чтение flash на порядок быстрее передачи по UART
+        uint32_t crc;
+        if (!_partStream(part, part->size, nullptr, nullptr, crc)) return false;
+        DumpEncoder encoder(mode);
+        encoder.begin(part->size, crc, part->label);
+        uint32_t check;
+        bool ok = _partStream(part, part->size, _partEncode, &encoder, check);
+        uint32_t sent = encoder.end();
+        // Раздел изменился между проходами (например, запись NVS из другой задачи)
+        if (ok && check != crc) Serial.printf("partdump: '%s' changed during dump, CRC mismatch\n", label);
+        return ok && check == crc && sent == part->size;
+    }
+#endif
+
+    /// @brief Восстановление раздела данных из файла образа (например, выгруженного partdump)
+    /// @param label метка раздела
+    /// @param fs ФС с образом; раздел, на котором она смонтирована, восстановить из неё нельзя
+    /// @param path файл образа; не больше раздела, остаток раздела стирается
+    /// @param crc ожидаемый CRC-32 образа (0 — не проверять); проверяется до стирания
+    /// @return true если образ записан и прочитанные обратно данные совпали по CRC
+    inline bool partrestore(const char* label, fs::FS& fs, const char* path, uint32_t crc = 0) {
+        CommandScope _scope("partrestore");
+        WriteLock _lock;
+        const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+        if (!part) {
+            Serial.printf("partrestore: data partition '%s' not found\n", label);
+            return false;
+        }
+        // fat, spiffs, littlefs: образ на восстанавливаемом разделе был бы стёрт при чтении
+        bool fsPart = part->subtype == 0x81 || part->subtype == 0x82 || part->subtype == 0x83;
+        if (&fs == &BUSYBOX_FS && fsPart && strcmp(part->label, BUSYBOX_PART_FS_LABEL) == 0) {
+            Serial.printf("partrestore: '%s' holds the image's file system, restore it from another FS\n", label);
+            return false;
+        }
+        File file = _open(fs, path, "r");
+        if (!file || file.isDirectory()) {
+            Serial.printf("partrestore: cannot open '%s'\n", path);
+            return false;
+        }
+        uint32_t size = file.size();
+        if (size > part->size) {
+            Serial.printf("partrestore: '%s' (%lu bytes) does not fit '%s' (%lu bytes)\n", path,
+                          (unsigned long)size, label, (unsigned long)part->size);
+            return false;
+        }
+        uint8_t* buffer = _cacheAlloc(BUSYBOX_PART_BLOCK, false);
+        if (!buffer) {
+            Serial.println("partrestore: out of memory");
+            return false;
+        }
+
+        // Образ проверяется до стирания: испорченный файл не должен уничтожить раздел
+        uint32_t source = 0;
+        bool ok = true;
+        for (uint32_t pos = 0; pos < size && ok; pos += BUSYBOX_PART_BLOCK) {
+            size_t n = size - pos < BUSYBOX_PART_BLOCK ? size - pos : BUSYBOX_PART_BLOCK;
+            ok = _read(file, buffer, n) == n;
+            source = _crc32(buffer, n, source);
+        }
+        if (!ok || (crc && source != crc)) {
+            Serial.printf("partrestore: '%s' is damaged (CRC %08lX, expected %08lX)\n", path,
+                          (unsigned long)source, (unsigned long)crc);
+            free(buffer);
+            return false;
+        }
+
+        file.seek(0);
+        for (uint32_t pos = 0; pos < size && ok; pos += BUSYBOX_PART_BLOCK) {
+            size_t n = size - pos < BUSYBOX_PART_BLOCK ? size - pos : BUSYBOX_PART_BLOCK;
+            size_t erase = (n + BUSYBOX_PART_SECTOR - 1) / BUSYBOX_PART_SECTOR * BUSYBOX_PART_SECTOR;
+            ok = _read(file, buffer, n) == n && esp_partition_erase_range(part, pos, erase) == ESP_OK &&
+                 esp_partition_write(part, pos, buffer, n) == ESP_OK;
+            if (!ok) Serial.printf("partrestore: write error in '%s' at 0x%lX\n", label, (unsigned long)pos);
+            yield();
+        }
+        file.close();
+        free(buffer);
+
+        uint32_t end = (size + BUSYBOX_PART_SECTOR - 1) / BUSYBOX_PART_SECTOR * BUSYBOX_PART_SECTOR;
+        if (ok && end < part->size) ok = esp_partition_erase_range(part, end, part->size - end) == ESP_OK;
+
+        uint32_t written;
+        if (ok && (!_partStream(part, size, nullptr, nullptr, written) || written != source)) {
+            Serial.printf("partrestore: verification of '%s' failed\n", label);
+            return false;
+        }
+        if (ok) {
+            Serial.printf("partrestore: '%s' -> '%s' (%lu bytes, CRC %08lX)\n", path, label, (unsigned long)size,
+                          (unsigned long)source);
+        }
+        return ok;
+    }
+
+    /// @brief Восстановление раздела данных из файла образа в BUSYBOX_FS
+    inline bool partrestore(const char* label, const char* path, uint32_t crc = 0) {
+        return partrestore(label, BUSYBOX_FS, path, crc);
+    }
+
+    inline bool _partToFile(const uint8_t* data, size_t len, void* arg) {
+        return _write(*(File*)arg, data, len) == len;
+    }
+
+    /// @brief Копирование сохранённого coredump из раздела flash в файл
+    /// @param path файл (разбор: espcoredump.py info_corefile -t raw -c FILE firmware.elf)
+    /// @param erase стереть раздел после копирования, чтобы не выгружать тот же дамп повторно
+    /// @return false если раздела нет, дамп не сохранён или ошибка записи
+    inline bool coredump(const char* path, bool erase = false) {
+        CommandScope _scope("coredump");
+        WriteLock _lock;
+        const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                               (esp_partition_subtype_t)0x03, nullptr);
+        if (!part) {
+            Serial.println("coredump: no coredump partition");
+            return false;
+        }
+        // Образ во flash начинается с полной длины дампа; стёртый раздел — 0xFFFFFFFF
+        uint32_t size = 0;
+        if (esp_partition_read(part, 0, &size, sizeof(size)) != ESP_OK || !size || size > part->size) {
+            Serial.println("coredump: no core dump stored");
+            return false;
+        }
+
+        File file = _open(BUSYBOX_FS, path, "w");
+        if (!file) {
+            Serial.printf("coredump: cannot create '%s'\n", path);
+            return false;
+        }
+        uint32_t crc;
+        bool ok = _partStream(part, size, _partToFile, &file, crc);
+        file.close();
+        _touched(path, size);
+        if (!ok) {
+            Serial.printf("coredump: copy to '%s' failed\n", path);
+            return false;
+        }
+        if (erase && esp_partition_erase_range(part, 0, part->size) != ESP_OK) {
+            Serial.println("coredump: cannot erase partition");
+        }
+        Serial.printf("coredump: %lu bytes -> '%s' (CRC %08lX)\n", (unsigned long)size, path, (unsigned long)crc);
+        return true;
+    }
+
+} // namespace Busybox
+
+#endif
+
+#endif
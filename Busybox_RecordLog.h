@@ -0,0 +1,331 @@
+#ifndef BUSYBOX_RECORDLOG_H
+#define BUSYBOX_RECORDLOG_H
+
+#include "Busybox_Common.h"
+#include "Busybox_Util.h"
+
+// Журнал двоичных записей с метками времени и разреженным индексом.
+//
+// Данные PATH (little-endian):
+//   RecordLogHeader
+//   записи: RecordHeader; uint8_t data[len]
+//
+// Индекс PATH.idx — массив RecordIndex {ts, смещение} для записей с номерами
+// 0, every, 2*every... Метки времени не убывают, поэтому query() находит начало
+// интервала двоичным поиском по индексу и читает данные только от ближайшей
+// индексной записи до конца интервала.
+//
+// Индекс дописывается после данных. Если питание пропало между ними, begin()
+// досчитывает недостающие элементы индекса по данным; недописанная запись в
+// конце данных отбрасывается переписыванием файла через PATH.bbtmp.
+
+// Интервал индекса, записей
+#ifndef BUSYBOX_RECLOG_EVERY
+#define BUSYBOX_RECLOG_EVERY 64
+#endif
+
+// Максимальный размер данных записи (буфер на стеке при чтении)
+#ifndef BUSYBOX_RECLOG_RECORD
+#define BUSYBOX_RECLOG_RECORD 256
+#endif
+
+// Максимальная длина пути журнала (с суффиксом индекса или временного файла)
+#ifndef BUSYBOX_RECLOG_PATH
+#define BUSYBOX_RECLOG_PATH 64
+#endif
+
+#define BUSYBOX_RECLOG_MAGIC   0x4C524242     // "BBRL"
+#define BUSYBOX_RECLOG_VERSION 1
+#define BUSYBOX_RECLOG_INDEX   ".idx"
+
+namespace Busybox {
+
+    struct RecordLogHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t every;             // интервал индекса
+    };
+
+    // Заголовок записи; CRC-32 покрывает ts, len и данные
+    struct RecordHeader {
+        uint32_t ts;
+        uint16_t len;
+        uint16_t reserved;
+        uint32_t crc;
+    };
+
+    struct RecordIndex {
+        uint32_t ts;
+        uint32_t offset;
+    };
+
+    // Получатель записей query(); false — прекратить чтение
+    typedef bool (*RecordSink)(uint32_t ts, const uint8_t* data, size_t len, void* arg);
+
+    inline bool _reclogIndexPath(const char* path, char* out, size_t len) {
+        return (size_t)snprintf(out, len, "%s%s", path, BUSYBOX_RECLOG_INDEX) < len;
+    }
+
+    inline uint32_t _reclogCrc(const RecordHeader& r, const uint8_t* data) {
+        return _crc32(data, r.len, _crc32(&r, offsetof(RecordHeader, crc)));
+    }
+
+    // Чтение следующей записи; false в конце данных или на повреждённой записи
+    inline bool _reclogNext(BlockReader& reader, RecordHeader& r, uint8_t* data) {
+        return reader.read((uint8_t*)&r, sizeof(r)) == sizeof(r) && r.len <= BUSYBOX_RECLOG_RECORD &&
+               reader.read(data, r.len) == r.len && r.crc == _reclogCrc(r, data);
+    }
+
+    // Смещение индексной записи, с которой начинается чтение интервала от tFrom:
+    // последний элемент с ts < tFrom (записи с ts == tFrom могут быть и до него)
+    inline uint32_t _reclogSeek(const char* path, uint32_t tFrom) {
+        char indexPath[BUSYBOX_RECLOG_PATH];
+        uint32_t offset = sizeof(RecordLogHeader);
+        if (!_reclogIndexPath(path, indexPath, sizeof(indexPath))) return offset;
+        File index = _open(BUSYBOX_FS, indexPath, "r");
+        if (!index) return offset;
+
+        uint32_t lo = 0;
+        uint32_t hi = index.size() / sizeof(RecordIndex);
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo) / 2;
+            RecordIndex e;
+            if (!index.seek(mid * sizeof(RecordIndex)) ||
+                _read(index, (uint8_t*)&e, sizeof(e)) != sizeof(e)) break;
+            if (e.ts < tFrom) {
+                offset = e.offset;
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        index.close();
+        return offset;
+    }
+
+    /// @brief Записи журнала с tFrom <= ts <= tTo
+    /// @param sink получатель записей, false — прекратить чтение
+    /// @return число переданных записей
+    inline uint32_t query(const char* path, uint32_t tFrom, uint32_t tTo, RecordSink sink, void* arg = nullptr) {
+        CommandScope _scope("query");
+        ReadLock _lock;
+        File file = _open(BUSYBOX_FS, path, "r");
+        RecordLogHeader h;
+        if (!file || _read(file, (uint8_t*)&h, sizeof(h)) != sizeof(h) ||
+            h.magic != BUSYBOX_RECLOG_MAGIC || h.version != BUSYBOX_RECLOG_VERSION) {
+            Serial.printf("query: '%s' is not a record log\n", path);
+            file.close();
+            return 0;
+        }
+
+        uint32_t count = 0;
+        if (file.seek(_reclogSeek(path, tFrom))) {
+            BlockReader reader(file);
+            RecordHeader r;
+            uint8_t data[BUSYBOX_RECLOG_RECORD];
+            while (_reclogNext(reader, r, data)) {
+                if (r.ts > tTo) break;
+                if (r.ts < tFrom) continue;
+                count++;
+                if (!sink(r.ts, data, r.len, arg)) break;
+                delay(0);
+            }
+        }
+        file.close();
+        return count;
+    }
+
+    class RecordLog {
+    public:
+        explicit RecordLog(const char* path) : _path(path), _records(0), _end(0), _lastTs(0), _ready(false) {}
+
+        /// @brief Открытие журнала (создание, если нет): поиск конца данных,
+        /// восстановление индекса и отбрасывание недописанной записи
+        bool begin() {
+            CommandScope _scope("reclog");
+            WriteLock _lock;
+            _tmpRecover(_path, "reclog");
+            _ready = BUSYBOX_FS.exists(_path) ? _load() : _create();
+            return _ready;
+        }
+
+        /// @brief Добавление записи
+        /// @param ts метка времени; не меньше, чем у предыдущей записи
+        bool append(uint32_t ts, const void* data, size_t len) {
+            CommandScope _scope("reclog");
+            WriteLock _lock;
+            if (!_ready || len > BUSYBOX_RECLOG_RECORD) return false;
+            if (ts < _lastTs) {
+                Serial.printf("reclog: timestamp %lu is older than %lu\n", (unsigned long)ts, (unsigned long)_lastTs);
+                return false;
+            }
+
+            RecordHeader r = {ts, (uint16_t)len, 0, 0};
+            r.crc = _reclogCrc(r, (const uint8_t*)data);
+            File file = _open(BUSYBOX_FS, _path, "a");
+            bool ok = file && _write(file, (const uint8_t*)&r, sizeof(r)) == sizeof(r) &&
+                      (!len || _write(file, (const uint8_t*)data, len) == len);
+            file.close();
+            _touched(_path, sizeof(r) + len);
+            if (!ok) {
+                // Недописанная запись будет отброшена при следующем открытии
+                Serial.printf("reclog: write to '%s' failed\n", _path);
+                _ready = false;
+                return false;
+            }
+
+            if (_records % BUSYBOX_RECLOG_EVERY == 0) _index(ts, _end);
+            _records++;
+            _end += sizeof(r) + len;
+            _lastTs = ts;
+            return true;
+        }
+
+        uint32_t records() const { return _records; }
+        uint32_t size() const { return _end; }
+
+        // Вывод состояния журнала
+        void stat() {
+            Serial.printf("reclog '%s': %lu records, %lu bytes, index every %u, last ts %lu\n",
+                          _path, (unsigned long)_records, (unsigned long)_end,
+                          (unsigned)BUSYBOX_RECLOG_EVERY, (unsigned long)_lastTs);
+        }
+
+    private:
+        bool _create() {
+            File file = _open(BUSYBOX_FS, _path, "w");
+            RecordLogHeader h = {BUSYBOX_RECLOG_MAGIC, BUSYBOX_RECLOG_VERSION, BUSYBOX_RECLOG_EVERY};
+            bool ok = file && _write(file, (const uint8_t*)&h, sizeof(h)) == sizeof(h);
+            file.close();
+            char indexPath[BUSYBOX_RECLOG_PATH];
+            if (ok && _reclogIndexPath(_path, indexPath, sizeof(indexPath))) {
+                file = _open(BUSYBOX_FS, indexPath, "w");
+                ok = (bool)file;
+                file.close();
+            }
+            _touched(_path, sizeof(h));
+            if (!ok) {
+                Serial.printf("reclog: cannot create '%s'\n", _path);
+                return false;
+            }
+            _records = 0;
+            _end = sizeof(h);
+            _lastTs = 0;
+            return true;
+        }
+
+        // Открытие существующего журнала: от последнего элемента индекса до конца данных
+        bool _load() {
+            File file = _open(BUSYBOX_FS, _path, "r");
+            if (!file) return false;
+            RecordLogHeader h;
+            if (_read(file, (uint8_t*)&h, sizeof(h)) != sizeof(h) || h.magic != BUSYBOX_RECLOG_MAGIC ||
+                h.version != BUSYBOX_RECLOG_VERSION || h.every != BUSYBOX_RECLOG_EVERY) {
+                file.close();
+                Serial.printf("reclog: '%s' is not a record log (or BUSYBOX_RECLOG_EVERY differs)\n", _path);
+                return false;
+            }
+            uint32_t fileSize = file.size();
+
+            // Последний целый элемент индекса; неполный хвост индекса — перестроение
+            char indexPath[BUSYBOX_RECLOG_PATH];
+            if (!_reclogIndexPath(_path, indexPath, sizeof(indexPath))) {
+                file.close();
+                return false;
+            }
+            File index = _open(BUSYBOX_FS, indexPath, "r");
+            uint32_t entries = index ? index.size() / sizeof(RecordIndex) : 0;
+            RecordIndex last = {0, sizeof(RecordLogHeader)};
+            bool rebuild = !index || index.size() % sizeof(RecordIndex) != 0;
+            if (!rebuild && entries) {
+                rebuild = !index.seek((entries - 1) * sizeof(RecordIndex)) ||
+                          _read(index, (uint8_t*)&last, sizeof(last)) != sizeof(last) || last.offset >= fileSize;
+            }
+            index.close();
+            if (rebuild) {
+                Serial.printf("reclog: rebuilding index of '%s'\n", _path);
+                index = _open(BUSYBOX_FS, indexPath, "w");
+                index.close();
+                _touched(indexPath);
+                entries = 0;
+                last = {0, sizeof(RecordLogHeader)};
+            }
+
+            // Досчёт записей от последнего элемента индекса; недостающие элементы дописываются
+            _records = entries ? (entries - 1) * BUSYBOX_RECLOG_EVERY : 0;
+            _end = last.offset;
+            _lastTs = 0;
+            bool ok = file.seek(_end);
+            if (ok) {
+                BlockReader reader(file);
+                RecordHeader r;
+                uint8_t data[BUSYBOX_RECLOG_RECORD];
+                while (_end < fileSize && _reclogNext(reader, r, data) && r.ts >= _lastTs) {
+                    if (_records % BUSYBOX_RECLOG_EVERY == 0 && _records / BUSYBOX_RECLOG_EVERY >= entries) {
+                        _index(r.ts, _end);
+                    }
+                    _records++;
+                    _end += sizeof(r) + r.len;
+                    _lastTs = r.ts;
+                }
+            }
+            file.close();
+
+            if (_end < fileSize) {
+                Serial.printf("reclog: '%s' damaged at offset %lu, %lu bytes dropped\n",
+                              _path, (unsigned long)_end, (unsigned long)(fileSize - _end));
+                return _truncate();
+            }
+            return ok;
+        }
+
+        // Переписывание данных до _end через PATH.bbtmp
+        bool _truncate() {
+            char tempPath[BUSYBOX_RECLOG_PATH];
+            if (!_tmpPath(_path, tempPath, sizeof(tempPath))) return false;
+            File source = _open(BUSYBOX_FS, _path, "r");
+            File dest = _open(BUSYBOX_FS, tempPath, "w");
+            bool ok = source && dest;
+            {
+                uint8_t small[128];
+                CacheBlock block(small, sizeof(small));
+                uint32_t left = _end;
+                while (ok && left) {
+                    size_t n = left < block.size ? left : block.size;
+                    ok = _read(source, block.data, n) == n && _write(dest, block.data, n) == n;
+                    left -= n;
+                    yield();
+                }
+            }
+            source.close();
+            dest.close();
+            if (ok) ok = _tmpCommit(BUSYBOX_FS, _path);
+            else _remove(BUSYBOX_FS, tempPath);
+            _touched(_path, _end);
+            if (!ok) Serial.printf("reclog: cannot repair '%s'\n", _path);
+            return ok;
+        }
+
+        void _index(uint32_t ts, uint32_t offset) {
+            char indexPath[BUSYBOX_RECLOG_PATH];
+            if (!_reclogIndexPath(_path, indexPath, sizeof(indexPath))) return;
+            RecordIndex e = {ts, offset};
+            File index = _open(BUSYBOX_FS, indexPath, "a");
+            // Пропущенный элемент не нарушает поиск: чтение начнётся с предыдущего
+            if (!index || _write(index, (const uint8_t*)&e, sizeof(e)) != sizeof(e)) {
+                Serial.printf("reclog: cannot update '%s'\n", indexPath);
+            }
+            index.close();
+            _touched(indexPath, sizeof(e));
+        }
+
+        const char* _path;
+        uint32_t    _records;
+        uint32_t    _end;           // конец последней целой записи
+        uint32_t    _lastTs;
+        bool        _ready;
+    };
+
+} // namespace Busybox
+
+#endif
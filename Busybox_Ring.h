@@ -0,0 +1,450 @@
+#ifndef BUSYBOX_RING_H
+#define BUSYBOX_RING_H
+
+#include "Busybox_Common.h"
+#include "Busybox_Util.h"
+
+// Кольцевой журнал фиксированного размера.
+//
+// Журнал создаётся один раз и больше не растёт, не переименовывается и не
+// удаляется: записи циклически занимают слоты фиксированного размера. Данные
+// разбиты на сегменты по BUSYBOX_RING_SEGMENT байт — файлы PATH, PATH.1, PATH.2...
+// LittleFS при записи в середину файла переписывает его хвост до конца, поэтому
+// сегмент размером в блок ограничивает цену записи одним блоком.
+//
+// Сегмент (little-endian):
+//   RingHeader
+//   слоты по slotSize байт: RingSlot; uint8_t data[len]
+//
+// Положение головы не хранится: запись заголовка при каждом добавлении
+// изнашивала бы один и тот же блок. Номера записей (seq) растут, поэтому
+// голова — последний слот с seq не меньше, чем в первом действительном слоте;
+// она находится при открытии двоичным поиском. Слот, недописанный при потере
+// питания, не проходит проверку CRC и считается пустым.
+
+// Размер сегмента
+#ifndef BUSYBOX_RING_SEGMENT
+#define BUSYBOX_RING_SEGMENT 4096
+#endif
+
+// Максимальный размер слота (буфер слота размещается на стеке)
+#ifndef BUSYBOX_RING_SLOT_MAX
+#define BUSYBOX_RING_SLOT_MAX 256
+#endif
+
+// Максимальная длина пути журнала (с номером сегмента)
+#ifndef BUSYBOX_RING_PATH
+#define BUSYBOX_RING_PATH 64
+#endif
+
+#define BUSYBOX_RING_MAGIC   0x47524242     // "BBRG"
+#define BUSYBOX_RING_VERSION 1
+
+namespace Busybox {
+
+    struct RingHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t slotSize;
+        uint16_t slotsPerSegment;
+        uint16_t segments;
+        uint16_t segment;           // номер этого сегмента
+        uint16_t reserved;
+    };
+
+    // Заголовок слота; CRC-32 покрывает seq, len и данные
+    struct RingSlot {
+        uint32_t seq;               // 0 — слот пуст
+        uint16_t len;
+        uint16_t reserved;
+        uint32_t crc;
+    };
+
+    // Вызывается для каждой записи, от старых к новым
+    typedef void (*RingCallback)(uint32_t seq, const uint8_t* data, size_t len, void* arg);
+
+    // Открытый журнал: геометрия и положение головы
+    struct RingState {
+        const char* path;
+        RingHeader  header;
+        uint32_t    slots;          // всего слотов
+        uint32_t    head;           // слот последней записи
+        uint32_t    seq;            // номер последней записи, 0 — журнал пуст
+    };
+
+    // Файл сегмента: PATH для первого, PATH.N для остальных
+    inline bool _ringSegmentPath(const char* path, uint16_t segment, char* out, size_t len) {
+        size_t n = segment ? snprintf(out, len, "%s.%u", path, (unsigned)segment) : snprintf(out, len, "%s", path);
+        return n < len;
+    }
+
+    inline uint32_t _ringCrc(const RingSlot& slot, const uint8_t* data) {
+        return _crc32(data, slot.len, _crc32(&slot, offsetof(RingSlot, crc)));
+    }
+
+    // Чтение слотов с одним открытым сегментом
+    class RingCursor {
+    public:
+        explicit RingCursor(RingState& ring) : _ring(ring), _segment(0xFFFF) {}
+
+        // Чтение слота index; false если слот пуст или повреждён
+        bool read(uint32_t index, RingSlot& slot, uint8_t* data) {
+            uint16_t segment = index / _ring.header.slotsPerSegment;
+            if (segment != _segment) {
+                _file.close();
+                char path[BUSYBOX_RING_PATH];
+                _segment = segment;
+                if (!_ringSegmentPath(_ring.path, segment, path, sizeof(path))) return false;
+                _file = _open(BUSYBOX_FS, path, "r");
+            }
+            uint32_t offset = sizeof(RingHeader) + (index % _ring.header.slotsPerSegment) * _ring.header.slotSize;
+            if (!_file || !_file.seek(offset) || _read(_file, (uint8_t*)&slot, sizeof(slot)) != sizeof(slot) ||
+                !slot.seq || slot.len > _ring.header.slotSize - sizeof(slot) ||
+                _read(_file, data, slot.len) != slot.len) return false;
+            return slot.crc == _ringCrc(slot, data);
+        }
+
+        // Номер записи в слоте, 0 если слот пуст или повреждён
+        uint32_t seq(uint32_t index) {
+            RingSlot slot;
+            uint8_t data[BUSYBOX_RING_SLOT_MAX];
+            return read(index, slot, data) ? slot.seq : 0;
+        }
+
+    private:
+        RingState& _ring;
+        File       _file;
+        uint16_t   _segment;
+    };
+
+    // Открытие журнала и поиск головы; false если PATH не кольцевой журнал
+    inline bool _ringOpen(const char* path, RingState& ring) {
+        ring.path = path;
+        ring.seq = 0;
+        ring.head = 0;
+        File file = _open(BUSYBOX_FS, path, "r");
+        if (!file || file.isDirectory()) return false;
+        RingHeader& h = ring.header;
+        bool ok = _read(file, (uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+                  h.magic == BUSYBOX_RING_MAGIC && h.version == BUSYBOX_RING_VERSION &&
+                  h.slotSize > sizeof(RingSlot) && h.slotSize <= BUSYBOX_RING_SLOT_MAX &&
+                  h.slotsPerSegment && h.segments;
+        file.close();
+        if (!ok) return false;
+        ring.slots = (uint32_t)h.slotsPerSegment * h.segments;
+
+        // Повреждённым может быть только один слот — тот, что писался при потере питания
+        RingCursor cursor(ring);
+        uint32_t first = 0;
+        uint32_t base = cursor.seq(0);
+        if (!base && ring.slots > 1) {
+            first = 1;
+            base = cursor.seq(1);
+        }
+        if (!base) return true;     // пусто
+
+        // Слоты [first, head] содержат seq >= base, после головы — старше или пусты
+        uint32_t lo = first;
+        uint32_t hi = ring.slots - 1;
+        while (lo < hi) {
+            uint32_t mid = lo + (hi - lo + 1) / 2;
+            if (cursor.seq(mid) >= base) lo = mid;
+            else hi = mid - 1;
+        }
+        ring.head = lo;
+        ring.seq = cursor.seq(lo);
+        return true;
+    }
+
+    // Обход последних count записей (0 — всех) от старых к новым
+    inline uint32_t _ringWalk(RingState& ring, uint32_t count, RingCallback callback, void* arg) {
+        if (!ring.seq) return 0;
+        if (!count || count > ring.slots) count = ring.slots;
+        if (count > ring.seq) count = ring.seq;
+
+        RingCursor cursor(ring);
+        RingSlot slot;
+        uint8_t data[BUSYBOX_RING_SLOT_MAX];
+
+        // Начало: самая старая из сохранившихся подряд записей в пределах count
+        uint32_t start = ring.head;
+        uint32_t found = 1;
+        while (found < count) {
+            uint32_t prev = start ? start - 1 : ring.slots - 1;
+            if (!cursor.read(prev, slot, data) || slot.seq != ring.seq - found) break;
+            start = prev;
+            found++;
+            yield();
+        }
+
+        uint32_t done = 0;
+        for (uint32_t i = 0, index = start; i < found; i++, index = (index + 1) % ring.slots) {
+            if (!cursor.read(index, slot, data)) continue;
+            callback(slot.seq, data, slot.len, arg);
+            done++;
+        }
+        return done;
+    }
+
+    inline void _ringPrint(uint32_t, const uint8_t* data, size_t len, void*) {
+        Serial.write(data, len);
+        if (!len || data[len - 1] != '\n') Serial.println();
+    }
+
+    // Журнал ли PATH (для cat)
+    inline bool _ringOwns(const char* path) {
+        File file = _open(BUSYBOX_FS, path, "r");
+        uint32_t magic = 0;
+        bool ok = file && !file.isDirectory() &&
+                  _read(file, (uint8_t*)&magic, sizeof(magic)) == sizeof(magic) && magic == BUSYBOX_RING_MAGIC;
+        file.close();
+        return ok;
+    }
+
+    // То же по уже открытому файлу (cat не открывает его второй раз); позиция возвращается в начало
+    inline bool _ringOwns(File& file) {
+        uint32_t magic = 0;
+        bool ok = !file.isDirectory() &&
+                  _read(file, (uint8_t*)&magic, sizeof(magic)) == sizeof(magic) && magic == BUSYBOX_RING_MAGIC;
+        file.seek(0);
+        return ok;
+    }
+
+    inline bool _ringOwns(const MapView& view) {
+        uint32_t magic = 0;
+        if (view.size >= sizeof(magic)) memcpy(&magic, view.data, sizeof(magic));
+        return magic == BUSYBOX_RING_MAGIC;
+    }
+
+    // cat для журнала: все записи от старых к новым
+    inline bool _ringCat(const char* path) {
+        RingState ring;
+        if (!_ringOpen(path, ring)) {
+            Serial.printf("cat: '%s' is damaged\n", path);
+            return false;
+        }
+        Serial.printf("--- %s (ring, %lu records) ---\n", path, (unsigned long)(ring.seq < ring.slots ? ring.seq : ring.slots));
+        _ringWalk(ring, 0, _ringPrint, nullptr);
+        return true;
+    }
+
+    class RingFile {
+    public:
+        /// @param path файл первого сегмента
+        /// @param capacity общий размер журнала, байт (округляется вверх до сегмента)
+        /// @param slotSize размер слота; запись длиннее slotSize - 12 байт обрезается
+        RingFile(const char* path, uint32_t capacity = 16384, uint16_t slotSize = 128)
+            : _capacity(capacity), _slotSize(slotSize), _ready(false), _appends(0), _appendUs(0), _maxUs(0) {
+            _ring.path = path;
+        }
+
+        /// @brief Открытие журнала или создание с заполнением всех сегментов
+        bool begin() {
+            CommandScope _scope("ring");
+            WriteLock _lock;
+            if (!BUSYBOX_FS.exists(_ring.path)) {
+                _ready = _create();
+            } else if (!(_ready = _ringOpen(_ring.path, _ring))) {
+                Serial.printf("ring: '%s' is not a ring log\n", _ring.path);
+            }
+            return _ready;
+        }
+
+        /// @brief Добавление записи на место самой старой
+        bool append(const void* data, size_t len) {
+            CommandScope _scope("ring");
+            WriteLock _lock;
+            if (!_ready) return false;
+            uint32_t t0 = micros();
+
+            uint8_t buffer[BUSYBOX_RING_SLOT_MAX];
+            RingSlot& slot = *(RingSlot*)buffer;
+            size_t room = _ring.header.slotSize - sizeof(RingSlot);
+            slot.seq = _ring.seq + 1;
+            slot.len = len < room ? len : room;
+            slot.reserved = 0;
+            memcpy(buffer + sizeof(RingSlot), data, slot.len);
+            slot.crc = _ringCrc(slot, buffer + sizeof(RingSlot));
+
+            uint32_t index = _ring.seq ? (_ring.head + 1) % _ring.slots : 0;
+            char path[BUSYBOX_RING_PATH];
+            _ringSegmentPath(_ring.path, index / _ring.header.slotsPerSegment, path, sizeof(path));
+            File file = _open(BUSYBOX_FS, path, "r+");
+            size_t n = sizeof(RingSlot) + slot.len;
+            bool ok = file && file.seek(sizeof(RingHeader) + (index % _ring.header.slotsPerSegment) * _ring.header.slotSize) &&
+                      _write(file, buffer, n) == n;
+            file.close();
+            _touched(path, n);
+            if (!ok) {
+                Serial.printf("ring: write to '%s' failed\n", path);
+                return false;
+            }
+            _ring.head = index;
+            _ring.seq = slot.seq;
+
+            uint32_t us = micros() - t0;
+            _appends++;
+            _appendUs += us;
+            if (us > _maxUs) _maxUs = us;
+            return true;
+        }
+
+        bool append(const char* text) {
+            return append(text, strlen(text));
+        }
+
+        /// @brief Последние count записей (0 — все) от старых к новым
+        /// @return число переданных в callback записей
+        uint32_t read(uint32_t count, RingCallback callback, void* arg = nullptr) {
+            CommandScope _scope("ring");
+            ReadLock _lock;
+            return _ready ? _ringWalk(_ring, count, callback, arg) : 0;
+        }
+
+        // Число записей в журнале
+        uint32_t count() const { return _ring.seq < _ring.slots ? _ring.seq : _ring.slots; }
+        // Номер последней записи (растёт на 1 при каждом append)
+        uint32_t seq() const { return _ring.seq; }
+
+        // Вывод геометрии журнала и задержки append
+        void stat() {
+            const RingHeader& h = _ring.header;
+            Serial.printf("ring '%s': %u segments x %u slots of %u bytes, %lu/%lu records, seq %lu\n",
+                          _ring.path, (unsigned)h.segments, (unsigned)h.slotsPerSegment, (unsigned)h.slotSize,
+                          (unsigned long)count(), (unsigned long)_ring.slots, (unsigned long)_ring.seq);
+            if (_appends) {
+                Serial.printf("append: %lu calls, avg %lu us, max %lu us\n", (unsigned long)_appends,
+                              (unsigned long)(_appendUs / _appends), (unsigned long)_maxUs);
+            }
+        }
+
+    private:
+        // Создание всех сегментов: заголовок и пустые слоты
+        bool _create() {
+            RingHeader& h = _ring.header;
+            uint16_t slotSize = _slotSize;
+            if (slotSize <= sizeof(RingSlot)) slotSize = sizeof(RingSlot) + 1;
+            if (slotSize > BUSYBOX_RING_SLOT_MAX) slotSize = BUSYBOX_RING_SLOT_MAX;
+            uint32_t perSegment = (BUSYBOX_RING_SEGMENT - sizeof(RingHeader)) / slotSize;
+            uint32_t segments = (_capacity + BUSYBOX_RING_SEGMENT - 1) / BUSYBOX_RING_SEGMENT;
+            h = {BUSYBOX_RING_MAGIC, BUSYBOX_RING_VERSION, slotSize, (uint16_t)perSegment,
+                 (uint16_t)(segments ? segments : 1), 0, 0};
+            _ring.slots = (uint32_t)h.slotsPerSegment * h.segments;
+            _ring.head = 0;
+            _ring.seq = 0;
+
+            uint8_t zero[64] = {0};
+            uint32_t size = sizeof(RingHeader) + perSegment * slotSize;
+            // Первый сегмент создаётся последним: по нему журнал определяется при открытии
+            for (int s = h.segments - 1; s >= 0; s--) {
+                char path[BUSYBOX_RING_PATH];
+                if (!_ringSegmentPath(_ring.path, s, path, sizeof(path))) {
+                    Serial.printf("ring: path '%s' is too long\n", _ring.path);
+                    return false;
+                }
+                File file = _open(BUSYBOX_FS, path, "w");
+                h.segment = s;
+                bool ok = file && _write(file, (const uint8_t*)&h, sizeof(h)) == sizeof(h);
+                for (uint32_t pos = sizeof(h); ok && pos < size; pos += sizeof(zero)) {
+                    size_t n = size - pos < sizeof(zero) ? size - pos : sizeof(zero);
+                    ok = _write(file, zero, n) == n;
+                }
+                file.close();
+                _touched(path, size);
+                if (!ok) {
+                    Serial.printf("ring: cannot create '%s'\n", path);
+                    return false;
+                }
+                yield();
+            }
+            h.segment = 0;
+            return true;
+        }
+
+        RingState _ring;
+        uint32_t  _capacity;
+        uint16_t  _slotSize;
+        bool      _ready;
+        uint32_t  _appends;
+        uint32_t  _appendUs;
+        uint32_t  _maxUs;
+    };
+
+    // Вывод последних строк текстового файла: поиск начала чтением блоков с конца
+    inline bool _tailText(const char* path, uint16_t lines) {
+        File file = _open(BUSYBOX_FS, path, "r");
+        if (!file || file.isDirectory()) {
+            Serial.printf("tail: cannot open '%s'\n", path);
+            file.close();
+            return false;
+        }
+        uint8_t small[128];
+        CacheBlock block(small, sizeof(small));
+        uint32_t size = file.size();
+        uint32_t start = 0;
+        uint32_t end = size;
+        // Завершающий перевод строки последней строки не считается
+        uint32_t newlines = 0;
+        bool skipLast = true;
+        bool found = false;
+        while (end && !found) {
+            uint32_t pos = end > block.size ? end - block.size : 0;
+            size_t n = end - pos;
+            if (!file.seek(pos) || _read(file, block.data, n) != n) break;
+            for (size_t i = n; i-- > 0;) {
+                if (block.data[i] != '\n') {
+                    skipLast = false;
+                    continue;
+                }
+                if (skipLast) {
+                    skipLast = false;
+                    continue;
+                }
+                if (++newlines == lines) {
+                    start = pos + i + 1;
+                    found = true;
+                    break;
+                }
+            }
+            end = pos;
+            yield();
+        }
+
+        Serial.printf("--- %s ---\n", path);
+        file.seek(start);
+        {
+            BlockReader reader(file);
+            size_t len;
+            while (const uint8_t* buf = reader.next(len)) {
+                Serial.write(buf, len);
+                delay(0);
+            }
+        }
+        Serial.println();
+        file.close();
+        return true;
+    }
+
+    /// @brief Последние строки файла или записи кольцевого журнала
+    /// @param path текстовый файл или первый сегмент RingFile
+    /// @param lines число строк (записей)
+    inline bool tail(const char* path, uint16_t lines = 10) {
+        CommandScope _scope("tail");
+        ReadLock _lock;
+        if (!lines) return true;
+        RingState ring;
+        if (_ringOwns(path)) {
+            if (!_ringOpen(path, ring)) {
+                Serial.printf("tail: '%s' is damaged\n", path);
+                return false;
+            }
+            Serial.printf("--- %s (ring, last %u) ---\n", path, (unsigned)lines);
+            _ringWalk(ring, lines, _ringPrint, nullptr);
+            return true;
+        }
+        return _tailText(path, lines);
+    }
+
+} // namespace Busybox
+
+#endif
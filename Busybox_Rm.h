@@ -0,0 +1,166 @@
+#ifndef BUSYBOX_RM_H
+#define BUSYBOX_RM_H
+
+#include "Busybox_Common.h"
+#include <time.h>
+
+// rmglob: удаление файлов по маске за один проход по директории. Отдельное имя,
+// а не перегрузка rm: rm(path, ...) с переменным числом путей принял бы и маску.
+//
+// Маска допускается только в последнем компоненте пути: "/logs/*.old",
+// "/data/log-202[0-4]*". Поддерживаются * (любая последовательность),
+// ? (один символ) и [abc], [a-z], [!a-z]. Поддиректории не затрагиваются.
+// Путь к каждому файлу собирается в одном буфере: префикс директории
+// копируется один раз, меняется только имя.
+
+// Максимальная длина пути удаляемого файла
+#ifndef BUSYBOX_RM_PATH
+#define BUSYBOX_RM_PATH 128
+#endif
+
+namespace Busybox {
+
+    // Один элемент маски (символ, ?, [...]) против символа c;
+    // указатель за элементом или nullptr, если не совпал
+    inline const char* _globOne(const char* p, char c) {
+        if (*p == '?') return p + 1;
+        if (*p == '[') {
+            const char* q = p + 1;
+            bool negate = *q == '!' || *q == '^';
+            if (negate) q++;
+            bool hit = false;
+            bool first = true;
+            // ']' сразу после '[' — обычный символ
+            while (*q && (first || *q != ']')) {
+                first = false;
+                if (q[1] == '-' && q[2] && q[2] != ']') {
+                    if ((uint8_t)c >= (uint8_t)q[0] && (uint8_t)c <= (uint8_t)q[2]) hit = true;
+                    q += 3;
+                } else {
+                    if (c == *q) hit = true;
+                    q++;
+                }
+            }
+            // Незакрытая скобка — обычный символ
+            if (*q != ']') return c == '[' ? p + 1 : nullptr;
+            return hit != negate ? q + 1 : nullptr;
+        }
+        return *p && *p == c ? p + 1 : nullptr;
+    }
+
+    /// @brief Сравнение имени с маской (*, ?, [...]) без рекурсии
+    inline bool _globMatch(const char* pattern, const char* name) {
+        const char* star = nullptr;     // элемент маски после последней *
+        const char* resume = nullptr;   // позиция имени, с которой её продолжить
+        while (*name) {
+            if (*pattern == '*') {
+                star = ++pattern;
+                resume = name;
+                continue;
+            }
+            const char* next = _globOne(pattern, *name);
+            if (next) {
+                pattern = next;
+                name++;
+            } else if (star) {
+                pattern = star;
+                name = ++resume;
+            } else {
+                return false;
+            }
+        }
+        while (*pattern == '*') pattern++;
+        return !*pattern;
+    }
+
+    /// @brief Удаление файлов по маске с условиями на возраст и размер
+    /// @param pattern путь с маской в последнем компоненте ("/logs/*.old")
+    /// @param filter условия; RmFilter() — все подходящие по маске
+    /// @param report если не nullptr, сюда копируются итоги
+    /// @return число удалённых файлов (при dryRun — 0, подходящие в report->matched)
+    inline uint32_t rmglob(const char* pattern, const RmFilter& filter, RmReport* report) {
+        CommandScope _scope("rmglob");
+        WriteLock _lock;
+        RmReport r = {0, 0, 0, 0};
+        if (report) *report = r;
+
+        const char* slash = strrchr(pattern, '/');
+        const char* mask = slash ? slash + 1 : pattern;
+        size_t dirLen = slash ? slash - pattern : 0;
+        char path[BUSYBOX_RM_PATH];
+        if (dirLen + 2 > sizeof(path)) {
+            Serial.printf("rmglob: path '%s' is too long\n", pattern);
+            return 0;
+        }
+        memcpy(path, pattern, dirLen);
+        path[dirLen] = '\0';
+        if (strpbrk(path, "*?[")) {
+            Serial.printf("rmglob: '%s': mask is allowed only in the file name\n", pattern);
+            return 0;
+        }
+
+        File root = _open(BUSYBOX_FS, dirLen ? path : "/");
+        if (!root || !root.isDirectory()) {
+            Serial.printf("rmglob: cannot open directory of '%s'\n", pattern);
+            return 0;
+        }
+
+        // Префикс "DIR/" общий для всех файлов, дальше дописывается только имя
+        path[dirLen] = '/';
+        char* name = path + dirLen + 1;
+        size_t room = sizeof(path) - dirLen - 1;
+
+        // Возраст проверяется, только если часы установлены (после 2020 года)
+        uint32_t now = time(nullptr);
+        bool clock = now > 1577836800UL;
+
+        while (File file = _next(root)) {
+            if (file.isDirectory()) continue;
+            const char* entry = file.name();
+            const char* sep = strrchr(entry, '/');
+            if (sep) entry = sep + 1;
+            if (!_globMatch(mask, entry)) continue;
+
+            uint32_t size = file.size();
+            uint32_t lastWrite = file.getLastWrite();
+            if (filter.minSize && size < filter.minSize) continue;
+            if (filter.maxSize && size > filter.maxSize) continue;
+            // Без часов или времени записи возраст неизвестен: такие файлы не удаляются
+            if (filter.minAge && (!clock || !lastWrite || lastWrite > now || now - lastWrite < filter.minAge)) continue;
+
+            r.matched++;
+            size_t len = strlen(entry);
+            if (len >= room) {
+                r.failed++;
+                continue;
+            }
+            memcpy(name, entry, len + 1);
+            file.close();
+
+            if (filter.dryRun) {
+                r.bytes += size;
+                continue;
+            }
+            if (_remove(BUSYBOX_FS, path)) {
+                _touched(path, 0, ChangeOp::Remove);
+                r.removed++;
+                r.bytes += size;
+            } else {
+                r.failed++;
+            }
+            yield();
+        }
+        root.close();
+
+        Serial.printf("rmglob: '%s': %lu files, %lu bytes %s", pattern, (unsigned long)(filter.dryRun ? r.matched : r.removed),
+                      (unsigned long)r.bytes, filter.dryRun ? "would be freed" : "freed");
+        if (r.failed) Serial.printf(", %lu failed", (unsigned long)r.failed);
+        Serial.println();
+
+        if (report) *report = r;
+        return r.removed;
+    }
+
+} // namespace Busybox
+
+#endif
@@ -3,27 +3,41 @@
 
 #include <FS.h>
 #include <SPIFFS.h>
+#include "Busybox_Common.h"
+#include "Busybox_Stats.h"
+#include "Busybox_Cache.h"
+
+// Объект файловой системы для общих модулей
+#define BUSYBOX_FS SPIFFS
 
 #pragma message("++++++++++++++++++++++ Using SPIFFS file system ++++++++++++++++++")
 
 namespace Busybox {
     
-    bool _spiffNotSupported(const char * fn){
+    inline bool _spiffNotSupported(const char * fn){
         Serial.print("SPIFFS does not support ");
         Serial.println(fn);
         return false;
     }
 
-    bool begin(bool formatOnFail = false) {
+    inline bool begin(bool formatOnFail = false) {
         return SPIFFS.begin(formatOnFail);
     }
 
-    bool format() {
+    inline bool format() {
+        WriteLock _lock;
         return SPIFFS.format();
     }
 
-    void ls(const char* path = "/") {
-        File root = SPIFFS.open(path);
+#if BUSYBOX_HAS(LS)
+    inline void ls(const char* path = "/") {
+        CommandScope _scope("ls");
+        ReadLock _lock;
+        if (_packOwns(path)) {
+            _packLs(path);
+            return;
+        }
+        File root = _open(SPIFFS, path);
         if (!root) {
             Serial.printf("ls: cannot access '%s'\n", path);
             return;
@@ -34,7 +48,7 @@ namespace Busybox {
             return;
         }
 
-        File file = root.openNextFile();
+        File file = _next(root);
         while (file) {
             String fullPath = file.name();
             
@@ -46,13 +60,17 @@ namespace Busybox {
             }
             
             file.close();
-            file = root.openNextFile();
+            file = _next(root);
         }
         root.close();
     }
+#endif
 
-    bool rm(const char* path) {
-        if (SPIFFS.remove(path)) {
+    inline bool rm(const char* path) {
+        CommandScope _scope("rm");
+        WriteLock _lock;
+        if (_remove(SPIFFS, path)) {
+            _touched(path, 0, ChangeOp::Remove);
             Serial.printf("rm: '%s' removed\n", path);
             return true;
         } else {
@@ -61,11 +79,13 @@ namespace Busybox {
         }
     }
 
-    uint8_t rm(const char* firstPath, const char* secondPath, ...) {
+    inline uint32_t rm(const char* firstPath, const char* secondPath, ...) {
+        CommandScope _scope("rm");
+        WriteLock _lock;
         va_list args;
         const char* path = firstPath;
-        uint8_t deleted = 0;
-        uint8_t total = 1;
+        uint32_t deleted = 0;
+        uint32_t total = 1;
 
         bool allSuccess = rm(firstPath);
         deleted += allSuccess;
@@ -85,28 +105,57 @@ namespace Busybox {
         
         va_end(args);
         if (deleted > 1)
-            Serial.printf("rm: %d files deleted from %d\n", deleted, total);
+            Serial.printf("rm: %lu files deleted from %lu\n", (unsigned long)deleted, (unsigned long)total);
         return deleted;
     }
 
-    bool cat(const char* path) {
-        File file = SPIFFS.open(path, "r");
+#if BUSYBOX_HAS(CAT)
+    inline bool cat(const char* path) {
+        CommandScope _scope("cat");
+        ReadLock _lock;
+        // Признак кольцевого журнала читается из уже открытого файла или отображения
+        MapView view = map(path, false);
+        if (view && _ringOwns(view)) {
+            unmap(view);
+            return _ringCat(path);
+        }
+        if (view) {
+            Serial.printf("--- %s ---\n", path);
+            Serial.write(view.data, view.size);
+            Serial.println();
+            unmap(view);
+            return true;
+        }
+
+        File file = _open(SPIFFS, path, "r");
         if (!file) {
             Serial.printf("cat: cannot open '%s'\n", path);
             return false;
         }
+        if (_ringOwns(file)) {
+            file.close();
+            return _ringCat(path);
+        }
 
         Serial.printf("--- %s ---\n", path);
-        while (file.available()) {
-            Serial.write(file.read());
+        {
+            BlockReader reader(file);
+            size_t len;
+            while (const uint8_t* buf = reader.next(len)) {
+                Serial.write(buf, len);
+            }
         }
         Serial.println();
         file.close();
         return true;
     }
+#endif
 
-    bool dump(const char* path, uint8_t bytesPerLine = 16) {
-        File file = SPIFFS.open(path, "r");
+#if BUSYBOX_HAS(DUMP)
+    inline bool dump(const char* path, uint8_t bytesPerLine = 16) {
+        CommandScope _scope("dump");
+        ReadLock _lock;
+        File file = _open(SPIFFS, path, "r");
         if (!file) {
             Serial.printf("dump: cannot open '%s'\n", path);
             return false;
@@ -115,12 +164,13 @@ namespace Busybox {
         Serial.printf("Hex dump of '%s' (%d bytes):\n", path, file.size());
         
         size_t offset = 0;
-        while (file.available()) {
+        BlockReader reader(file);
+        while (reader.available()) {
             Serial.printf("%08X: ", offset);
             
             for (uint8_t i = 0; i < bytesPerLine; i++) {
-                if (file.available()) {
-                    uint8_t b = file.read();
+                if (reader.available()) {
+                    uint8_t b = reader.read();
                     Serial.printf("%02X ", b);
                     offset++;
                 } else {
@@ -134,9 +184,14 @@ namespace Busybox {
         file.close();
         return true;
     }
+#endif
 
-    bool mv(const char* oldPath, const char* newPath) {
-        if (SPIFFS.rename(oldPath, newPath)) {
+    inline bool mv(const char* oldPath, const char* newPath) {
+        CommandScope _scope("mv");
+        WriteLock _lock;
+        if (_rename(SPIFFS, oldPath, newPath)) {
+            _touched(oldPath, 0, ChangeOp::MoveFrom);
+            _touched(newPath, 0, ChangeOp::MoveTo);
             Serial.printf("mv: '%s' -> '%s'\n", oldPath, newPath);
             return true;
         } else {
@@ -145,113 +200,182 @@ namespace Busybox {
         }
     }
 
-    bool cp(const char* sourcePath, const char* destPath) {
-        File source = SPIFFS.open(sourcePath, "r");
-        if (!source) {
-            Serial.printf("cp: cannot open source '%s'\n", sourcePath);
-            return false;
+    inline bool cp(const char* sourcePath, const char* destPath) {
+        CommandScope _scope("cp");
+        WriteLock _lock;
+        // Отображённый источник копируется одной записью
+        MapView view = map(sourcePath, false);
+        File source;
+        if (!view) {
+            source = _open(SPIFFS, sourcePath, "r");
+            if (!source) {
+                Serial.printf("cp: cannot open source '%s'\n", sourcePath);
+                return false;
+            }
         }
 
-        File dest = SPIFFS.open(destPath, "w");
+        File dest = _open(SPIFFS, destPath, "w");
         if (!dest) {
             Serial.printf("cp: cannot create '%s'\n", destPath);
+            unmap(view);
             source.close();
             return false;
         }
 
         size_t bytesCopied = 0;
-        uint8_t buffer[128];
-        while (source.available()) {
-            size_t bytesRead = source.read(buffer, sizeof(buffer));
-            dest.write(buffer, bytesRead);
-            bytesCopied += bytesRead;
+        size_t expected = 0;
+        bool ok = true;
+        if (view) {
+            expected = view.size;
+            bytesCopied = _write(dest, view.data, view.size);
+            unmap(view);
+        } else {
+            expected = source.size();
+            BlockReader reader(source);
+            BlockWriter writer(dest);
+            size_t bytesRead;
+            while (const uint8_t* buffer = reader.next(bytesRead)) {
+                if (writer.write(buffer, bytesRead) != bytesRead) break;
+            }
+            ok = writer.flush();
+            bytesCopied = dest.position();
         }
 
         source.close();
         dest.close();
+        _touched(destPath, bytesCopied);
+        if (!ok || bytesCopied != expected) {
+            Serial.printf("cp: copy of '%s' failed at offset %d\n", sourcePath, bytesCopied);
+            return false;
+        }
         Serial.printf("cp: '%s' -> '%s' (%d bytes)\n", sourcePath, destPath, bytesCopied);
         return true;
     }
 
-    bool mkdir(const char* path) {
+    inline bool mkdir(const char* path) {
+        CommandScope _scope("mkdir");
+        WriteLock _lock;
         // SPIFFS не поддерживает директории, но оставляем для совместимости
         //Serial.println("mkdir: SPIFFS does not support directories ");
         return  _spiffNotSupported("directories"); //false;
     }
 
-    bool rmdir(const char* path, bool force = false) {
+    inline bool rmdir(const char* path, bool force = false) {
+        CommandScope _scope("rmdir");
+        WriteLock _lock;
         return _spiffNotSupported("directories");
         // SPIFFS не поддерживает директории
         // Serial.println("rmdir: SPIFFS does not support directories");
         // return false;
     }
 
-    bool write(const char* path, const char* content) {
-        File file = SPIFFS.open(path, "w");
+    inline bool write(const char* path, const char* content) {
+        CommandScope _scope("write");
+        WriteLock _lock;
+        File file = _open(SPIFFS, path, "w");
         if (!file) {
             Serial.printf("write: cannot create '%s'\n", path);
             return false;
         }
 
-        size_t bytesWritten = file.print(content);
+        size_t bytesWritten = _write(file, content);
         file.close();
+        _touched(path, bytesWritten);
 
         bool success = (bytesWritten == strlen(content));
         Serial.printf("write: %d bytes to '%s' %s\n", bytesWritten, path, success ? "OK" : "FAILED");
         return success;
     }
 
-    bool append(const char* path, const char* content) {
-        File file = SPIFFS.open(path, "a");
+    inline bool append(const char* path, const char* content) {
+        CommandScope _scope("append");
+        WriteLock _lock;
+        File file = _open(SPIFFS, path, "a");
         if (!file) {
             Serial.printf("append: cannot open '%s'\n", path);
             return false;
         }
 
-        size_t bytesWritten = file.print(content);
+        size_t bytesWritten = _write(file, content);
         file.close();
+        _touched(path, bytesWritten, ChangeOp::Append);
 
         bool success = (bytesWritten == strlen(content));
         Serial.printf("append: %d bytes to '%s' %s\n", bytesWritten, path, success ? "OK" : "FAILED");
         return success;
     }
 
-    bool stat(const char* path) {
-        if (SPIFFS.exists(path)) {
-            File file = SPIFFS.open(path, "r");
-            if (file) {
-                Serial.printf("File: %s\n", path);
-                Serial.printf("Size: %d bytes\n", file.size());
-                file.close();
-                return true;
-            }
+    inline bool stat(const char* path, FileStat& st) {
+        CommandScope _scope("stat");
+        ReadLock _lock;
+        if (_packOwns(path)) return _packStat(path, st);
+        if (!SPIFFS.exists(path)) return false;
+        File file = _open(SPIFFS, path, "r");
+        if (!file) return false;
+        st.isDir = false;
+        st.size = file.size();
+        st.lastWrite = file.getLastWrite();
+        file.close();
+        return true;
+    }
+
+    inline bool stat(const char* path) {
+        FileStat st;
+        if (!stat(path, st)) {
+            Serial.printf("stat: '%s' not found\n", path);
+            return false;
         }
-        Serial.printf("stat: '%s' not found\n", path);
-        return false;
+        Serial.printf("File: %s\n", path);
+        Serial.printf("Size: %d bytes\n", st.size);
+        return true;
     }
 
-    void df() {
+    inline bool df(FsInfo& info) {
 #if defined(ARDUINO_ARCH_ESP8266)
         FSInfo fs_info;
-        if (SPIFFS.info(fs_info)) {
-            Serial.println("SPIFFS info:");
-            Serial.printf("Total: %d bytes\n", fs_info.totalBytes);
-            Serial.printf("Used:  %d bytes\n", fs_info.usedBytes);
-            Serial.printf("Free:  %d bytes\n", fs_info.totalBytes - fs_info.usedBytes);
-        } else {
+        if (!SPIFFS.info(fs_info)) return false;
+        info.totalBytes = fs_info.totalBytes;
+        info.usedBytes = fs_info.usedBytes;
+#else
+        info.totalBytes = SPIFFS.totalBytes();
+        info.usedBytes = SPIFFS.usedBytes();
+#endif
+        info.freeBytes = info.totalBytes - info.usedBytes;
+        return true;
+    }
+
+    inline void df() {
+        FsInfo info;
+        if (!df(info)) {
             Serial.println("df: failed to get SPIFFS info");
+            return;
         }
+#if defined(ARDUINO_ARCH_ESP8266)
+        Serial.println("SPIFFS info:");
+        Serial.printf("Total: %d bytes\n", info.totalBytes);
+        Serial.printf("Used:  %d bytes\n", info.usedBytes);
+        Serial.printf("Free:  %d bytes\n", info.freeBytes);
 #elif defined(ARDUINO_ARCH_ESP32)
         Serial.printf("SPIFFS total: %d, used: %d\n", 
-                     SPIFFS.totalBytes(), SPIFFS.usedBytes());
+                     info.totalBytes, info.usedBytes);
 #endif
     }
 
-    void tree(const char* path = "/", uint8_t levels = 0, uint8_t indent = 0) {
+#if BUSYBOX_HAS(TREE)
+    inline void tree(const char* path = "/", uint8_t levels = 0, uint8_t indent = 0) {
+        CommandScope _scope("tree");
+        ReadLock _lock;
+        if (_packOwns(path)) {
+            _packTree(path, levels, indent);
+            return;
+        }
         // SPIFFS не поддерживает директории, поэтому tree = ls
         _spiffNotSupported("directory tree");
+#if BUSYBOX_HAS(LS)
         ls(path);
+#endif
     }
+#endif
 
 } // namespace Busybox
 
@@ -0,0 +1,509 @@
+#ifndef BUSYBOX_SNAPSHOT_H
+#define BUSYBOX_SNAPSHOT_H
+
+#include <new>
+#include "Busybox_Common.h"
+#include "Busybox_Util.h"
+#include "Busybox_Walk.h"
+
+// Снимок дерева директорий и сравнение снимков для инкрементальной синхронизации.
+//
+// Манифест (little-endian):
+//   SnapshotHeader
+//   записи, отсортированные по (hash, path):
+//     uint32_t hash; uint32_t size; uint32_t crc; uint8_t pathLen; char path[pathLen]
+//
+// Сортировка по хешу пути позволяет сравнивать два манифеста одним проходом
+// слиянием: в памяти одновременно только по одной записи из каждого.
+// При построении снимка записи пишутся в промежуточный файл, в памяти — индекс
+// {hash, смещение} (8 байт на файл) не более чем на BUSYBOX_SNAPSHOT_FILES
+// файлов. Если файлов больше, каждая такая порция сортируется в серию OUT.runN,
+// а серии сливаются по BUSYBOX_SNAPSHOT_FANIN за проход, как в sort.
+
+// Число файлов в одной отсортированной серии
+#ifndef BUSYBOX_SNAPSHOT_FILES
+#define BUSYBOX_SNAPSHOT_FILES 512
+#endif
+
+// Число серий, сливаемых за один проход
+#ifndef BUSYBOX_SNAPSHOT_FANIN
+#define BUSYBOX_SNAPSHOT_FANIN 4
+#endif
+
+#define BUSYBOX_SNAPSHOT_MAGIC   0x4E534242     // "BBSN"
+#define BUSYBOX_SNAPSHOT_VERSION 1
+
+// Промежуточные файлы: неотсортированные записи и снимок живой директории для diff
+#define BUSYBOX_SNAPSHOT_UNSORTED ".unsorted"
+#define BUSYBOX_SNAPSHOT_LIVE     ".live"
+#define BUSYBOX_SNAPSHOT_RUN      ".run"
+
+namespace Busybox {
+
+    struct SnapshotHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t reserved;
+        uint32_t count;
+    };
+
+    // Запись манифеста
+    struct ManifestEntry {
+        uint32_t hash;          // FNV-1a пути
+        uint32_t size;
+        uint32_t crc;           // CRC-32 содержимого
+        char     path[BUSYBOX_WALK_PATH];
+    };
+
+    enum class DiffOp : uint8_t {
+        Added,
+        Removed,
+        Modified
+    };
+
+    // Итоги сравнения
+    struct DiffReport {
+        uint32_t added;
+        uint32_t removed;
+        uint32_t modified;
+        uint32_t unchanged;
+    };
+
+    // Вызывается для каждой различающейся записи; entry — из нового снимка (для Removed — из старого)
+    typedef void (*DiffCallback)(DiffOp op, const ManifestEntry& entry, void* arg);
+
+    struct SnapshotIndex {
+        uint32_t hash;
+        uint32_t offset;        // смещение записи в промежуточном файле
+    };
+
+    // Последовательное чтение записей манифеста
+    class ManifestReader {
+    public:
+        explicit ManifestReader(File& file) : _reader(file), _left(0) {}
+
+        bool begin() {
+            SnapshotHeader h;
+            if (_reader.read((uint8_t*)&h, sizeof(h)) != sizeof(h) ||
+                h.magic != BUSYBOX_SNAPSHOT_MAGIC || h.version != BUSYBOX_SNAPSHOT_VERSION) return false;
+            _left = h.count;
+            return true;
+        }
+
+        bool next(ManifestEntry& e) {
+            if (!_left) return false;
+            _left--;
+            return _readEntry(_reader, e);
+        }
+
+        // Чтение одной записи; используется и для промежуточного файла
+        template <typename Reader>
+        static bool _readEntry(Reader& r, ManifestEntry& e) {
+            uint8_t len;
+            if (r.read((uint8_t*)&e, 12) != 12 || r.read(&len, 1) != 1 || len >= BUSYBOX_WALK_PATH) return false;
+            if (r.read((uint8_t*)e.path, len) != len) return false;
+            e.path[len] = '\0';
+            return true;
+        }
+
+    private:
+        BlockReader _reader;
+        uint32_t    _left;
+    };
+
+    inline size_t _snapshotPut(BlockWriter& w, const ManifestEntry& e) {
+        uint8_t len = strlen(e.path);
+        return w.write((const uint8_t*)&e, 12) + w.write(&len, 1) + w.write((const uint8_t*)e.path, len);
+    }
+
+    // Порядок записей манифеста: по хешу, при совпадении — по пути
+    inline int _snapshotCompare(const ManifestEntry& a, const ManifestEntry& b) {
+        if (a.hash != b.hash) return a.hash < b.hash ? -1 : 1;
+        return strcmp(a.path, b.path);
+    }
+
+    // Сравнение записей промежуточного файла (пути читаются только при совпадении хешей)
+    inline bool _snapshotLess(File& scratch, const SnapshotIndex& a, const SnapshotIndex& b) {
+        if (a.hash != b.hash) return a.hash < b.hash;
+        ManifestEntry ea, eb;
+        scratch.seek(a.offset);
+        ManifestReader::_readEntry(scratch, ea);
+        scratch.seek(b.offset);
+        ManifestReader::_readEntry(scratch, eb);
+        return strcmp(ea.path, eb.path) < 0;
+    }
+
+    // CRC-32 содержимого файла
+    inline uint32_t _snapshotCrc(File& file) {
+        uint32_t crc = 0;
+        BlockReader reader(file);
+        size_t len;
+        while (const uint8_t* data = reader.next(len)) {
+            crc = _crc32(data, len, crc);
+            yield();
+        }
+        return crc;
+    }
+
+    // Файл манифеста base или один из его промежуточных файлов
+    inline bool _snapshotOwn(const char* path, const char* base) {
+        static const char* const suffixes[] = {BUSYBOX_SNAPSHOT_LIVE, BUSYBOX_SNAPSHOT_UNSORTED, BUSYBOX_TMP_SUFFIX,
+                                               BUSYBOX_TMP_DONE_SUFFIX};
+        size_t n = strlen(base);
+        if (strncmp(path, base, n) != 0) return false;
+        const char* rest = path + n;
+        while (*rest) {
+            bool matched = false;
+            for (const char* suffix : suffixes) {
+                size_t len = strlen(suffix);
+                if (strncmp(rest, suffix, len) == 0) {
+                    rest += len;
+                    matched = true;
+                    break;
+                }
+            }
+            if (matched) continue;
+            // Серия: .runN
+            if (strncmp(rest, BUSYBOX_SNAPSHOT_RUN, strlen(BUSYBOX_SNAPSHOT_RUN)) != 0) return false;
+            rest += strlen(BUSYBOX_SNAPSHOT_RUN);
+            if (!isdigit((unsigned char)*rest)) return false;
+            while (isdigit((unsigned char)*rest)) rest++;
+        }
+        return true;
+    }
+
+    inline bool _snapshotRunPath(const char* out, uint32_t run, char* path, size_t len) {
+        return (size_t)snprintf(path, len, "%s%s%lu", out, BUSYBOX_SNAPSHOT_RUN, (unsigned long)run) < len;
+    }
+
+    // Сортировка порции промежуточного файла по индексу и запись в dest:
+    // серию без заголовка или, если задан header, готовый манифест
+    inline bool _snapshotSort(fs::FS& fs, const char* scratchPath, SnapshotIndex* index, uint32_t count,
+                              const char* dest, const SnapshotHeader* header) {
+        File scratch = _open(fs, scratchPath, "r");
+        if (!scratch) {
+            Serial.printf("snapshot: cannot open '%s'\n", scratchPath);
+            return false;
+        }
+        // Шелл; записи читаются с диска только при совпадении хешей
+        for (uint32_t gap = count / 2; gap > 0; gap /= 2) {
+            for (uint32_t i = gap; i < count; i++) {
+                SnapshotIndex item = index[i];
+                uint32_t j = i;
+                while (j >= gap && _snapshotLess(scratch, item, index[j - gap])) {
+                    index[j] = index[j - gap];
+                    j -= gap;
+                }
+                index[j] = item;
+            }
+            yield();
+        }
+
+        File file = _open(fs, dest, "w");
+        if (!file) {
+            Serial.printf("snapshot: cannot create '%s'\n", dest);
+            scratch.close();
+            return false;
+        }
+        bool ok = true;
+        {
+            BlockWriter writer(file);
+            if (header) writer.write((const uint8_t*)header, sizeof(*header));
+            ManifestEntry e;
+            for (uint32_t i = 0; i < count && ok; i++) {
+                scratch.seek(index[i].offset);
+                if (!ManifestReader::_readEntry(scratch, e)) ok = false;
+                else _snapshotPut(writer, e);
+            }
+            ok = writer.flush() && ok;
+        }
+        file.close();
+        scratch.close();
+        return ok;
+    }
+
+    // Вход слияния: файл серии и текущая запись
+    struct SnapshotInput {
+        SnapshotInput(fs::FS& fs, const char* path) : file(_open(fs, path, "r")), reader(file), has(false) {}
+        ~SnapshotInput() { file.close(); }
+
+        void advance() { has = ManifestReader::_readEntry(reader, entry); }
+
+        File          file;
+        BlockReader   reader;
+        ManifestEntry entry;
+        bool          has;
+    };
+
+    // Слияние серий [first, first + count) в dest (серию или, если задан header,
+    // манифест); серии удаляются
+    inline bool _snapshotMerge(fs::FS& fs, const char* out, uint32_t first, uint32_t count, const char* dest,
+                               const SnapshotHeader* header) {
+        SnapshotInput* inputs[BUSYBOX_SNAPSHOT_FANIN] = {};
+        char path[BUSYBOX_WALK_PATH];
+        bool ok = true;
+        for (uint32_t i = 0; i < count && ok; i++) {
+            _snapshotRunPath(out, first + i, path, sizeof(path));
+            inputs[i] = new (std::nothrow) SnapshotInput(fs, path);
+            if (!inputs[i]) {
+                Serial.println("snapshot: out of memory");
+                ok = false;
+            } else if (!inputs[i]->file) {
+                Serial.printf("snapshot: cannot open '%s'\n", path);
+                ok = false;
+            } else {
+                inputs[i]->advance();
+            }
+        }
+
+        File file;
+        if (ok) {
+            file = _open(fs, dest, "w");
+            if (!file) {
+                Serial.printf("snapshot: cannot create '%s'\n", dest);
+                ok = false;
+            }
+        }
+        if (ok) {
+            BlockWriter writer(file);
+            if (header) writer.write((const uint8_t*)header, sizeof(*header));
+            while (true) {
+                int best = -1;
+                for (uint32_t i = 0; i < count; i++) {
+                    if (inputs[i]->has &&
+                        (best < 0 || _snapshotCompare(inputs[i]->entry, inputs[best]->entry) < 0)) best = i;
+                }
+                if (best < 0) break;
+                _snapshotPut(writer, inputs[best]->entry);
+                inputs[best]->advance();
+                yield();
+            }
+            ok = writer.flush();
+        }
+        file.close();
+
+        for (uint32_t i = 0; i < count; i++) {
+            delete inputs[i];
+            _snapshotRunPath(out, first + i, path, sizeof(path));
+            _remove(fs, path);
+        }
+        return ok;
+    }
+
+    // Построение манифеста; сами манифесты out и exclude в него не попадают.
+    // Вызывается под WriteLock.
+    inline bool _snapshot(fs::FS& fs, const char* dir, const char* out, const char* exclude, uint32_t& count) {
+        char scratchPath[BUSYBOX_WALK_PATH];
+        char tempPath[BUSYBOX_WALK_PATH];
+        char path[BUSYBOX_WALK_PATH];
+        // Проверка длины по самому длинному имени серии
+        int len = snprintf(scratchPath, sizeof(scratchPath), "%s%s", out, BUSYBOX_SNAPSHOT_UNSORTED);
+        if ((size_t)len >= sizeof(scratchPath) || !_tmpPath(out, tempPath, sizeof(tempPath)) ||
+            !_snapshotRunPath(out, 0xFFFFFFFF, path, sizeof(path))) {
+            Serial.printf("snapshot: path '%s' is too long\n", out);
+            return false;
+        }
+
+        SnapshotIndex* index = (SnapshotIndex*)malloc(BUSYBOX_SNAPSHOT_FILES * sizeof(SnapshotIndex));
+        if (!index) {
+            Serial.println("snapshot: out of memory");
+            return false;
+        }
+
+        // Проход 1: по BUSYBOX_SNAPSHOT_FILES записей в промежуточный файл, каждая
+        // порция сортируется в серию; если порция одна — сразу в манифест
+        count = 0;
+        uint32_t runs = 0;
+        bool ok = true;
+        {
+            TreeWalker walker(fs, "snapshot");
+            if (!walker.begin(dir)) {
+                Serial.printf("snapshot: cannot open directory '%s'\n", dir);
+                ok = false;
+            }
+            bool more = ok;
+            while (ok && more) {
+                File scratch = _open(fs, scratchPath, "w");
+                if (!scratch) {
+                    Serial.printf("snapshot: cannot create '%s'\n", scratchPath);
+                    ok = false;
+                    break;
+                }
+                uint32_t n = 0;
+                {
+                    BlockWriter writer(scratch);
+                    uint32_t offset = 0;
+                    while (n < BUSYBOX_SNAPSHOT_FILES) {
+                        File file = walker.next();
+                        if (!file) {
+                            more = false;
+                            break;
+                        }
+                        if (_snapshotOwn(walker.path(), out) || (exclude && _snapshotOwn(walker.path(), exclude))) {
+                            file.close();
+                            continue;
+                        }
+                        ManifestEntry e;
+                        e.hash = _hash32(walker.path());
+                        e.size = file.size();
+                        e.crc = _snapshotCrc(file);
+                        strcpy(e.path, walker.path());
+                        file.close();
+
+                        index[n].hash = e.hash;
+                        index[n].offset = offset;
+                        n++;
+                        offset += _snapshotPut(writer, e);
+                    }
+                    ok = writer.flush();
+                }
+                scratch.close();
+                count += n;
+                if (!ok || (!n && runs)) break;
+
+                if (!more && !runs) {
+                    SnapshotHeader h = {BUSYBOX_SNAPSHOT_MAGIC, BUSYBOX_SNAPSHOT_VERSION, 0, count};
+                    ok = _snapshotSort(fs, scratchPath, index, n, tempPath, &h);
+                } else {
+                    _snapshotRunPath(out, runs, path, sizeof(path));
+                    ok = _snapshotSort(fs, scratchPath, index, n, path, nullptr);
+                    runs++;
+                }
+            }
+        }
+        _remove(fs, scratchPath);
+        free(index);
+
+        // Проход 2: слияние по BUSYBOX_SNAPSHOT_FANIN серий; последнее слияние пишет манифест
+        uint32_t first = 0;
+        while (ok && runs - first > 0) {
+            uint32_t n = runs - first < BUSYBOX_SNAPSHOT_FANIN ? runs - first : BUSYBOX_SNAPSHOT_FANIN;
+            if (n == runs - first) {
+                SnapshotHeader h = {BUSYBOX_SNAPSHOT_MAGIC, BUSYBOX_SNAPSHOT_VERSION, 0, count};
+                ok = _snapshotMerge(fs, out, first, n, tempPath, &h);
+            } else {
+                _snapshotRunPath(out, runs, path, sizeof(path));
+                ok = _snapshotMerge(fs, out, first, n, path, nullptr);
+                runs++;
+            }
+            first += n;
+            yield();
+        }
+
+        if (ok) {
+            ok = _tmpCommit(fs, out);
+        } else {
+            // Удаление оставшихся серий и незавершённого манифеста
+            for (uint32_t i = first; i < runs; i++) {
+                _snapshotRunPath(out, i, path, sizeof(path));
+                _remove(fs, path);
+            }
+            _remove(fs, tempPath);
+        }
+        return ok;
+    }
+
+    /// @brief Снимок директории: манифест {хеш пути, размер, CRC} всех файлов
+    /// @param dir директория
+    /// @param out файл манифеста (может лежать внутри dir, сам в снимок не попадает)
+    inline bool snapshot(const char* dir, const char* out) {
+        CommandScope _scope("snapshot");
+        WriteLock _lock;
+        uint32_t count = 0;
+        if (!_snapshot(BUSYBOX_FS, dir, out, nullptr, count)) {
+            Serial.printf("snapshot: failed for '%s'\n", dir);
+            return false;
+        }
+        _touched(out);
+        Serial.printf("snapshot: %lu files from '%s' -> '%s'\n", (unsigned long)count, dir, out);
+        return true;
+    }
+
+    inline void _diffPrint(DiffOp op, const ManifestEntry& e, void*) {
+        static const char marks[] = {'+', '-', '~'};
+        Serial.printf("%c %-32s %lu bytes\n", marks[(uint8_t)op], e.path, (unsigned long)e.size);
+    }
+
+    // Сравнение двух манифестов слиянием
+    inline bool _diff(fs::FS& fs, const char* before, const char* after, DiffCallback callback, void* arg, DiffReport& r) {
+        File fa = _open(fs, before, "r");
+        File fb = _open(fs, after, "r");
+        if (!fa || !fb) {
+            Serial.printf("diff: cannot open '%s'\n", !fa ? before : after);
+            return false;
+        }
+        ManifestReader ra(fa);
+        ManifestReader rb(fb);
+        if (!ra.begin() || !rb.begin()) {
+            Serial.println("diff: not a manifest");
+            return false;
+        }
+
+        ManifestEntry a, b;
+        bool hasA = ra.next(a);
+        bool hasB = rb.next(b);
+        while (hasA || hasB) {
+            int cmp = !hasA ? 1 : !hasB ? -1 : _snapshotCompare(a, b);
+            if (cmp < 0) {
+                r.removed++;
+                callback(DiffOp::Removed, a, arg);
+                hasA = ra.next(a);
+            } else if (cmp > 0) {
+                r.added++;
+                callback(DiffOp::Added, b, arg);
+                hasB = rb.next(b);
+            } else {
+                if (a.size != b.size || a.crc != b.crc) {
+                    r.modified++;
+                    callback(DiffOp::Modified, b, arg);
+                } else {
+                    r.unchanged++;
+                }
+                hasA = ra.next(a);
+                hasB = rb.next(b);
+            }
+            yield();
+        }
+        return true;
+    }
+
+    /// @brief Сравнение снимка с другим снимком или с текущим содержимым директории
+    /// @param before манифест, созданный snapshot
+    /// @param after манифест или директория (для директории снимок строится во временный файл)
+    /// @param callback вызывается для каждого отличия; nullptr — вывод в Serial
+    /// @param arg аргумент для callback
+    /// @param report если не nullptr, сюда копируются итоги
+    inline bool diff(const char* before, const char* after, DiffCallback callback = nullptr, void* arg = nullptr,
+              DiffReport* report = nullptr) {
+        CommandScope _scope("diff");
+        WriteLock _lock;
+        DiffReport r = {};
+        if (!callback) callback = _diffPrint;
+
+        File probe = _open(BUSYBOX_FS, after, "r");
+        bool live = probe && probe.isDirectory();
+        probe.close();
+
+        bool ok;
+        if (live) {
+            char livePath[BUSYBOX_WALK_PATH];
+            snprintf(livePath, sizeof(livePath), "%s%s", before, BUSYBOX_SNAPSHOT_LIVE);
+            uint32_t count;
+            ok = _snapshot(BUSYBOX_FS, after, livePath, before, count) &&
+                 _diff(BUSYBOX_FS, before, livePath, callback, arg, r);
+            _remove(BUSYBOX_FS, livePath);
+        } else {
+            ok = _diff(BUSYBOX_FS, before, after, callback, arg, r);
+        }
+
+        if (ok) {
+            Serial.printf("diff: %lu added, %lu removed, %lu modified, %lu unchanged\n", (unsigned long)r.added,
+                          (unsigned long)r.removed, (unsigned long)r.modified, (unsigned long)r.unchanged);
+        }
+        if (report) *report = r;
+        return ok;
+    }
+
+} // namespace Busybox
+
+#endif
@@ -0,0 +1,298 @@
+#ifndef BUSYBOX_STATS_H
+#define BUSYBOX_STATS_H
+
+#include <FS.h>
+#include "Busybox_Common.h"
+#include "Busybox_Lock.h"
+
+// Инструментирование файловых операций.
+// Включается определением BUSYBOX_STATS перед подключением библиотеки:
+//
+//     #define BUSYBOX_STATS
+//     #include <Busybox.h>
+//
+// Без BUSYBOX_STATS обёртки ниже сводятся к прямым вызовам File/FS,
+// а CommandScope — к пустому объекту.
+
+// Максимальное число различных команд в таблице статистики
+#ifndef BUSYBOX_STATS_COMMANDS
+#define BUSYBOX_STATS_COMMANDS 24
+#endif
+
+// Число задач, одновременно выполняющих команды (операции остальных идут в "(other)")
+#ifndef BUSYBOX_STATS_TASKS
+#define BUSYBOX_STATS_TASKS 8
+#endif
+
+namespace Busybox {
+
+    // Отслеживаемые операции файловой системы
+    enum StatOp : uint8_t {
+        OP_OPEN,
+        OP_READ,
+        OP_WRITE,
+        OP_REMOVE,
+        OP_RENAME,
+        OP_NEXT,        // openNextFile
+        OP_COUNT
+    };
+
+    // Счётчики одной команды
+    struct CommandStats {
+        const char* name;
+        uint32_t runs;
+        uint32_t us;                // суммарное время выполнения команды
+        uint32_t calls[OP_COUNT];   // число вызовов каждой операции
+        uint32_t opUs[OP_COUNT];    // суммарное время каждой операции
+        uint32_t bytesRead;
+        uint32_t bytesWritten;
+    };
+
+#ifdef BUSYBOX_STATS
+
+    // Команда, которую выполняет задача: у каждой задачи своя
+    struct StatsTask {
+        void*  task;                // nullptr — слот свободен
+        int8_t current;             // индекс выполняемой команды
+    };
+
+    struct StatsTable {
+        CommandStats commands[BUSYBOX_STATS_COMMANDS];  // [0] — операции вне команд
+        uint8_t   count;
+        StatsTask tasks[BUSYBOX_STATS_TASKS];
+    };
+
+    inline StatsTable& _statsTable() {
+        static StatsTable table = {{{"(other)"}}, 1};
+        return table;
+    }
+
+    // Таблицу меняют команды из разных задач
+#if defined(ARDUINO_ARCH_ESP32)
+    inline portMUX_TYPE& _statsMux() {
+        static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+        return mux;
+    }
+    inline void _statsLock() { portENTER_CRITICAL(&_statsMux()); }
+    inline void _statsUnlock() { portEXIT_CRITICAL(&_statsMux()); }
+#else
+    inline void _statsLock() {}
+    inline void _statsUnlock() {}
+#endif
+
+    // Слот текущей задачи (create — занять свободный); вызывается под _statsLock
+    inline StatsTask* _statsTask(bool create) {
+        StatsTable& t = _statsTable();
+#if defined(ARDUINO_ARCH_ESP32)
+        void* self = xTaskGetCurrentTaskHandle();
+#else
+        void* self = &t;
+#endif
+        for (uint8_t i = 0; i < BUSYBOX_STATS_TASKS; i++) {
+            if (t.tasks[i].task == self) return &t.tasks[i];
+        }
+        if (!create) return nullptr;
+        for (uint8_t i = 0; i < BUSYBOX_STATS_TASKS; i++) {
+            if (!t.tasks[i].task) {
+                t.tasks[i].task = self;
+                t.tasks[i].current = -1;
+                return &t.tasks[i];
+            }
+        }
+        return nullptr;
+    }
+
+    inline int8_t _statsFind(const char* name) {
+        StatsTable& t = _statsTable();
+        for (uint8_t i = 1; i < t.count; i++) {
+            if (t.commands[i].name == name || strcmp(t.commands[i].name, name) == 0) return i;
+        }
+        if (t.count >= BUSYBOX_STATS_COMMANDS) return 0;
+        memset(&t.commands[t.count], 0, sizeof(CommandStats));
+        t.commands[t.count].name = name;
+        return t.count++;
+    }
+
+    inline void _statsOp(uint8_t op, uint32_t us, uint32_t bytesRead = 0, uint32_t bytesWritten = 0) {
+        StatsTable& t = _statsTable();
+        _statsLock();
+        StatsTask* task = _statsTask(false);
+        CommandStats& c = t.commands[task && task->current > 0 ? task->current : 0];
+        c.calls[op]++;
+        c.opUs[op] += us;
+        c.bytesRead += bytesRead;
+        c.bytesWritten += bytesWritten;
+        _statsUnlock();
+    }
+
+    // Учёт времени команды. Вложенные команды (например rm внутри rmrf)
+    // учитываются в самой внешней команде той же задачи.
+    class CommandScope {
+    public:
+        explicit CommandScope(const char* name) : _index(-1) {
+            _statsLock();
+            StatsTask* task = _statsTask(true);
+            if (task && task->current < 0) {
+                _index = _statsFind(name);
+                task->current = _index;
+            }
+            _statsUnlock();
+            _start = micros();
+        }
+
+        ~CommandScope() {
+            if (_index < 0) return;
+            uint32_t us = micros() - _start;
+            StatsTable& t = _statsTable();
+            _statsLock();
+            t.commands[_index].runs++;
+            t.commands[_index].us += us;
+            StatsTask* task = _statsTask(false);
+            if (task) task->task = nullptr;
+            _statsUnlock();
+        }
+
+    private:
+        int8_t   _index;
+        uint32_t _start;
+    };
+
+#else
+
+    class CommandScope {
+    public:
+        explicit CommandScope(const char*) {}
+    };
+
+#endif
+
+    // Обёртки операций файловой системы
+
+    inline File _open(fs::FS& fs, const char* path, const char* mode = "r") {
+#ifdef BUSYBOX_STATS
+        uint32_t t0 = micros();
+        File file = fs.open(path, mode);
+        _statsOp(OP_OPEN, micros() - t0);
+        return file;
+#else
+        return fs.open(path, mode);
+#endif
+    }
+
+    inline size_t _read(File& file, uint8_t* buffer, size_t len) {
+#ifdef BUSYBOX_STATS
+        uint32_t t0 = micros();
+        size_t n = file.read(buffer, len);
+        _statsOp(OP_READ, micros() - t0, n);
+        return n;
+#else
+        return file.read(buffer, len);
+#endif
+    }
+
+    inline int _read(File& file) {
+#ifdef BUSYBOX_STATS
+        uint32_t t0 = micros();
+        int c = file.read();
+        _statsOp(OP_READ, micros() - t0, c >= 0 ? 1 : 0);
+        return c;
+#else
+        return file.read();
+#endif
+    }
+
+    inline size_t _write(File& file, const uint8_t* buffer, size_t len) {
+#ifdef BUSYBOX_STATS
+        uint32_t t0 = micros();
+        size_t n = file.write(buffer, len);
+        _statsOp(OP_WRITE, micros() - t0, 0, n);
+        return n;
+#else
+        return file.write(buffer, len);
+#endif
+    }
+
+    inline size_t _write(File& file, const char* text) {
+        return _write(file, (const uint8_t*)text, strlen(text));
+    }
+
+    inline bool _remove(fs::FS& fs, const char* path) {
+#ifdef BUSYBOX_STATS
+        uint32_t t0 = micros();
+        bool ok = fs.remove(path);
+        _statsOp(OP_REMOVE, micros() - t0);
+        return ok;
+#else
+        return fs.remove(path);
+#endif
+    }
+
+    inline bool _rename(fs::FS& fs, const char* from, const char* to) {
+#ifdef BUSYBOX_STATS
+        uint32_t t0 = micros();
+        bool ok = fs.rename(from, to);
+        _statsOp(OP_RENAME, micros() - t0);
+        return ok;
+#else
+        return fs.rename(from, to);
+#endif
+    }
+
+    inline File _next(File& dir) {
+#ifdef BUSYBOX_STATS
+        uint32_t t0 = micros();
+        File file = dir.openNextFile();
+        _statsOp(OP_NEXT, micros() - t0);
+        return file;
+#else
+        return dir.openNextFile();
+#endif
+    }
+
+    /// @brief Вывод счётчиков по командам (требует BUSYBOX_STATS)
+    /// @param reset обнулить счётчики после вывода
+    inline void stats(bool reset = true) {
+#ifdef BUSYBOX_STATS
+        static const char* const opNames[OP_COUNT] = {"open", "read", "write", "remove", "rename", "next"};
+        StatsTable& t = _statsTable();
+
+        Serial.println("=== Busybox stats ===");
+        Serial.println("Command     Runs   Time us  Read B    Write B   Ops (calls/us)");
+        for (uint8_t i = 0; i < t.count; i++) {
+            const CommandStats& c = t.commands[i];
+            uint32_t ops = 0;
+            for (uint8_t op = 0; op < OP_COUNT; op++) ops += c.calls[op];
+            if (c.runs == 0 && ops == 0) continue;
+
+            Serial.printf("%-10s %5lu %9lu  %-9lu %-9lu", c.name, (unsigned long)c.runs,
+                          (unsigned long)c.us, (unsigned long)c.bytesRead, (unsigned long)c.bytesWritten);
+            for (uint8_t op = 0; op < OP_COUNT; op++) {
+                if (c.calls[op]) {
+                    Serial.printf(" %s %lu/%lu", opNames[op], (unsigned long)c.calls[op], (unsigned long)c.opUs[op]);
+                }
+            }
+            Serial.println();
+        }
+
+        if (reset) {
+            _statsLock();
+            memset(t.commands, 0, sizeof(t.commands));
+            t.commands[0].name = "(other)";
+            t.count = 1;
+            _statsUnlock();
+        }
+#else
+        Serial.println("stats: define BUSYBOX_STATS to enable instrumentation");
+#endif
+
+#if BUSYBOX_LOCK_ENABLED
+        LockStats ls = lockStats(reset);
+        Serial.printf("Lock: %lu reads (wait %lu us), %lu writes (wait %lu us), max wait %lu us\n",
+                      (unsigned long)ls.reads, (unsigned long)ls.readWaitUs,
+                      (unsigned long)ls.writes, (unsigned long)ls.writeWaitUs, (unsigned long)ls.maxWaitUs);
+#endif
+    }
+
+} // namespace Busybox
+
+#endif
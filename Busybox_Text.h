@@ -0,0 +1,499 @@
+#ifndef BUSYBOX_TEXT_H
+#define BUSYBOX_TEXT_H
+
+#include <new>
+#include "Busybox_Common.h"
+#include "Busybox_Util.h"
+
+// Обработка текстовых файлов потоком: wc, uniq и внешняя сортировка sort.
+//
+// Все команды читают файл через BlockReader, так что память не зависит от
+// размера файла. sort набирает строки в буфер BUSYBOX_SORT_MEMORY байт,
+// сортирует и пишет отсортированные серии во временные файлы DST.runN рядом
+// с приёмником, затем сливает их по BUSYBOX_SORT_FANIN за проход. Результат
+// sort и uniq пишется в DST.bbtmp и заменяет DST, так что DST может совпадать
+// с исходным файлом.
+
+// Максимальная длина строки (длинные строки обрезаются)
+#ifndef BUSYBOX_TEXT_LINE
+#define BUSYBOX_TEXT_LINE 256
+#endif
+
+// Буфер серии sort, байт
+#ifndef BUSYBOX_SORT_MEMORY
+#define BUSYBOX_SORT_MEMORY 8192
+#endif
+
+// Число серий, сливаемых за один проход
+#ifndef BUSYBOX_SORT_FANIN
+#define BUSYBOX_SORT_FANIN 4
+#endif
+
+// Максимальная длина пути приёмника (с суффиксом серии)
+#ifndef BUSYBOX_SORT_PATH
+#define BUSYBOX_SORT_PATH 64
+#endif
+
+namespace Busybox {
+
+    // Построчное чтение файла поверх BlockReader; строки без '\n' и '\r'
+    class LineReader {
+    public:
+        explicit LineReader(File& file) : truncated(0), _reader(file), _chunk(nullptr), _left(0) {}
+
+        LineReader(const LineReader&) = delete;
+        LineReader& operator=(const LineReader&) = delete;
+
+        // Следующая строка (с завершающим нулём); nullptr в конце файла
+        const char* next(size_t& len) {
+            len = 0;
+            bool any = false;
+            bool cut = false;
+            while (true) {
+                if (!_left && !(_chunk = _reader.next(_left))) {
+                    if (!any) return nullptr;
+                    break;
+                }
+                any = true;
+                const uint8_t* end = (const uint8_t*)memchr(_chunk, '\n', _left);
+                size_t n = end ? end - _chunk : _left;
+                size_t room = BUSYBOX_TEXT_LINE - len;
+                if (n > room) cut = true;
+                memcpy(_line + len, _chunk, n < room ? n : room);
+                len += n < room ? n : room;
+                _chunk += end ? n + 1 : n;
+                _left -= end ? n + 1 : n;
+                if (end) break;
+            }
+            if (len && _line[len - 1] == '\r') len--;
+            if (cut) truncated++;
+            _line[len] = '\0';
+            return _line;
+        }
+
+        uint32_t truncated;         // число обрезанных строк
+
+    private:
+        BlockReader    _reader;
+        const uint8_t* _chunk;
+        size_t         _left;
+        char           _line[BUSYBOX_TEXT_LINE + 1];
+    };
+
+    // Итоги wc
+    struct WcReport {
+        uint32_t lines;
+        uint32_t words;
+        uint32_t bytes;
+        uint32_t maxLine;           // длина самой длинной строки
+    };
+
+    /// @brief Подсчёт строк, слов и байт (аналог wc)
+    /// @param report если не nullptr, сюда копируются итоги
+    inline bool wc(const char* path, WcReport* report = nullptr) {
+        CommandScope _scope("wc");
+        ReadLock _lock;
+        File file = _open(BUSYBOX_FS, path, "r");
+        if (!file || file.isDirectory()) {
+            Serial.printf("wc: cannot open '%s'\n", path);
+            file.close();
+            return false;
+        }
+
+        WcReport r = {0, 0, 0, 0};
+        uint32_t line = 0;
+        bool inWord = false;
+        {
+            BlockReader reader(file);
+            size_t len;
+            while (const uint8_t* p = reader.next(len)) {
+                const uint8_t* end = p + len;
+                r.bytes += len;
+                while (p < end) {
+                    // Пробелы и слово целиком за один внутренний цикл
+                    if (!inWord) {
+                        while (p < end && isspace(*p)) {
+                            if (*p == '\n') {
+                                r.lines++;
+                                if (line > r.maxLine) r.maxLine = line;
+                                line = 0;
+                            } else {
+                                line++;
+                            }
+                            p++;
+                        }
+                        if (p == end) break;
+                        r.words++;
+                        inWord = true;
+                    }
+                    const uint8_t* word = p;
+                    while (p < end && !isspace(*p)) p++;
+                    line += p - word;
+                    if (p < end) inWord = false;
+                }
+                delay(0);
+            }
+        }
+        file.close();
+        if (line > r.maxLine) r.maxLine = line;
+
+        Serial.printf("wc: %lu lines, %lu words, %lu bytes, longest line %lu  %s\n",
+                      (unsigned long)r.lines, (unsigned long)r.words, (unsigned long)r.bytes,
+                      (unsigned long)r.maxLine, path);
+        if (report) *report = r;
+        return true;
+    }
+
+    // Вывод строки в Serial или файл
+    inline bool _textPut(BlockWriter* writer, const char* line, size_t len) {
+        if (!writer) {
+            Serial.write((const uint8_t*)line, len);
+            Serial.println();
+            return true;
+        }
+        return writer->write((const uint8_t*)line, len) == len && writer->write((const uint8_t*)"\n", 1) == 1;
+    }
+
+    /// @brief Удаление повторяющихся соседних строк (аналог uniq)
+    /// @param dest файл результата (может совпадать с исходным); nullptr — вывод в Serial
+    /// @param counts добавить перед строкой число повторов (uniq -c)
+    inline bool uniq(const char* sourcePath, const char* destPath = nullptr, bool counts = false) {
+        CommandScope _scope("uniq");
+        WriteLock _lock;
+        char tempPath[BUSYBOX_SORT_PATH];
+        if (destPath && !_tmpPath(destPath, tempPath, sizeof(tempPath))) {
+            Serial.printf("uniq: path '%s' is too long\n", destPath);
+            return false;
+        }
+        File source = _open(BUSYBOX_FS, sourcePath, "r");
+        if (!source || source.isDirectory()) {
+            Serial.printf("uniq: cannot open '%s'\n", sourcePath);
+            source.close();
+            return false;
+        }
+        File dest;
+        if (destPath) {
+            // Результат пишется во временный файл: приёмник может быть исходным файлом
+            dest = _open(BUSYBOX_FS, tempPath, "w");
+            if (!dest) {
+                Serial.printf("uniq: cannot create '%s'\n", tempPath);
+                source.close();
+                return false;
+            }
+        }
+
+        char prev[BUSYBOX_TEXT_LINE + 1];
+        size_t prevLen = 0;
+        uint32_t repeats = 0;
+        uint32_t lines = 0;
+        uint32_t unique = 0;
+        bool ok = true;
+        {
+            LineReader reader(source);
+            BlockWriter writer(dest);
+            BlockWriter* out = destPath ? &writer : nullptr;
+            char counted[BUSYBOX_TEXT_LINE + 16];
+            size_t len;
+            const char* line = reader.next(len);
+            while (ok) {
+                bool same = line && repeats && len == prevLen && memcmp(line, prev, len) == 0;
+                if (same) {
+                    repeats++;
+                } else {
+                    // Вывод предыдущей группы
+                    if (repeats) {
+                        unique++;
+                        if (counts) {
+                            int n = snprintf(counted, sizeof(counted), "%7lu %s", (unsigned long)repeats, prev);
+                            ok = _textPut(out, counted, (size_t)n < sizeof(counted) ? n : sizeof(counted) - 1);
+                        } else {
+                            ok = _textPut(out, prev, prevLen);
+                        }
+                    }
+                    if (!line) break;
+                    memcpy(prev, line, len + 1);
+                    prevLen = len;
+                    repeats = 1;
+                }
+                lines++;
+                line = reader.next(len);
+                delay(0);
+            }
+            if (out) ok = writer.flush() && ok;
+        }
+        source.close();
+        dest.close();
+        if (!ok) {
+            if (destPath) _remove(BUSYBOX_FS, tempPath);
+            Serial.println("uniq: write failed");
+            return false;
+        }
+        if (destPath) {
+            if (!_tmpCommit(BUSYBOX_FS, destPath)) {
+                Serial.printf("uniq: cannot replace '%s'\n", destPath);
+                return false;
+            }
+            _touched(destPath);
+            Serial.printf("uniq: %lu lines -> %lu unique in '%s'\n", (unsigned long)lines, (unsigned long)unique, destPath);
+        }
+        return true;
+    }
+
+    // Ключ сортировки
+    struct SortOpts {
+        uint8_t field;          // номер поля (с 1, разделитель — пробелы), 0 — вся строка
+        bool    numeric;        // сравнение чисел (sort -n)
+        bool    reverse;        // обратный порядок (sort -r)
+        bool    ignoreCase;     // без учёта регистра (sort -f)
+        bool    unique;         // только первая из строк с равными ключами (sort -u)
+    };
+
+    // Начало поля opts.field в строке
+    inline const char* _sortKey(const char* line, const SortOpts& opts) {
+        const char* p = line;
+        for (uint8_t f = 1; f < opts.field; f++) {
+            while (*p == ' ' || *p == '\t') p++;
+            while (*p && *p != ' ' && *p != '\t') p++;
+        }
+        if (opts.field) {
+            while (*p == ' ' || *p == '\t') p++;
+        }
+        return p;
+    }
+
+    inline int _sortCompare(const char* a, const char* b, const SortOpts& opts) {
+        const char* ka = _sortKey(a, opts);
+        const char* kb = _sortKey(b, opts);
+        int c;
+        if (opts.numeric) {
+            double da = atof(ka);
+            double db = atof(kb);
+            c = da < db ? -1 : da > db ? 1 : 0;
+        } else {
+            c = opts.ignoreCase ? strcasecmp(ka, kb) : strcmp(ka, kb);
+        }
+        return opts.reverse ? -c : c;
+    }
+
+    inline bool _sortRunPath(const char* destPath, uint32_t run, char* out, size_t len) {
+        return (size_t)snprintf(out, len, "%s.run%lu", destPath, (unsigned long)run) < len;
+    }
+
+    // Вход слияния: файл серии и построчное чтение с текущей строкой
+    struct SortInput {
+        explicit SortInput(const char* path) : file(_open(BUSYBOX_FS, path, "r")), reader(file), line(nullptr), len(0) {}
+        ~SortInput() { file.close(); }
+
+        void advance() { line = reader.next(len); }
+
+        File        file;
+        LineReader  reader;
+        const char* line;
+        size_t      len;
+    };
+
+    // Слияние серий [first, first + count) в файл out
+    inline bool _sortMerge(const char* destPath, uint32_t first, uint32_t count, const char* out, const SortOpts& opts) {
+        SortInput* inputs[BUSYBOX_SORT_FANIN] = {};
+        char path[BUSYBOX_SORT_PATH];
+        bool ok = true;
+        File dest = _open(BUSYBOX_FS, out, "w");
+        if (!dest) {
+            Serial.printf("sort: cannot create '%s'\n", out);
+            ok = false;
+        }
+        if (ok) {
+            // Писатель создаётся раньше входов и первым получает блок пула кэша:
+            // запись результата идёт блоками, а серии при нехватке блоков
+            // читаются через малый буфер
+            BlockWriter writer(dest);
+            for (uint32_t i = 0; i < count && ok; i++) {
+                _sortRunPath(destPath, first + i, path, sizeof(path));
+                inputs[i] = new (std::nothrow) SortInput(path);
+                if (!inputs[i]) {
+                    Serial.println("sort: out of memory");
+                    ok = false;
+                } else if (!inputs[i]->file) {
+                    Serial.printf("sort: cannot open '%s'\n", path);
+                    ok = false;
+                } else {
+                    inputs[i]->advance();
+                }
+            }
+
+            char last[BUSYBOX_TEXT_LINE + 1];
+            bool any = false;
+            while (ok) {
+                int best = -1;
+                for (uint32_t i = 0; i < count; i++) {
+                    if (inputs[i]->line && (best < 0 || _sortCompare(inputs[i]->line, inputs[best]->line, opts) < 0)) best = i;
+                }
+                if (best < 0) break;
+                SortInput& in = *inputs[best];
+                if (!opts.unique || !any || _sortCompare(in.line, last, opts) != 0) {
+                    ok = _textPut(&writer, in.line, in.len);
+                    if (opts.unique) memcpy(last, in.line, in.len + 1);
+                    any = true;
+                }
+                in.advance();
+                delay(0);
+            }
+            ok = writer.flush() && ok;
+        }
+        if (dest) {
+            dest.close();
+            _touched(out);
+        }
+
+        for (uint32_t i = 0; i < count; i++) {
+            delete inputs[i];
+            _sortRunPath(destPath, first + i, path, sizeof(path));
+            _remove(BUSYBOX_FS, path);
+            _touched(path, 0, ChangeOp::Remove);
+        }
+        return ok;
+    }
+
+    /// @brief Сортировка строк файла с ограниченным расходом памяти (аналог sort)
+    /// @param sourcePath исходный файл
+    /// @param destPath файл результата (может совпадать с исходным)
+    /// @param opts ключ и порядок сортировки
+    inline bool sort(const char* sourcePath, const char* destPath, const SortOpts& opts = SortOpts()) {
+        CommandScope _scope("sort");
+        WriteLock _lock;
+        char path[BUSYBOX_SORT_PATH];
+        char tempPath[BUSYBOX_SORT_PATH];
+        // Проверка длины по самому длинному имени серии
+        if (!_sortRunPath(destPath, 0xFFFFFFFF, path, sizeof(path)) || !_tmpPath(destPath, tempPath, sizeof(tempPath))) {
+            Serial.printf("sort: path '%s' is too long\n", destPath);
+            return false;
+        }
+        File source = _open(BUSYBOX_FS, sourcePath, "r");
+        if (!source || source.isDirectory()) {
+            Serial.printf("sort: cannot open '%s'\n", sourcePath);
+            source.close();
+            return false;
+        }
+        // Строки укладываются с начала буфера, смещения строк — с конца
+        uint8_t* memory = _cacheAlloc(BUSYBOX_SORT_MEMORY, true);
+        if (!memory) {
+            Serial.println("sort: out of memory");
+            source.close();
+            return false;
+        }
+
+        // Проход 1: отсортированные серии
+        uint32_t runs = 0;
+        uint32_t lines = 0;
+        uint32_t truncated = 0;
+        bool ok = true;
+        {
+            LineReader reader(source);
+            uint32_t* offsets = (uint32_t*)(memory + BUSYBOX_SORT_MEMORY);
+            size_t len;
+            const char* line = reader.next(len);
+            while (ok && line) {
+                size_t used = 0;
+                uint32_t count = 0;
+                while (line && used + len + 1 + (count + 1) * sizeof(uint32_t) <= BUSYBOX_SORT_MEMORY) {
+                    memcpy(memory + used, line, len + 1);
+                    *(offsets - 1 - count) = used;
+                    used += len + 1;
+                    count++;
+                    line = reader.next(len);
+                }
+                if (!count) {
+                    Serial.println("sort: line does not fit BUSYBOX_SORT_MEMORY");
+                    ok = false;
+                    break;
+                }
+                lines += count;
+
+                // Сортировка смещений (Шелл)
+                uint32_t* index = offsets - count;
+                for (uint32_t gap = count / 2; gap > 0; gap /= 2) {
+                    for (uint32_t i = gap; i < count; i++) {
+                        uint32_t item = index[i];
+                        uint32_t j = i;
+                        while (j >= gap && _sortCompare((const char*)memory + item, (const char*)memory + index[j - gap], opts) < 0) {
+                            index[j] = index[j - gap];
+                            j -= gap;
+                        }
+                        index[j] = item;
+                    }
+                    yield();
+                }
+
+                _sortRunPath(destPath, runs, path, sizeof(path));
+                File run = _open(BUSYBOX_FS, path, "w");
+                if (!run) {
+                    Serial.printf("sort: cannot create '%s'\n", path);
+                    ok = false;
+                    break;
+                }
+                {
+                    BlockWriter writer(run);
+                    const char* last = nullptr;
+                    for (uint32_t i = 0; ok && i < count; i++) {
+                        const char* s = (const char*)memory + index[i];
+                        if (opts.unique && last && _sortCompare(s, last, opts) == 0) continue;
+                        ok = _textPut(&writer, s, strlen(s));
+                        last = s;
+                    }
+                    ok = writer.flush() && ok;
+                }
+                run.close();
+                _touched(path);
+                runs++;
+            }
+            truncated = reader.truncated;
+        }
+        source.close();
+        free(memory);
+
+        // Проход 2: слияние по BUSYBOX_SORT_FANIN серий; последнее слияние пишет результат
+        uint32_t initial = runs;
+        uint32_t first = 0;
+        if (ok && !runs) {
+            File dest = _open(BUSYBOX_FS, tempPath, "w");
+            ok = (bool)dest;
+            dest.close();
+        }
+        while (ok && runs - first > 0) {
+            uint32_t count = runs - first < BUSYBOX_SORT_FANIN ? runs - first : BUSYBOX_SORT_FANIN;
+            bool last = count == runs - first;
+            if (last) {
+                ok = _sortMerge(destPath, first, count, tempPath, opts);
+            } else {
+                _sortRunPath(destPath, runs, path, sizeof(path));
+                ok = _sortMerge(destPath, first, count, path, opts);
+                runs++;
+            }
+            first += count;
+            yield();
+        }
+
+        if (ok) {
+            ok = _tmpCommit(BUSYBOX_FS, destPath);
+            _touched(destPath);
+        }
+        if (!ok) {
+            // Удаление оставшихся серий и незавершённого результата
+            for (uint32_t i = first; i < runs; i++) {
+                _sortRunPath(destPath, i, path, sizeof(path));
+                _remove(BUSYBOX_FS, path);
+            }
+            _remove(BUSYBOX_FS, tempPath);
+            Serial.printf("sort: failed to sort '%s'\n", sourcePath);
+            return false;
+        }
+        Serial.printf("sort: %lu lines, %lu runs, %lu merges -> '%s'", (unsigned long)lines, (unsigned long)initial,
+                      (unsigned long)(runs - initial + (initial ? 1 : 0)), destPath);
+        if (truncated) Serial.printf(" (%lu lines truncated to %u bytes)", (unsigned long)truncated, BUSYBOX_TEXT_LINE);
+        Serial.println();
+        return true;
+    }
+
+} // namespace Busybox
+
+#endif
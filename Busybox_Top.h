@@ -0,0 +1,182 @@
+#ifndef BUSYBOX_TOP_H
+#define BUSYBOX_TOP_H
+
+#include "Busybox_Common.h"
+
+// Максимальное число задач FreeRTOS, которое умеет показать top.
+// Массивы выделяются статически один раз, при обновлении память не выделяется.
+#ifndef BUSYBOX_TOP_MAX_TASKS
+#define BUSYBOX_TOP_MAX_TASKS 32
+#endif
+
+#if defined(ARDUINO_ARCH_ESP32) && (configUSE_TRACE_FACILITY == 1) && (configGENERATE_RUN_TIME_STATS == 1)
+#define BUSYBOX_TOP_SUPPORTED 1
+#else
+#define BUSYBOX_TOP_SUPPORTED 0
+#endif
+
+namespace Busybox {
+
+#if BUSYBOX_TOP_SUPPORTED
+
+#ifdef configRUN_TIME_COUNTER_TYPE
+    typedef configRUN_TIME_COUNTER_TYPE TopCounter;
+#else
+    typedef uint32_t TopCounter;
+#endif
+
+    struct TopState {
+        TaskStatus_t tasks[BUSYBOX_TOP_MAX_TASKS];      // текущий снимок
+        TopCounter   delta[BUSYBOX_TOP_MAX_TASKS];      // время выполнения с прошлого снимка
+        uint8_t      order[BUSYBOX_TOP_MAX_TASKS];      // порядок сортировки по delta
+        UBaseType_t  prevNumber[BUSYBOX_TOP_MAX_TASKS]; // номера задач прошлого снимка
+        TopCounter   prevRun[BUSYBOX_TOP_MAX_TASKS];    // счётчики прошлого снимка
+        UBaseType_t  prevCount;
+        TopCounter   prevTotal;
+        uint32_t     lastMs;
+        bool         primed;
+    };
+
+    inline TopState& _topState() {
+        static TopState state;
+        return state;
+    }
+
+    inline char _topStateChar(eTaskState state) {
+        switch (state) {
+            case eRunning:   return 'X';
+            case eReady:     return 'R';
+            case eBlocked:   return 'B';
+            case eSuspended: return 'S';
+            case eDeleted:   return 'D';
+            default:         return '?';
+        }
+    }
+
+    // Снимок состояния задач. Возвращает число задач или 0 при переполнении массива.
+    inline UBaseType_t _topSnapshot(TopState& st, TopCounter& total) {
+        if (uxTaskGetNumberOfTasks() > BUSYBOX_TOP_MAX_TASKS) return 0;
+        return uxTaskGetSystemState(st.tasks, BUSYBOX_TOP_MAX_TASKS, &total);
+    }
+
+    // Запомнить снимок как базу для следующего расчёта
+    inline void _topRemember(TopState& st, UBaseType_t count, TopCounter total) {
+        for (UBaseType_t i = 0; i < count; i++) {
+            st.prevNumber[i] = st.tasks[i].xTaskNumber;
+            st.prevRun[i] = st.tasks[i].ulRunTimeCounter;
+        }
+        st.prevCount = count;
+        st.prevTotal = total;
+        st.lastMs = millis();
+        st.primed = true;
+    }
+
+    inline void _topPrint(TopState& st, UBaseType_t count, TopCounter total) {
+        TopCounter elapsed = total - st.prevTotal;
+        if (elapsed == 0) elapsed = 1;
+
+        // Разница счётчиков с прошлым снимком
+        for (UBaseType_t i = 0; i < count; i++) {
+            TopCounter prev = 0;
+            for (UBaseType_t j = 0; j < st.prevCount; j++) {
+                if (st.prevNumber[j] == st.tasks[i].xTaskNumber) {
+                    prev = st.prevRun[j];
+                    break;
+                }
+            }
+            st.delta[i] = st.tasks[i].ulRunTimeCounter - prev;
+        }
+
+        // Сортировка вставками по убыванию delta
+        for (UBaseType_t i = 0; i < count; i++) {
+            uint8_t idx = i;
+            UBaseType_t j = i;
+            while (j > 0 && st.delta[st.order[j - 1]] < st.delta[idx]) {
+                st.order[j] = st.order[j - 1];
+                j--;
+            }
+            st.order[j] = idx;
+        }
+
+        // Загрузка ядер по времени idle-задач
+        Serial.printf("=== top: %u tasks, interval %lu ms ===\n", count, (unsigned long)(millis() - st.lastMs));
+#if (configTASKLIST_INCLUDE_COREID == 1)
+        for (BaseType_t core = 0; core < portNUM_PROCESSORS; core++) {
+            TopCounter idle = 0;
+            for (UBaseType_t i = 0; i < count; i++) {
+                if (st.tasks[i].xCoreID == core && strncmp(st.tasks[i].pcTaskName, "IDLE", 4) == 0) {
+                    idle += st.delta[i];
+                }
+            }
+            if (idle > elapsed) idle = elapsed;
+            uint32_t busy10 = 1000 - (uint32_t)((uint64_t)idle * 1000 / elapsed);
+            Serial.printf("CPU%d: %3lu.%lu%%  ", core, (unsigned long)(busy10 / 10), (unsigned long)(busy10 % 10));
+        }
+        Serial.println();
+#endif
+
+        Serial.println("Task              Core Prio St   CPU%   Stack HWM");
+        for (UBaseType_t k = 0; k < count; k++) {
+            const TaskStatus_t& t = st.tasks[st.order[k]];
+            uint32_t cpu10 = (uint32_t)((uint64_t)st.delta[st.order[k]] * 1000 / elapsed);
+#if (configTASKLIST_INCLUDE_COREID == 1)
+            int core = t.xCoreID == tskNO_AFFINITY ? -1 : (int)t.xCoreID;
+#else
+            int core = -1;
+#endif
+            char coreStr[4];
+            if (core < 0) strcpy(coreStr, "*");
+            else snprintf(coreStr, sizeof(coreStr), "%d", core);
+
+            Serial.printf("%-17s %-4s %-4u %c  %4lu.%lu%%  %6u\n", t.pcTaskName, coreStr,
+                          (unsigned)t.uxCurrentPriority, _topStateChar(t.eCurrentState),
+                          (unsigned long)(cpu10 / 10), (unsigned long)(cpu10 % 10),
+                          (unsigned)t.usStackHighWaterMark);
+        }
+    }
+
+    /// @brief Загрузка CPU и стеки задач FreeRTOS (аналог top)
+    /// @param intervalMs интервал между снимками
+    /// @param blocking true — снять два снимка с задержкой intervalMs и вывести таблицу;
+    ///                 false — для вызова из loop(): таблица выводится, когда с прошлого
+    ///                 снимка прошло не меньше intervalMs
+    /// @return true если таблица была выведена
+    inline bool top(uint32_t intervalMs = 1000, bool blocking = true) {
+        TopState& st = _topState();
+        TopCounter total = 0;
+
+        if (blocking || !st.primed) {
+            UBaseType_t count = _topSnapshot(st, total);
+            if (count == 0) {
+                Serial.printf("top: more than %d tasks, increase BUSYBOX_TOP_MAX_TASKS\n", BUSYBOX_TOP_MAX_TASKS);
+                return false;
+            }
+            _topRemember(st, count, total);
+            if (!blocking) return false;
+            delay(intervalMs);
+        } else if (millis() - st.lastMs < intervalMs) {
+            return false;
+        }
+
+        UBaseType_t count = _topSnapshot(st, total);
+        if (count == 0) {
+            Serial.printf("top: more than %d tasks, increase BUSYBOX_TOP_MAX_TASKS\n", BUSYBOX_TOP_MAX_TASKS);
+            return false;
+        }
+        _topPrint(st, count, total);
+        _topRemember(st, count, total);
+        return true;
+    }
+
+#else
+
+    inline bool top(uint32_t intervalMs = 1000, bool blocking = true) {
+        Serial.println("top: FreeRTOS runtime stats are not available on this platform");
+        return false;
+    }
+
+#endif
+
+} // namespace Busybox
+
+#endif
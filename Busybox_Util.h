@@ -0,0 +1,88 @@
+#ifndef BUSYBOX_UTIL_H
+#define BUSYBOX_UTIL_H
+
+#include "Busybox_Common.h"
+
+// Служебные функции, общие для модулей
+
+namespace Busybox {
+
+    // Хеш FNV-1a (32 бита) строки
+    inline uint32_t _hash32(const char* s) {
+        uint32_t h = 2166136261u;
+        while (*s) {
+            h ^= (uint8_t)*s++;
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    // То же для len байт (строка без завершающего нуля)
+    inline uint32_t _hash32(const char* s, size_t len) {
+        uint32_t h = 2166136261u;
+        while (len--) {
+            h ^= (uint8_t)*s++;
+            h *= 16777619u;
+        }
+        return h;
+    }
+
+    // CRC-32 (IEEE 802.3, как в zlib); для продолжения передать предыдущее значение
+    inline uint32_t _crc32(const void* data, size_t len, uint32_t crc = 0) {
+        static const uint32_t table[16] = {
+            0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+            0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+        };
+        const uint8_t* p = (const uint8_t*)data;
+        crc = ~crc;
+        while (len--) {
+            crc = (crc >> 4) ^ table[(crc ^ *p) & 0x0F];
+            crc = (crc >> 4) ^ table[(crc ^ (*p++ >> 4)) & 0x0F];
+        }
+        return ~crc;
+    }
+
+    // Путь временного файла атомарной записи: PATH + BUSYBOX_TMP_SUFFIX
+    inline bool _tmpPath(const char* path, char* out, size_t len) {
+        return (size_t)snprintf(out, len, "%s%s", path, BUSYBOX_TMP_SUFFIX) < len;
+    }
+
+    // Замена PATH дописанным и закрытым PATH.bbtmp. Сначала временный файл
+    // переименовывается в PATH.bbnew: после сбоя восстанавливаются только такие
+    // файлы, а PATH.bbtmp считается недописанным. ФС на ESP32 не заменяют
+    // существующий файл при rename, поэтому PATH удаляется перед переименованием.
+    inline bool _tmpCommit(fs::FS& fs, const char* path) {
+        char temp[128];
+        char done[128];
+        if (!_tmpPath(path, temp, sizeof(temp)) ||
+            (size_t)snprintf(done, sizeof(done), "%s%s", path, BUSYBOX_TMP_DONE_SUFFIX) >= sizeof(done)) {
+            return false;
+        }
+        if (!_rename(fs, temp, done)) return false;
+        if (fs.exists(path) && !_remove(fs, path)) return false;
+        return _rename(fs, done, path);
+    }
+
+    // Завершение прерванной атомарной записи (как в fsck): недописанный PATH.bbtmp
+    // удаляется, готовый PATH.bbnew заменяет PATH
+    inline void _tmpRecover(const char* path, const char* tag) {
+        char temp[128];
+        if (_tmpPath(path, temp, sizeof(temp)) && BUSYBOX_FS.exists(temp)) {
+            _remove(BUSYBOX_FS, temp);
+            _touched(temp, 0, ChangeOp::Remove);
+        }
+        if ((size_t)snprintf(temp, sizeof(temp), "%s%s", path, BUSYBOX_TMP_DONE_SUFFIX) >= sizeof(temp) ||
+            !BUSYBOX_FS.exists(temp)) {
+            return;
+        }
+        if (BUSYBOX_FS.exists(path)) _remove(BUSYBOX_FS, path);
+        if (_rename(BUSYBOX_FS, temp, path)) {
+            Serial.printf("%s: '%s' restored from '%s'\n", tag, path, temp);
+            _touched(temp, 0, ChangeOp::MoveFrom);
+            _touched(path, 0, ChangeOp::MoveTo);
+        }
+    }
+
+} // namespace Busybox
+
+#endif
@@ -0,0 +1,120 @@
+#ifndef BUSYBOX_WALK_H
+#define BUSYBOX_WALK_H
+
+#include "Busybox_Common.h"
+
+// Обход дерева директорий без рекурсии: стек открытых директорий фиксированной
+// глубины и один буфер пути, так что расход памяти не зависит от числа файлов.
+
+// Максимальная глубина вложенности директорий
+#ifndef BUSYBOX_WALK_DEPTH
+#define BUSYBOX_WALK_DEPTH 8
+#endif
+
+// Максимальная длина пути
+#ifndef BUSYBOX_WALK_PATH
+#define BUSYBOX_WALK_PATH 128
+#endif
+
+namespace Busybox {
+
+    class TreeWalker {
+    public:
+        // tag — префикс сообщений о пропущенных записях
+        TreeWalker(fs::FS& fs, const char* tag) : dirs(0), skipped(0), _fs(fs), _tag(tag), _depth(0), _nameOffset(0) {
+            _path[0] = '\0';
+        }
+
+        ~TreeWalker() {
+            while (_depth) _stack[--_depth].dir.close();
+        }
+
+        TreeWalker(const TreeWalker&) = delete;
+        TreeWalker& operator=(const TreeWalker&) = delete;
+
+        // Начало обхода; false если root не директория
+        bool begin(const char* root) {
+            File dir = _open(_fs, root, "r");
+            if (!dir || !dir.isDirectory()) return false;
+            size_t len = strlen(root);
+            // Без завершающего '/', кроме корня
+            while (len > 1 && root[len - 1] == '/') len--;
+            if (len >= BUSYBOX_WALK_PATH) return false;
+            memcpy(_path, root, len);
+            _path[len] = '\0';
+            _stack[0].dir = dir;
+            _stack[0].pathLen = len;
+            _depth = 1;
+            dirs = 1;
+            return true;
+        }
+
+        // Следующий файл (в поддиректории обход заходит сам); пустой File в конце
+        File next() {
+            while (_depth) {
+                Level& level = _stack[_depth - 1];
+                File entry = _next(level.dir);
+                if (!entry) {
+                    level.dir.close();
+                    _depth--;
+                    continue;
+                }
+
+                // ESP8266 возвращает полный путь, ESP32 — только имя
+                const char* name = entry.name();
+                const char* slash = strrchr(name, '/');
+                if (slash) name = slash + 1;
+
+                bool isRoot = level.pathLen == 1 && _path[0] == '/';
+                size_t room = BUSYBOX_WALK_PATH - level.pathLen;
+                if ((size_t)snprintf(_path + level.pathLen, room, "%s%s", isRoot ? "" : "/", name) >= room) {
+                    _path[level.pathLen] = '\0';
+                    Serial.printf("%s: path too long in '%s'\n", _tag, _path);
+                    skipped++;
+                    entry.close();
+                    continue;
+                }
+                _nameOffset = level.pathLen + (isRoot ? 0 : 1);
+
+                if (entry.isDirectory()) {
+                    dirs++;
+                    if (_depth == BUSYBOX_WALK_DEPTH) {
+                        Serial.printf("%s: '%s' is nested too deep, skipped\n", _tag, _path);
+                        skipped++;
+                        entry.close();
+                        continue;
+                    }
+                    _stack[_depth].dir = entry;
+                    _stack[_depth].pathLen = strlen(_path);
+                    _depth++;
+                    continue;
+                }
+                return entry;
+            }
+            return File();
+        }
+
+        // Полный путь и имя последнего файла, возвращённого next
+        const char* path() const { return _path; }
+        const char* name() const { return _path + _nameOffset; }
+
+        uint32_t dirs;
+        uint32_t skipped;       // слишком глубокие директории и длинные пути
+
+    private:
+        struct Level {
+            File     dir;
+            uint16_t pathLen;
+        };
+
+        fs::FS&     _fs;
+        const char* _tag;
+        Level       _stack[BUSYBOX_WALK_DEPTH];
+        char        _path[BUSYBOX_WALK_PATH];
+        uint8_t     _depth;
+        uint16_t    _nameOffset;
+    };
+
+} // namespace Busybox
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef BUSYBOX_WATCH_H
+#define BUSYBOX_WATCH_H
+
+#include "Busybox_Common.h"
+
+// Уведомления об изменениях файлов командами Busybox.
+//
+// Каждое изменение (write, append, cp, mv, rm, mkdir, rmdir, rmrf и запись
+// модулей KV, RingFile, ...) публикуется из _touched как короткое событие:
+// операция, хеш пути, хеш родительской директории и число байт. События
+// пишутся в общее кольцо на BUSYBOX_WATCH_EVENTS записей; каждый подписчик
+// (Watcher) читает его со своей позиции, не блокируя запись и других
+// подписчиков. Если подписчик отстал больше чем на размер кольца, старые
+// события теряются, а счётчик dropped() растёт — тогда нужно перечитать
+// директорию целиком (ls, snapshot).
+//
+// Хеши сравниваются с _hash32 нужного пути: Watcher::hash("/logs").
+
+// Размер кольца событий
+#ifndef BUSYBOX_WATCH_EVENTS
+#define BUSYBOX_WATCH_EVENTS 32
+#endif
+
+namespace Busybox {
+
+    struct ChangeEvent {
+        uint32_t seq;       // номер события с начала работы
+        uint32_t path;      // _hash32 пути
+        uint32_t dir;       // _hash32 родительской директории ("/" для корня)
+        uint32_t size;      // записано байт (0 для удаления, переименования, директорий)
+        ChangeOp op;
+    };
+
+    struct WatchRing {
+        ChangeEvent events[BUSYBOX_WATCH_EVENTS];
+        volatile uint32_t head;     // номер следующего события
+    };
+
+    inline WatchRing& _watchRing() {
+        static WatchRing ring = {};
+        return ring;
+    }
+
+#if defined(ARDUINO_ARCH_ESP32)
+    inline portMUX_TYPE& _watchMux() {
+        static portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+        return mux;
+    }
+#endif
+
+    // Хеш родительской директории пути
+    inline uint32_t _watchDir(const char* path) {
+        const char* slash = strrchr(path, '/');
+        if (!slash || slash == path) return _hash32("/");
+        return _hash32(path, slash - path);
+    }
+
+    // Публикация события (вызывается из _touched)
+    inline void _watchPublish(const char* path, uint32_t bytes, ChangeOp op) {
+        WatchRing& r = _watchRing();
+        uint32_t hash = _hash32(path);
+        uint32_t dir = _watchDir(path);
+        // Записывающих может быть несколько (команды из разных задач), читатели
+        // не блокируются: слот помечается недействительным на время записи
+#if defined(ARDUINO_ARCH_ESP32)
+        portENTER_CRITICAL(&_watchMux());
+#endif
+        uint32_t seq = r.head;
+        volatile ChangeEvent& e = r.events[seq % BUSYBOX_WATCH_EVENTS];
+        e.seq = seq - 1;
+        e.path = hash;
+        e.dir = dir;
+        e.size = bytes;
+        e.op = op;
+        e.seq = seq;
+        r.head = seq + 1;
+#if defined(ARDUINO_ARCH_ESP32)
+        portEXIT_CRITICAL(&_watchMux());
+#endif
+    }
+
+    // Подписчик на события; читает только события после своего создания
+    class Watcher {
+    public:
+        Watcher() : _next(_watchRing().head), _dropped(0) {}
+
+        /// @brief Следующее событие
+        /// @param e сюда копируется событие
+        /// @return false если новых событий нет
+        bool next(ChangeEvent& e) {
+            WatchRing& r = _watchRing();
+            while (true) {
+                uint32_t head = r.head;
+                if (_next == head) return false;
+                if (head - _next > BUSYBOX_WATCH_EVENTS) {
+                    // Подписчик отстал: часть событий перезаписана
+                    _dropped += head - BUSYBOX_WATCH_EVENTS - _next;
+                    _next = head - BUSYBOX_WATCH_EVENTS;
+                }
+                const volatile ChangeEvent& slot = r.events[_next % BUSYBOX_WATCH_EVENTS];
+                e.seq = slot.seq;
+                e.path = slot.path;
+                e.dir = slot.dir;
+                e.size = slot.size;
+                e.op = slot.op;
+                // Слот перезаписывается новым событием — это событие потеряно
+                if (e.seq != _next || slot.seq != _next) {
+                    _dropped++;
+                    _next++;
+                    continue;
+                }
+                _next++;
+                return true;
+            }
+        }
+
+        /// @brief Число потерянных событий с момента создания подписчика.
+        /// Если оно выросло, инкрементальное состояние нужно перестроить с нуля.
+        uint32_t dropped() const { return _dropped; }
+
+        /// @brief Событий в очереди подписчика (включая те, что будут потеряны)
+        uint32_t pending() const { return _watchRing().head - _next; }
+
+        /// @brief Хеш пути для сравнения с ChangeEvent::path и ChangeEvent::dir
+        static uint32_t hash(const char* path) { return _hash32(path); }
+
+    private:
+        uint32_t _next;
+        uint32_t _dropped;
+    };
+
+    /// @brief Имя операции события
+    inline const char* changeOpStr(ChangeOp op) {
+        switch (op) {
+            case ChangeOp::Write:    return "write";
+            case ChangeOp::Append:   return "append";
+            case ChangeOp::Remove:   return "remove";
+            case ChangeOp::MoveFrom: return "move-from";
+            case ChangeOp::MoveTo:   return "move-to";
+            case ChangeOp::Mkdir:    return "mkdir";
+            case ChangeOp::Rmdir:    return "rmdir";
+        }
+        return "?";
+    }
+
+} // namespace Busybox
+
+#endif
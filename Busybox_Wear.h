@@ -0,0 +1,391 @@
+#ifndef BUSYBOX_WEAR_H
+#define BUSYBOX_WEAR_H
+
+#include "Busybox_Common.h"
+#include "Busybox_Util.h"
+
+#if defined(ARDUINO_ARCH_ESP32) && defined(BUSYBOX_LFS_H)
+#include <esp_partition.h>
+#define BUSYBOX_WEAR_BLOCKS 1
+#else
+#define BUSYBOX_WEAR_BLOCKS 0
+#endif
+
+// Учёт износа flash.
+// При #define BUSYBOX_WEAR команды Busybox считают записанные байты и число
+// фиксаций (commit) по файлам. Счётчики с начала эксплуатации хранятся в файле
+// BUSYBOX_WEAR_FILE и сохраняются не чаще раза в BUSYBOX_WEAR_SAVE_MS.
+//
+// LittleFS не хранит счётчики стирания блоков данных. Зато каждый блок метаданных
+// начинается со счётчика ревизий, который растёт при каждой его перезаписи
+// (после block_cycles ревизий пара блоков переносится). На ESP32 wear() читает
+// раздел напрямую и выводит распределение ревизий блоков метаданных.
+
+// Число файлов в таблице счётчиков
+#ifndef BUSYBOX_WEAR_FILES
+#define BUSYBOX_WEAR_FILES 16
+#endif
+
+// Максимальная длина пути в таблице (длинные пути обрезаются)
+#ifndef BUSYBOX_WEAR_PATH
+#define BUSYBOX_WEAR_PATH 32
+#endif
+
+// Файл со счётчиками с начала эксплуатации
+#ifndef BUSYBOX_WEAR_FILE
+#define BUSYBOX_WEAR_FILE "/.wear"
+#endif
+
+// Минимальный интервал автоматического сохранения счётчиков
+#ifndef BUSYBOX_WEAR_SAVE_MS
+#define BUSYBOX_WEAR_SAVE_MS 600000
+#endif
+
+// Ресурс flash, циклов стирания на сектор
+#ifndef BUSYBOX_WEAR_ENDURANCE
+#define BUSYBOX_WEAR_ENDURANCE 100000
+#endif
+
+// Оценка числа байт flash, перезаписываемых одной фиксацией (метаданные, хвостовой блок)
+#ifndef BUSYBOX_WEAR_COMMIT_COST
+#define BUSYBOX_WEAR_COMMIT_COST 512
+#endif
+
+// Раздел LittleFS и размер его блока
+#ifndef BUSYBOX_WEAR_PARTITION
+#define BUSYBOX_WEAR_PARTITION "spiffs"
+#endif
+
+#ifndef BUSYBOX_LFS_BLOCK
+#define BUSYBOX_LFS_BLOCK 4096
+#endif
+
+#define BUSYBOX_WEAR_MAGIC   0x52574242     // "BBWR"
+#define BUSYBOX_WEAR_VERSION 1
+#define BUSYBOX_WEAR_BUCKETS 8
+
+namespace Busybox {
+
+    // Счётчики одного файла
+    struct WearEntry {
+        char     path[BUSYBOX_WEAR_PATH];
+        uint32_t bytes;             // с момента загрузки
+        uint32_t commits;
+        uint32_t lifeBytes;         // с начала эксплуатации, включая текущую загрузку
+        uint32_t lifeCommits;
+    };
+
+    // Заголовок файла счётчиков; за ним count записей WearEntry и CRC-32
+    struct WearHeader {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t count;
+        uint32_t boots;
+        uint32_t seconds;           // суммарное время работы
+        uint32_t lifeBytes;
+        uint32_t lifeCommits;
+    };
+
+    struct WearState {
+        WearEntry entries[BUSYBOX_WEAR_FILES];
+        uint16_t  count;
+        bool      loaded;
+        bool      dirty;
+        uint32_t  lastSave;
+        uint32_t  bytes;            // все файлы с момента загрузки
+        uint32_t  commits;
+        uint32_t  savedBytes;       // значения из файла счётчиков
+        uint32_t  savedCommits;
+        uint32_t  savedSeconds;
+        uint32_t  boots;
+    };
+
+    // Распределение ревизий блоков метаданных LittleFS
+    struct WearBlocks {
+        uint32_t blocks;
+        uint32_t erased;            // блоки, не содержащие данных (0xFF)
+        uint32_t meta;              // действительные блоки метаданных
+        uint32_t minRev;
+        uint32_t maxRev;
+        uint64_t sumRev;
+        uint32_t hist[BUSYBOX_WEAR_BUCKETS];    // ревизии < 16, < 64, ... (шаг x4)
+    };
+
+    inline WearState& _wear() {
+        static WearState state = {};
+        return state;
+    }
+
+#ifdef BUSYBOX_WEAR
+
+    inline void _wearLoad() {
+        WearState& w = _wear();
+        w.loaded = true;
+        w.boots = 1;
+        // Сохранение, прерванное сбоем питания, завершается до чтения
+        _tmpRecover(BUSYBOX_WEAR_FILE, "wear");
+
+        File file = _open(BUSYBOX_FS, BUSYBOX_WEAR_FILE, "r");
+        if (!file) return;
+        WearHeader h;
+        bool ok = _read(file, (uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+                  h.magic == BUSYBOX_WEAR_MAGIC && h.version == BUSYBOX_WEAR_VERSION &&
+                  h.count <= BUSYBOX_WEAR_FILES;
+        uint32_t stored = 0;
+        if (ok) {
+            size_t len = h.count * sizeof(WearEntry);
+            ok = _read(file, (uint8_t*)w.entries, len) == len &&
+                 _read(file, (uint8_t*)&stored, sizeof(stored)) == sizeof(stored) &&
+                 stored == _crc32(w.entries, len, _crc32(&h, sizeof(h)));
+        }
+        file.close();
+        if (!ok) {
+            memset(w.entries, 0, sizeof(w.entries));
+            Serial.println("wear: counters file is damaged, starting over");
+            return;
+        }
+
+        w.count = h.count;
+        for (uint16_t i = 0; i < w.count; i++) {
+            w.entries[i].bytes = 0;
+            w.entries[i].commits = 0;
+        }
+        w.savedBytes = h.lifeBytes;
+        w.savedCommits = h.lifeCommits;
+        w.savedSeconds = h.seconds;
+        w.boots = h.boots + 1;
+    }
+
+    // Запись счётчиков через временный файл: при сбое питания остаётся прежний
+    // файл или готовый PATH.bbnew; вызывается под WriteLock
+    inline bool _wearSave() {
+        WearState& w = _wear();
+        WearHeader h = {BUSYBOX_WEAR_MAGIC, BUSYBOX_WEAR_VERSION, w.count, w.boots,
+                        w.savedSeconds + millis() / 1000, w.savedBytes + w.bytes, w.savedCommits + w.commits};
+        size_t len = w.count * sizeof(WearEntry);
+        uint32_t crc = _crc32(w.entries, len, _crc32(&h, sizeof(h)));
+
+        char tempPath[64];
+        if (!_tmpPath(BUSYBOX_WEAR_FILE, tempPath, sizeof(tempPath))) return false;
+        File file = _open(BUSYBOX_FS, tempPath, "w");
+        if (!file) return false;
+        bool ok = _write(file, (const uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+                  _write(file, (const uint8_t*)w.entries, len) == len &&
+                  _write(file, (const uint8_t*)&crc, sizeof(crc)) == sizeof(crc);
+        file.close();
+        ok = ok && _tmpCommit(BUSYBOX_FS, BUSYBOX_WEAR_FILE);
+        if (!ok) _remove(BUSYBOX_FS, tempPath);
+        w.lastSave = millis();
+        if (ok) w.dirty = false;
+        return ok;
+    }
+
+    inline WearEntry& _wearEntry(const char* path) {
+        WearState& w = _wear();
+        for (uint16_t i = 0; i < w.count; i++) {
+            if (strncmp(w.entries[i].path, path, BUSYBOX_WEAR_PATH - 1) == 0) return w.entries[i];
+        }
+        // Таблица заполнена: вытесняется файл с наименьшей записью за всё время
+        uint16_t slot = w.count;
+        if (w.count < BUSYBOX_WEAR_FILES) {
+            w.count++;
+        } else {
+            slot = 0;
+            for (uint16_t i = 1; i < w.count; i++) {
+                if (w.entries[i].lifeBytes < w.entries[slot].lifeBytes) slot = i;
+            }
+        }
+        WearEntry& e = w.entries[slot];
+        memset(&e, 0, sizeof(e));
+        strncpy(e.path, path, BUSYBOX_WEAR_PATH - 1);
+        return e;
+    }
+
+    // Учёт фиксации изменения файла (вызывается из _touched)
+    inline void _wearCommit(const char* path, uint32_t bytes) {
+        // Файл счётчиков и его временные файлы не учитываются
+        size_t n = strlen(BUSYBOX_WEAR_FILE);
+        if (strncmp(path, BUSYBOX_WEAR_FILE, n) == 0 &&
+            (!path[n] || strcmp(path + n, BUSYBOX_TMP_SUFFIX) == 0 || strcmp(path + n, BUSYBOX_TMP_DONE_SUFFIX) == 0)) {
+            return;
+        }
+        WearState& w = _wear();
+        if (!w.loaded) _wearLoad();
+
+        WearEntry& e = _wearEntry(path);
+        e.bytes += bytes;
+        e.commits++;
+        e.lifeBytes += bytes;
+        e.lifeCommits++;
+        w.bytes += bytes;
+        w.commits++;
+        w.dirty = true;
+
+        if (millis() - w.lastSave >= BUSYBOX_WEAR_SAVE_MS) _wearSave();
+    }
+
+#else
+
+    inline void _wearCommit(const char*, uint32_t) {}
+
+#endif
+
+#if BUSYBOX_WEAR_BLOCKS && BUSYBOX_HAS(WEAR)
+
+    // Счётчик ревизий блока метаданных LittleFS; false если блок не является
+    // действительным блоком метаданных (проверяется CRC первой фиксации)
+    inline bool _wearMetaRev(const uint8_t* block, size_t size, uint32_t& rev) {
+        rev = block[0] | (block[1] << 8) | (block[2] << 16) | ((uint32_t)block[3] << 24);
+        // В LittleFS CRC без финальной инверсии: lfs_crc(c, d) == ~_crc32(d, ~c)
+        uint32_t crc = ~_crc32(block, 4);
+        uint32_t ptag = 0xFFFFFFFF;
+        size_t off = 4;
+        while (off + 8 <= size) {
+            uint32_t raw = ((uint32_t)block[off] << 24) | (block[off + 1] << 16) | (block[off + 2] << 8) | block[off + 3];
+            crc = ~_crc32(block + off, 4, ~crc);
+            uint32_t tag = raw ^ ptag;
+            if (tag & 0x80000000) return false;
+            uint32_t len = tag & 0x3FF;
+            if (len == 0x3FF) len = 0;      // удалённый тег
+            if (off + 4 + len > size) return false;
+            if ((tag & 0x70000000) == 0x50000000) {
+                // Тег CRC: первая фиксация цела — это блок метаданных
+                const uint8_t* d = block + off + 4;
+                uint32_t stored = d[0] | (d[1] << 8) | (d[2] << 16) | ((uint32_t)d[3] << 24);
+                return stored == crc;
+            }
+            crc = ~_crc32(block + off + 4, len, ~crc);
+            ptag = tag;
+            off += 4 + len;
+        }
+        return false;
+    }
+
+    // Проход по блокам раздела LittleFS
+    inline bool _wearScan(WearBlocks& wb) {
+        memset(&wb, 0, sizeof(wb));
+        const esp_partition_t* part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                                               ESP_PARTITION_SUBTYPE_ANY, BUSYBOX_WEAR_PARTITION);
+        if (!part) return false;
+        uint8_t* block = (uint8_t*)malloc(BUSYBOX_LFS_BLOCK);
+        if (!block) return false;
+
+        ReadLock _lock;
+        wb.blocks = part->size / BUSYBOX_LFS_BLOCK;
+        wb.minRev = 0xFFFFFFFF;
+        for (uint32_t b = 0; b < wb.blocks; b++) {
+            if (esp_partition_read(part, b * BUSYBOX_LFS_BLOCK, block, BUSYBOX_LFS_BLOCK) != ESP_OK) continue;
+            uint32_t rev;
+            if (_wearMetaRev(block, BUSYBOX_LFS_BLOCK, rev)) {
+                wb.meta++;
+                wb.sumRev += rev;
+                if (rev < wb.minRev) wb.minRev = rev;
+                if (rev > wb.maxRev) wb.maxRev = rev;
+                uint8_t bucket = 0;
+                for (uint32_t limit = 16; rev >= limit && bucket < BUSYBOX_WEAR_BUCKETS - 1; limit <<= 2) bucket++;
+                wb.hist[bucket]++;
+            } else if (rev == 0xFFFFFFFF) {
+                wb.erased++;
+            }
+            yield();
+        }
+        free(block);
+        if (!wb.meta) wb.minRev = 0;
+        return true;
+    }
+
+#endif
+
+    /// @brief Сохранение счётчиков износа в BUSYBOX_WEAR_FILE (требует BUSYBOX_WEAR)
+    inline bool wearSave() {
+#ifdef BUSYBOX_WEAR
+        CommandScope _scope("wear");
+        WriteLock _lock;
+        if (!_wear().loaded) _wearLoad();
+        return _wearSave();
+#else
+        return false;
+#endif
+    }
+
+#if BUSYBOX_HAS(WEAR)
+    // Отчёт об износе: самые записываемые файлы, ревизии метаданных, оценка ресурса
+    inline void wear() {
+        CommandScope _scope("wear");
+        Serial.println("=== Flash wear ===");
+
+#ifdef BUSYBOX_WEAR
+        {
+            ReadLock _lock;
+            WearState& w = _wear();
+            if (!w.loaded) _wearLoad();
+            uint32_t lifeBytes = w.savedBytes + w.bytes;
+            uint32_t lifeCommits = w.savedCommits + w.commits;
+            uint32_t seconds = w.savedSeconds + millis() / 1000;
+
+            Serial.printf("Since boot: %lu bytes, %lu commits\n", (unsigned long)w.bytes, (unsigned long)w.commits);
+            Serial.printf("Lifetime:   %lu bytes, %lu commits, %lu h, %lu boots\n", (unsigned long)lifeBytes,
+                          (unsigned long)lifeCommits, (unsigned long)(seconds / 3600), (unsigned long)w.boots);
+
+            // Индексы записей по убыванию записанных байт
+            uint16_t order[BUSYBOX_WEAR_FILES];
+            for (uint16_t i = 0; i < w.count; i++) {
+                uint16_t j = i;
+                while (j > 0 && w.entries[order[j - 1]].lifeBytes < w.entries[i].lifeBytes) {
+                    order[j] = order[j - 1];
+                    j--;
+                }
+                order[j] = i;
+            }
+            if (w.count) Serial.println("File                             Boot B    Commits  Life B     Commits");
+            for (uint16_t k = 0; k < w.count; k++) {
+                const WearEntry& e = w.entries[order[k]];
+                Serial.printf("%-32s %-9lu %-8lu %-10lu %lu\n", e.path, (unsigned long)e.bytes,
+                              (unsigned long)e.commits, (unsigned long)e.lifeBytes, (unsigned long)e.lifeCommits);
+            }
+
+            // Оценка при равномерном распределении износа (динамическое выравнивание LittleFS)
+            // df(): у fs::FS на ESP8266 нет totalBytes()
+            FsInfo info;
+            uint64_t budget = df(info) ? (uint64_t)info.totalBytes * BUSYBOX_WEAR_ENDURANCE : 0;
+            uint64_t flashBytes = (uint64_t)lifeBytes + (uint64_t)lifeCommits * BUSYBOX_WEAR_COMMIT_COST;
+            if (budget) {
+                Serial.printf("Life used:  %.3f%% (estimate)\n", (double)flashBytes * 100.0 / (double)budget);
+                if (seconds && flashBytes) {
+                    double perDay = (double)flashBytes * 86400.0 / seconds;
+                    double days = (double)(budget > flashBytes ? budget - flashBytes : 0) / perDay;
+                    Serial.printf("Remaining:  ~%.0f days at %.0f bytes/day\n", days, perDay);
+                }
+            }
+        }
+#else
+        Serial.println("wear: define BUSYBOX_WEAR to count writes per file");
+#endif
+
+#if BUSYBOX_WEAR_BLOCKS
+        WearBlocks wb;
+        if (!_wearScan(wb)) {
+            Serial.printf("wear: partition '%s' not available\n", BUSYBOX_WEAR_PARTITION);
+            return;
+        }
+        Serial.printf("LittleFS blocks: %lu, metadata %lu, erased %lu\n",
+                      (unsigned long)wb.blocks, (unsigned long)wb.meta, (unsigned long)wb.erased);
+        if (wb.meta) {
+            Serial.printf("Metadata revisions: min %lu, avg %lu, max %lu (worst block ~%.2f%% of endurance)\n",
+                          (unsigned long)wb.minRev, (unsigned long)(wb.sumRev / wb.meta), (unsigned long)wb.maxRev,
+                          // ревизии чередуются между двумя блоками пары
+                          (double)wb.maxRev / 2 * 100.0 / BUSYBOX_WEAR_ENDURANCE);
+            uint32_t limit = 16;
+            for (uint8_t i = 0; i < BUSYBOX_WEAR_BUCKETS; i++, limit <<= 2) {
+                if (!wb.hist[i]) continue;
+                if (i < BUSYBOX_WEAR_BUCKETS - 1) Serial.printf("  rev < %-8lu %lu\n", (unsigned long)limit, (unsigned long)wb.hist[i]);
+                else Serial.printf("  rev >= %-7lu %lu\n", (unsigned long)(limit >> 2), (unsigned long)wb.hist[i]);
+            }
+        }
+#endif
+    }
+#endif
+
+} // namespace Busybox
+
+#endif
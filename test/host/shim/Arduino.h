@@ -0,0 +1,102 @@
+#pragma once
+
+// Минимальная замена ядра Arduino ESP32 для сборки библиотеки на компьютере.
+// Только то, что использует Busybox; вывод Serial идёт в stdout.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+#include <time.h>
+#include <string>
+#include <initializer_list>
+#include "freertos/FreeRTOS.h"
+
+uint32_t millis();
+uint32_t micros();
+void delay(uint32_t ms);
+void yield();
+
+class Print {
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) { return fwrite(&c, 1, 1, stdout); }
+    virtual size_t write(const uint8_t* buffer, size_t size) { return fwrite(buffer, 1, size, stdout); }
+    size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(long v, int base = 10) { return printf(base == 16 ? "%lx" : "%ld", v); }
+    size_t print(unsigned long v, int base = 10) { return printf(base == 16 ? "%lx" : "%lu", v); }
+    size_t print(int v, int base = 10) { return print((long)v, base); }
+    size_t print(unsigned v, int base = 10) { return print((unsigned long)v, base); }
+    size_t print(double v, int digits = 2) { return printf("%.*f", digits, v); }
+    template <typename T> size_t println(T v) { return print(v) + println(); }
+    size_t println() { return print('\n'); }
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3))) {
+        char buffer[512];
+        va_list args;
+        va_start(args, format);
+        int n = vsnprintf(buffer, sizeof(buffer), format, args);
+        va_end(args);
+        if (n < 0) return 0;
+        return write((const uint8_t*)buffer, (size_t)n < sizeof(buffer) ? n : sizeof(buffer) - 1);
+    }
+    virtual void flush() { fflush(stdout); }
+};
+
+class Stream : public Print {
+public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+};
+
+class HardwareSerial : public Stream {};
+extern HardwareSerial Serial;
+
+class String : public std::string {
+public:
+    String(const char* s = "") : std::string(s ? s : "") {}
+    explicit String(char c) : std::string(1, c) {}
+    String(const std::string& s) : std::string(s) {}
+    String& operator+=(const char* s) { append(s); return *this; }
+    String& operator+=(char c) { push_back(c); return *this; }
+    String& operator+=(const String& s) { append(s); return *this; }
+    int lastIndexOf(char c) const { size_t p = rfind(c); return p == npos ? -1 : (int)p; }
+    String substring(int from) const { return String(substr(from)); }
+    bool startsWith(const char* s) const { return compare(0, strlen(s), s) == 0; }
+    bool endsWith(const char* s) const { size_t n = strlen(s); return size() >= n && compare(size() - n, n, s) == 0; }
+    int length() const { return (int)size(); }
+};
+
+inline String operator+(const String& a, const char* b) { String r(a); r += b; return r; }
+inline String operator+(const String& a, const String& b) { String r(a); r += b; return r; }
+inline String operator+(const char* a, const String& b) { String r(a); r += b; return r; }
+
+enum esp_reset_reason_t {
+    ESP_RST_UNKNOWN, ESP_RST_POWERON, ESP_RST_EXT, ESP_RST_SW, ESP_RST_PANIC, ESP_RST_INT_WDT,
+    ESP_RST_TASK_WDT, ESP_RST_WDT, ESP_RST_DEEPSLEEP, ESP_RST_BROWNOUT, ESP_RST_SDIO
+};
+
+inline esp_reset_reason_t esp_reset_reason() { return ESP_RST_POWERON; }
+
+struct EspClass {
+    uint32_t getFlashChipSize() { return 4 << 20; }
+    uint32_t getFlashChipSpeed() { return 80000000; }
+    uint32_t getFreeHeap() { return 200000; }
+    uint32_t getMinFreeHeap() { return 150000; }
+    uint32_t getMaxAllocHeap() { return 100000; }
+    uint32_t getPsramSize() { return 0; }
+    uint32_t getFreePsram() { return 0; }
+    uint32_t getMaxAllocPsram() { return 0; }
+    uint32_t getSketchSize() { return 1 << 20; }
+    uint32_t getFreeSketchSpace() { return 1 << 20; }
+    uint8_t getChipCores() { return 2; }
+    uint32_t getCpuFreqMHz() { return 240; }
+    uint32_t getCycleCount() { return micros() * 240; }
+    const char* getChipModel() { return "host"; }
+};
+extern EspClass ESP;
@@ -0,0 +1,4 @@
+#pragma once
+#define _FFAT_H_
+#include "FS.h"
+extern fs::FS FFat;
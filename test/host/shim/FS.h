@@ -0,0 +1,220 @@
+#pragma once
+
+// Файловая система в памяти с интерфейсом fs::FS / fs::File ядра ESP32.
+// У каждого объекта FS своё дерево, так что тест может держать рядом
+// BUSYBOX_FS и «другую» ФС (SD, FFat).
+
+#include "Arduino.h"
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace fs {
+
+    enum SeekMode { SeekSet, SeekCur, SeekEnd };
+
+    struct Node {
+        std::vector<uint8_t> data;
+        bool                 dir = false;
+        time_t               mtime = 0;
+        size_t               readable = SIZE_MAX;   // повреждение: дальше этого смещения чтение не идёт
+    };
+
+    class FS;
+
+    struct FileState {
+        FS*         fs = nullptr;
+        std::string path;
+        std::string name;           // буфер для name()
+        std::string lastChild;      // позиция openNextFile
+        size_t      pos = 0;
+        bool        append = false;
+        bool        writable = false;
+    };
+
+    class File : public Stream {
+    public:
+        File() {}
+        explicit File(std::shared_ptr<FileState> state) : _state(state) {}
+
+        explicit operator bool() const { return node() != nullptr; }
+
+        size_t write(uint8_t c) override { return write(&c, 1); }
+        size_t write(const uint8_t* buffer, size_t size) override;
+        int available() override {
+            Node* n = node();
+            return n && !n->dir && _state->pos < n->data.size() ? int(n->data.size() - _state->pos) : 0;
+        }
+        int read() override {
+            uint8_t c;
+            return read(&c, 1) == 1 ? c : -1;
+        }
+        int peek() override {
+            Node* n = node();
+            return n && _state->pos < n->data.size() ? n->data[_state->pos] : -1;
+        }
+        size_t read(uint8_t* buffer, size_t size) {
+            Node* n = node();
+            size_t end = std::min(n ? n->data.size() : 0, n ? n->readable : 0);
+            if (!n || n->dir || _state->pos >= end) return 0;
+            size_t len = std::min(size, end - _state->pos);
+            memcpy(buffer, n->data.data() + _state->pos, len);
+            _state->pos += len;
+            return len;
+        }
+        bool seek(uint32_t pos, SeekMode mode = SeekSet) {
+            Node* n = node();
+            if (!n) return false;
+            size_t base = mode == SeekSet ? 0 : mode == SeekCur ? _state->pos : n->data.size();
+            if (base + pos > n->data.size()) return false;
+            _state->pos = base + pos;
+            return true;
+        }
+        size_t position() const { return _state ? _state->pos : 0; }
+        size_t size() const {
+            Node* n = node();
+            return n ? n->data.size() : 0;
+        }
+        void flush() override {}
+        void close() { _state.reset(); }
+        time_t getLastWrite() {
+            Node* n = node();
+            return n ? n->mtime : 0;
+        }
+        const char* path() const { return _state ? _state->path.c_str() : ""; }
+        const char* name() const {
+            if (!_state) return "";
+            _state->name = _state->path.substr(_state->path.rfind('/') + 1);
+            return _state->name.c_str();
+        }
+        bool isDirectory() {
+            Node* n = node();
+            return n && n->dir;
+        }
+        File openNextFile(const char* mode = "r");
+
+    private:
+        Node* node() const;
+
+        std::shared_ptr<FileState> _state;
+    };
+
+    class FS {
+    public:
+        FS() { nodes["/"].dir = true; }
+
+        bool begin(bool formatOnFail = false) { return true; }
+        void end() {}
+        bool format() {
+            nodes.clear();
+            nodes["/"].dir = true;
+            return true;
+        }
+
+        File open(const char* path, const char* mode = "r", bool create = false) {
+            opens++;
+            std::string p(path);
+            auto it = nodes.find(p);
+            if (mode[0] == 'r' && it == nodes.end()) return File();
+            if (it != nodes.end() && it->second.dir && mode[0] != 'r') return File();
+            if (it == nodes.end() || mode[0] == 'w') {
+                if (!exists(_parent(p).c_str())) return File();
+                Node& n = nodes[p];
+                n.data.clear();
+                n.mtime = ++clock;
+            }
+            auto state = std::make_shared<FileState>();
+            state->fs = this;
+            state->path = p;
+            state->append = mode[0] == 'a';
+            state->writable = mode[0] != 'r' || mode[1] == '+';
+            if (state->append) state->pos = nodes[p].data.size();
+            return File(state);
+        }
+        bool exists(const char* path) { return nodes.count(path) != 0; }
+        bool remove(const char* path) {
+            auto it = nodes.find(path);
+            if (it == nodes.end() || it->second.dir) return false;
+            nodes.erase(it);
+            return true;
+        }
+        bool rename(const char* from, const char* to) {
+            auto it = nodes.find(from);
+            if (it == nodes.end() || nodes.count(to) || !exists(_parent(to).c_str())) return false;
+            Node n = it->second;
+            nodes.erase(it);
+            nodes[to] = n;
+            return true;
+        }
+        bool mkdir(const char* path) {
+            if (nodes.count(path) || !exists(_parent(path).c_str())) return false;
+            nodes[path].dir = true;
+            return true;
+        }
+        bool rmdir(const char* path) {
+            std::string prefix = std::string(path) + "/";
+            auto it = nodes.lower_bound(prefix);
+            if (it != nodes.end() && it->first.compare(0, prefix.size(), prefix) == 0) return false;
+            return nodes.erase(path) != 0;
+        }
+        size_t totalBytes() { return 1 << 20; }
+        size_t usedBytes() {
+            size_t used = 0;
+            for (auto& kv : nodes) used += kv.second.data.size();
+            return used;
+        }
+
+        std::map<std::string, Node> nodes;
+        uint32_t opens = 0;         // вызовов open, для проверок в тестах
+        uint32_t writes = 0;        // вызовов File::write
+        time_t   clock = 1700000000;
+
+    private:
+        static std::string _parent(const std::string& path) {
+            size_t slash = path.rfind('/');
+            return slash == 0 || slash == std::string::npos ? "/" : path.substr(0, slash);
+        }
+    };
+
+    inline Node* File::node() const {
+        if (!_state) return nullptr;
+        auto it = _state->fs->nodes.find(_state->path);
+        return it == _state->fs->nodes.end() ? nullptr : &it->second;
+    }
+
+    inline size_t File::write(const uint8_t* buffer, size_t size) {
+        Node* n = node();
+        if (!n || n->dir || !_state->writable) return 0;
+        _state->fs->writes++;
+        if (_state->append) _state->pos = n->data.size();
+        if (n->data.size() < _state->pos + size) n->data.resize(_state->pos + size);
+        memcpy(n->data.data() + _state->pos, buffer, size);
+        _state->pos += size;
+        n->mtime = ++_state->fs->clock;
+        return size;
+    }
+
+    inline File File::openNextFile(const char*) {
+        if (!isDirectory()) return File();
+        std::map<std::string, Node>& nodes = _state->fs->nodes;
+        std::string prefix = _state->path == "/" ? "/" : _state->path + "/";
+        auto it = _state->lastChild.empty() ? nodes.lower_bound(prefix) : nodes.upper_bound(_state->lastChild);
+        for (; it != nodes.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+            if (it->first.size() == prefix.size() || it->first.find('/', prefix.size()) != std::string::npos) continue;
+            _state->lastChild = it->first;
+            auto child = std::make_shared<FileState>();
+            child->fs = _state->fs;
+            child->path = it->first;
+            return File(child);
+        }
+        return File();
+    }
+
+} // namespace fs
+
+using fs::FS;
+using fs::File;
+using fs::SeekMode;
+using fs::SeekSet;
+using fs::SeekCur;
+using fs::SeekEnd;
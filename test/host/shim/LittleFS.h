@@ -0,0 +1,4 @@
+#pragma once
+#define _LITTLEFS_H_
+#include "FS.h"
+extern fs::FS LittleFS;
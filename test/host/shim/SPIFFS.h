@@ -0,0 +1,4 @@
+#pragma once
+#define _SPIFFS_H_
+#include "FS.h"
+extern fs::FS SPIFFS;
@@ -0,0 +1,327 @@
+// Реализация замен Arduino, FreeRTOS и ESP-IDF для тестов на компьютере
+
+#include <Arduino.h>
+#include <FS.h>
+#include <esp_heap_caps.h>
+#include "shim.h"
+
+#include <pthread.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+
+HardwareSerial Serial;
+EspClass ESP;
+fs::FS LittleFS;
+fs::FS FFat;
+fs::FS SPIFFS;
+
+static const auto _start = std::chrono::steady_clock::now();
+
+uint32_t millis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+uint32_t micros() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - _start).count();
+}
+
+void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+void* heap_caps_malloc(size_t size, uint32_t caps) {
+    return (caps & MALLOC_CAP_SPIRAM) ? nullptr : malloc(size);
+}
+
+void heap_caps_get_info(multi_heap_info_t* info, uint32_t) {
+    memset(info, 0, sizeof(*info));
+}
+
+// --- FreeRTOS ---
+
+static std::recursive_mutex _critical;
+
+void portENTER_CRITICAL(portMUX_TYPE*) {
+    _critical.lock();
+}
+
+void portEXIT_CRITICAL(portMUX_TYPE*) {
+    _critical.unlock();
+}
+
+BaseType_t xPortGetCoreID() {
+    return 1;
+}
+
+// Дескриптор задачи — адрес переменной потока
+TaskHandle_t xTaskGetCurrentTaskHandle() {
+    static thread_local char task;
+    return &task;
+}
+
+struct TaskStart {
+    void (*task)(void*);
+    void* arg;
+    std::mutex m;
+    std::condition_variable cv;
+    TaskHandle_t handle = nullptr;
+};
+
+BaseType_t xTaskCreatePinnedToCore(void (*task)(void*), const char*, uint32_t, void* arg, UBaseType_t,
+                                   TaskHandle_t* handle, BaseType_t) {
+    TaskStart start;
+    start.task = task;
+    start.arg = arg;
+    std::thread([&start] {
+        void (*task)(void*) = start.task;
+        void* arg = start.arg;
+        {
+            // После освобождения мьютекса start уже может не существовать
+            std::lock_guard<std::mutex> lock(start.m);
+            start.handle = xTaskGetCurrentTaskHandle();
+            start.cv.notify_all();
+        }
+        task(arg);
+    }).detach();
+    std::unique_lock<std::mutex> lock(start.m);
+    start.cv.wait(lock, [&] { return start.handle != nullptr; });
+    if (handle) *handle = start.handle;
+    return pdPASS;
+}
+
+BaseType_t xTaskCreate(void (*task)(void*), const char* name, uint32_t stack, void* arg, UBaseType_t priority,
+                       TaskHandle_t* handle) {
+    return xTaskCreatePinnedToCore(task, name, stack, arg, priority, handle, tskNO_AFFINITY);
+}
+
+void vTaskDelete(TaskHandle_t task) {
+    // Завершить можно только текущую задачу
+    if (!task || task == xTaskGetCurrentTaskHandle()) pthread_exit(nullptr);
+}
+
+void vTaskDelay(TickType_t ticks) {
+    delay(ticks);
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t) {
+    return 1;
+}
+
+UBaseType_t uxTaskGetNumberOfTasks() {
+    return 0;
+}
+
+UBaseType_t uxTaskGetSystemState(TaskStatus_t*, UBaseType_t, uint32_t* total) {
+    if (total) *total = 0;
+    return 0;
+}
+
+// Семафор и очередь: одна структура, как в FreeRTOS
+struct ShimQueue {
+    std::mutex m;
+    std::condition_variable cv;
+    std::deque<std::vector<uint8_t>> items;
+    size_t length;
+    size_t itemSize;
+};
+
+template <typename Ready>
+static bool _wait(ShimQueue* q, std::unique_lock<std::mutex>& lock, TickType_t ticks, Ready ready) {
+    if (ticks == portMAX_DELAY) {
+        q->cv.wait(lock, ready);
+        return true;
+    }
+    return q->cv.wait_for(lock, std::chrono::milliseconds(ticks), ready);
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+    ShimQueue* q = new ShimQueue;
+    q->length = length;
+    q->itemSize = itemSize;
+    return q;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void* item, TickType_t ticks) {
+    ShimQueue* q = (ShimQueue*)queue;
+    std::unique_lock<std::mutex> lock(q->m);
+    if (!_wait(q, lock, ticks, [q] { return q->items.size() < q->length; })) return pdFALSE;
+    const uint8_t* p = (const uint8_t*)item;
+    q->items.emplace_back(p, p + q->itemSize);
+    q->cv.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void* item, TickType_t ticks) {
+    ShimQueue* q = (ShimQueue*)queue;
+    std::unique_lock<std::mutex> lock(q->m);
+    if (!_wait(q, lock, ticks, [q] { return !q->items.empty(); })) return pdFALSE;
+    if (q->itemSize) memcpy(item, q->items.front().data(), q->itemSize);
+    q->items.pop_front();
+    q->cv.notify_all();
+    return pdTRUE;
+}
+
+BaseType_t xQueueReset(QueueHandle_t queue) {
+    ShimQueue* q = (ShimQueue*)queue;
+    std::lock_guard<std::mutex> lock(q->m);
+    q->items.clear();
+    q->cv.notify_all();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+    ShimQueue* q = (ShimQueue*)queue;
+    std::lock_guard<std::mutex> lock(q->m);
+    return q->items.size();
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+    delete (ShimQueue*)queue;
+}
+
+// Семафор занят, когда в очереди длины 1 есть элемент
+SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return xQueueCreate(1, 0);
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    // Двоичный семафор создаётся занятым
+    SemaphoreHandle_t s = xQueueCreate(1, 0);
+    xQueueSend(s, nullptr, 0);
+    return s;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks) {
+    return xQueueSend(semaphore, nullptr, ticks);
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    return xQueueReceive(semaphore, nullptr, 0);
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    vQueueDelete(semaphore);
+}
+
+// --- Разделы flash ---
+
+struct ShimPartition {
+    esp_partition_t      part;
+    std::vector<uint8_t> data;
+};
+
+static std::list<ShimPartition>& _partitions() {
+    static std::list<ShimPartition> list;
+    return list;
+}
+
+std::vector<uint8_t>& shimPartition(const char* label, esp_partition_type_t type, uint8_t subtype, uint32_t size) {
+    uint32_t address = 0x10000;
+    for (ShimPartition& p : _partitions()) address = p.part.address + p.part.size;
+    _partitions().emplace_back();
+    ShimPartition& p = _partitions().back();
+    memset(&p.part, 0, sizeof(p.part));
+    p.part.type = type;
+    p.part.subtype = (esp_partition_subtype_t)subtype;
+    p.part.address = address;
+    p.part.size = size;
+    p.part.erase_size = 4096;
+    strncpy(p.part.label, label, sizeof(p.part.label) - 1);
+    p.data.assign(size, 0xFF);
+    return p.data;
+}
+
+static ShimPartition* _partition(const esp_partition_t* part) {
+    for (ShimPartition& p : _partitions()) {
+        if (&p.part == part) return &p;
+    }
+    return nullptr;
+}
+
+static bool _partMatch(const esp_partition_t& p, esp_partition_type_t type, esp_partition_subtype_t subtype,
+                       const char* label) {
+    return (type == ESP_PARTITION_TYPE_ANY || p.type == type) &&
+           (subtype == ESP_PARTITION_SUBTYPE_ANY || p.subtype == subtype) && (!label || strcmp(p.label, label) == 0);
+}
+
+struct ShimIterator {
+    std::list<ShimPartition>::iterator it;
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    const char* label;
+};
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    for (ShimPartition& p : _partitions()) {
+        if (_partMatch(p.part, type, subtype, label)) return &p.part;
+    }
+    return nullptr;
+}
+
+static esp_partition_iterator_t _seek(ShimIterator* i) {
+    while (i->it != _partitions().end() && !_partMatch(i->it->part, i->type, i->subtype, i->label)) ++i->it;
+    if (i->it != _partitions().end()) return i;
+    delete i;
+    return nullptr;
+}
+
+esp_partition_iterator_t esp_partition_find(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                            const char* label) {
+    return _seek(new ShimIterator{_partitions().begin(), type, subtype, label});
+}
+
+esp_partition_iterator_t esp_partition_next(esp_partition_iterator_t it) {
+    ShimIterator* i = (ShimIterator*)it;
+    ++i->it;
+    return _seek(i);
+}
+
+const esp_partition_t* esp_partition_get(esp_partition_iterator_t it) {
+    return &((ShimIterator*)it)->it->part;
+}
+
+void esp_partition_iterator_release(esp_partition_iterator_t it) {
+    delete (ShimIterator*)it;
+}
+
+esp_err_t esp_partition_read(const esp_partition_t* part, size_t offset, void* dst, size_t size) {
+    ShimPartition* p = _partition(part);
+    if (!p || offset + size > p->data.size()) return ESP_FAIL;
+    memcpy(dst, p->data.data() + offset, size);
+    return ESP_OK;
+}
+
+// Запись во flash только сбрасывает биты
+esp_err_t esp_partition_write(const esp_partition_t* part, size_t offset, const void* src, size_t size) {
+    ShimPartition* p = _partition(part);
+    if (!p || offset + size > p->data.size()) return ESP_FAIL;
+    for (size_t i = 0; i < size; i++) p->data[offset + i] &= ((const uint8_t*)src)[i];
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t* part, size_t offset, size_t size) {
+    ShimPartition* p = _partition(part);
+    if (!p || offset % 4096 || size % 4096 || offset + size > p->data.size()) return ESP_FAIL;
+    memset(p->data.data() + offset, 0xFF, size);
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* part, size_t offset, size_t size, esp_partition_mmap_memory_t,
+                             const void** out, esp_partition_mmap_handle_t* handle) {
+    ShimPartition* p = _partition(part);
+    if (!p || offset + size > p->data.size()) return ESP_FAIL;
+    *out = p->data.data() + offset;
+    *handle = 1;
+    return ESP_OK;
+}
+
+void esp_partition_munmap(esp_partition_mmap_handle_t) {}
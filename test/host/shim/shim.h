@@ -0,0 +1,19 @@
+#pragma once
+
+// Вспомогательное для тестов: проверки и разделы flash в памяти
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+#include <esp_partition.h>
+
+#define CHECK(cond)                                                             \
+    do {                                                                        \
+        if (!(cond)) {                                                          \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                            \
+        }                                                                       \
+    } while (0)
+
+// Добавляет раздел (стёртый, 0xFF) и возвращает его содержимое
+std::vector<uint8_t>& shimPartition(const char* label, esp_partition_type_t type, uint8_t subtype, uint32_t size);
@@ -0,0 +1,57 @@
+// Фоновый исполнитель: одновременный asyncBegin из нескольких задач и
+// неудача cp, если источник прочитан не полностью
+
+#include <LittleFS.h>
+#include "Busybox.h"
+#include "shim.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Busybox;
+
+static std::atomic<int> finished(0);
+static std::atomic<int> failed(0);
+
+static void done(uint32_t, bool ok, void*) {
+    if (!ok) failed++;
+    finished++;
+}
+
+static void wait(int count) {
+    for (int i = 0; i < 500 && finished < count; i++) delay(10);
+    CHECK(finished == count);
+}
+
+int main() {
+    std::vector<std::thread> threads;
+    std::atomic<int> started(0);
+    for (int i = 0; i < 8; i++) {
+        threads.emplace_back([&] {
+            if (asyncBegin()) started++;
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    CHECK(started == 8);
+    CHECK(_async().task && _async().queue && !_async().starting);
+    TaskHandle_t task = _async().task;
+    CHECK(asyncBegin() && _async().task == task);
+
+    File f = LittleFS.open("/src.bin", "w");
+    for (int i = 0; i < 10000; i++) f.write((uint8_t)i);
+    f.close();
+
+    CHECK(async(AsyncOp::Cp, "/src.bin", "/copy.bin", done) != 0);
+    wait(1);
+    CHECK(failed == 0 && LittleFS.nodes["/copy.bin"].data == LittleFS.nodes["/src.bin"].data);
+
+    // Чтение обрывается посередине: копия неполная, запрос завершается с ошибкой
+    LittleFS.nodes["/src.bin"].readable = 6000;
+    CHECK(async(AsyncOp::Cp, "/src.bin", "/short.bin", done) != 0);
+    wait(2);
+    CHECK(failed == 1 && LittleFS.nodes["/short.bin"].data.size() == 6000);
+
+    puts("test_async: OK");
+    return 0;
+}
@@ -0,0 +1,55 @@
+// Счётчики блочного кэша при чтении из нескольких задач: каждая порция
+// BlockReader учитывается ровно один раз
+
+#include <LittleFS.h>
+#include "Busybox.h"
+#include "shim.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Busybox;
+
+int main() {
+    std::vector<uint8_t> data(20000);
+    for (size_t i = 0; i < data.size(); i++) data[i] = (uint8_t)(i * 7);
+    File f = LittleFS.open("/data.bin", "w");
+    f.write(data.data(), data.size());
+    f.close();
+
+    cachestat(true);
+    std::atomic<uint32_t> chunks(0);
+    std::atomic<uint32_t> bytes(0);
+    std::atomic<bool> broken(false);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 6; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 20; i++) {
+                File file = LittleFS.open("/data.bin", "r");
+                BlockReader reader(file);
+                size_t len;
+                size_t offset = 0;
+                while (const uint8_t* chunk = reader.next(len)) {
+                    if (memcmp(chunk, data.data() + offset, len) != 0) broken = true;
+                    offset += len;
+                    chunks++;
+                }
+                bytes += offset;
+                if (offset != data.size()) broken = true;
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    CHECK(!broken);
+
+    const CacheStats& s = _cachePool().stats;
+    CHECK(s.hits + s.misses == chunks);
+    CHECK(s.bytesRead == bytes);
+    CHECK(s.fills == s.misses);
+    cachestat(true);
+    CHECK(s.hits == 0 && s.misses == 0 && s.bytesRead == 0);
+
+    puts("test_cache: OK");
+    return 0;
+}
@@ -0,0 +1,28 @@
+// cat: обычный файл открывается один раз, кольцевой журнал узнаётся по
+// сигнатуре из того же открытого файла
+
+#include <LittleFS.h>
+#include "Busybox.h"
+#include "shim.h"
+
+using namespace Busybox;
+
+int main() {
+    CHECK(write("/plain.txt", "hello"));
+    uint32_t opens = LittleFS.opens;
+    CHECK(cat("/plain.txt"));
+    CHECK(LittleFS.opens - opens == 1);
+
+    CHECK(write("/tiny.txt", "ab"));    // короче сигнатуры
+    CHECK(cat("/tiny.txt"));
+    CHECK(!cat("/missing.txt"));
+
+    RingFile ring("/ring.log", 4096, 64);
+    CHECK(ring.begin());
+    CHECK(ring.append("first"));
+    CHECK(ring.append("second"));
+    CHECK(cat("/ring.log"));
+
+    puts("test_cat: OK");
+    return 0;
+}
@@ -0,0 +1,103 @@
+// fsck на повреждённом образе: обход, исправление временных файлов и то,
+// что проверка другой ФС не трогает блокировку и уведомления BUSYBOX_FS
+
+#include <LittleFS.h>
+#include "Busybox.h"
+#include <FFat.h>           // после Busybox.h: BUSYBOX_FS остаётся LittleFS
+#include "shim.h"
+
+#include <chrono>
+#include <future>
+#include <thread>
+
+using namespace Busybox;
+
+static void put(fs::FS& fs, const char* path, const char* text) {
+    File f = fs.open(path, "w");
+    f.write((const uint8_t*)text, strlen(text));
+    f.close();
+}
+
+static std::string get(fs::FS& fs, const char* path) {
+    auto it = fs.nodes.find(path);
+    return it == fs.nodes.end() ? "<none>" : std::string(it->second.data.begin(), it->second.data.end());
+}
+
+// Образ после сбоя питания: временные файлы на разных стадиях _tmpCommit,
+// файл с нечитаемым хвостом и слишком глубокий каталог
+static void damage(fs::FS& fs) {
+    fs.format();
+    fs.mkdir("/cfg");
+    put(fs, "/cfg/a.json", "old a");
+    put(fs, "/cfg/a.json" BUSYBOX_TMP_SUFFIX, "partial");          // запись не дошла до конца
+    put(fs, "/cfg/b.json" BUSYBOX_TMP_DONE_SUFFIX, "new b");       // основной файл уже удалён
+    put(fs, "/cfg/c.json", "old c");
+    put(fs, "/cfg/c.json" BUSYBOX_TMP_DONE_SUFFIX, "new c");       // до удаления основного
+    put(fs, "/user.tmp", "not ours");
+    put(fs, "/log.bin", "0123456789");
+    fs.nodes["/log.bin"].readable = 4;
+    std::string dir;
+    for (int i = 0; i <= BUSYBOX_WALK_DEPTH; i++) {
+        dir += "/d";
+        fs.mkdir(dir.c_str());
+    }
+    put(fs, (dir + "/deep").c_str(), "x");
+}
+
+static void checkRepaired(fs::FS& fs) {
+    CHECK(get(fs, "/cfg/a.json") == "old a");
+    CHECK(!fs.exists("/cfg/a.json" BUSYBOX_TMP_SUFFIX));
+    CHECK(get(fs, "/cfg/b.json") == "new b");
+    CHECK(get(fs, "/cfg/c.json") == "new c");
+    CHECK(!fs.exists("/cfg/b.json" BUSYBOX_TMP_DONE_SUFFIX) && !fs.exists("/cfg/c.json" BUSYBOX_TMP_DONE_SUFFIX));
+    CHECK(get(fs, "/user.tmp") == "not ours");
+}
+
+int main() {
+    // Проверка без исправления ничего не меняет
+    damage(LittleFS);
+    FsckReport r;
+    CHECK(!fsck(LittleFS, FsckMode::Check, nullptr, nullptr, &r));
+    CHECK(r.orphans == 3 && r.repaired == 0);
+    CHECK(r.errors == 1);                       // /log.bin читается не полностью
+    CHECK(r.skipped == 1);
+    CHECK(r.bytes == 4 + 5 + 7 + 5 + 5 + 5 + 8);
+    CHECK(get(LittleFS, "/cfg/a.json" BUSYBOX_TMP_SUFFIX) == "partial");
+
+    // Исправление смонтированной ФС публикует изменения
+    {
+        Watcher watcher;
+        CHECK(!fsck(LittleFS, FsckMode::Repair, nullptr, nullptr, &r));    // ошибка чтения остаётся
+        CHECK(r.orphans == 3 && r.repaired == 3);
+        checkRepaired(LittleFS);
+        CHECK(watcher.pending() == 5);          // Remove, 2 x (MoveFrom, MoveTo)
+        CHECK(fsck(LittleFS, FsckMode::Repair, nullptr, nullptr, &r) == false && r.orphans == 0);
+    }
+
+    // Другая ФС: без блокировки BUSYBOX_FS и без событий
+    damage(FFat);
+    LittleFS.format();
+    {
+        Watcher watcher;
+        std::promise<void> release;
+        std::promise<void> held;
+        std::thread owner([&] {
+            WriteLock lock;
+            held.set_value();
+            release.get_future().wait();
+        });
+        held.get_future().wait();
+        auto done = std::async(std::launch::async, [&] { return fsck(FFat, FsckMode::Repair, nullptr, nullptr, &r); });
+        bool finished = done.wait_for(std::chrono::seconds(5)) == std::future_status::ready;
+        release.set_value();
+        owner.join();
+        CHECK(finished);
+        CHECK(r.orphans == 3 && r.repaired == 3);
+        checkRepaired(FFat);
+        CHECK(watcher.pending() == 0);
+        CHECK(LittleFS.nodes.size() == 1);
+    }
+
+    puts("test_fsck: OK");
+    return 0;
+}
@@ -0,0 +1,192 @@
+// RwLock из потоков: взаимоисключение под нагрузкой, запись изнутри чтения
+// той же задачи, задачи сверх таблицы читателей и счётчики lockStats
+
+#include <LittleFS.h>
+#include "Busybox.h"
+#include "shim.h"
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+using namespace Busybox;
+
+static_assert(BUSYBOX_LOCK_ENABLED, "test_lock needs BUSYBOX_LOCKING");
+
+static std::atomic<int> readers(0);
+static std::atomic<int> writers(0);
+static std::atomic<bool> broken(false);
+
+static void reading() {
+    readers++;
+    if (writers != 0) broken = true;
+}
+
+static void writing() {
+    if (++writers != 1 || readers != 0) broken = true;
+}
+
+// Поток, занимающий чтение до сигнала
+struct Holder {
+    std::promise<void> held;
+    std::promise<void> release;
+    std::thread        thread;
+
+    void start() {
+        thread = std::thread([this] {
+            ReadLock lock;
+            reading();
+            held.set_value();
+            release.get_future().wait();
+            readers--;
+        });
+        held.get_future().wait();
+    }
+    void stop() {
+        release.set_value();
+        thread.join();
+    }
+};
+
+// Запись в отдельном потоке; true если захвачена за timeoutMs
+static std::future<void> writeAsync(std::atomic<bool>& got) {
+    return std::async(std::launch::async, [&got] {
+        WriteLock lock;
+        writing();
+        got = true;
+        writers--;
+    });
+}
+
+static bool settles(std::future<void>& f, int timeoutMs) {
+    return f.wait_for(std::chrono::milliseconds(timeoutMs)) == std::future_status::ready;
+}
+
+// Много потоков (больше таблицы читателей) со вложенными захватами
+static void stress() {
+    std::vector<std::thread> threads;
+    for (int t = 0; t < BUSYBOX_LOCK_READERS + 4; t++) {
+        threads.emplace_back([t] {
+            for (int i = 0; i < 300; i++) {
+                if ((i + t) % 5 == 0) {
+                    WriteLock lock;
+                    writing();
+                    { WriteLock nested; }
+                    { ReadLock nested; }
+                    writers--;
+                } else {
+                    ReadLock lock;
+                    reading();
+                    { ReadLock nested; if (writers != 0) broken = true; }
+                    if (t % 4 == 0 && i % 7 == 0) {
+                        // Запись изнутри своего чтения
+                        readers--;
+                        {
+                            WriteLock write;
+                            writing();
+                            writers--;
+                        }
+                        readers++;
+                        if (writers != 0) broken = true;
+                    }
+                    readers--;
+                }
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    CHECK(!broken);
+}
+
+int main() {
+    stress();
+
+    // Запись изнутри чтения ждёт других читателей, а после неё чтение
+    // возвращается с прежней глубиной
+    {
+        Holder other;
+        other.start();
+        std::atomic<bool> wrote(false);
+        std::atomic<bool> restored(false);
+        std::promise<void> proceed;
+        std::thread self([&] {
+            ReadLock outer;
+            ReadLock inner;
+            {
+                WriteLock write;
+                wrote = true;
+            }
+            restored = true;
+            proceed.get_future().wait();
+        });
+        delay(50);
+        CHECK(!wrote);
+        other.stop();
+        for (int i = 0; i < 200 && !restored; i++) delay(5);
+        CHECK(wrote && restored);
+
+        std::atomic<bool> got(false);
+        std::future<void> writer = writeAsync(got);
+        CHECK(!settles(writer, 50));            // чтение восстановлено
+        proceed.set_value();
+        self.join();
+        CHECK(settles(writer, 2000) && got);
+    }
+
+    // Таблица читателей занята: задачи сверх неё читают без слота,
+    // и после их выхода запись снова доступна
+    {
+        Holder holders[BUSYBOX_LOCK_READERS];
+        for (Holder& h : holders) h.start();
+        std::vector<std::thread> extra;
+        for (int t = 0; t < 4; t++) {
+            extra.emplace_back([] {
+                ReadLock lock;
+                ReadLock nested;
+                reading();
+                delay(5);
+                readers--;
+            });
+        }
+        for (std::thread& t : extra) t.join();
+
+        std::atomic<bool> got(false);
+        std::future<void> writer = writeAsync(got);
+        CHECK(!settles(writer, 50));
+        for (Holder& h : holders) h.stop();
+        CHECK(settles(writer, 2000) && got);
+        CHECK(!broken);
+    }
+
+    // Счётчики: вложенные захваты не учитываются, ожидание записи попадает в writeWaitUs
+    {
+        lockStats(true);
+        {
+            ReadLock read;
+            ReadLock nested;
+        }
+        {
+            WriteLock write;
+            ReadLock nested;
+        }
+        Holder h;
+        h.start();
+        std::atomic<bool> got(false);
+        std::future<void> writer = writeAsync(got);
+        delay(30);
+        h.stop();
+        CHECK(settles(writer, 2000));
+
+        LockStats s = lockStats();
+        CHECK(s.reads == 2);                    // read и Holder
+        CHECK(s.writes == 3);                   // write, writeAsync и сам lockStats
+        CHECK(s.writeWaitUs >= 20000 && s.maxWaitUs >= 20000);
+        CHECK(lockStats(true).writes == 4);
+        CHECK(lockStats().writes == 1 && lockStats().reads == 0);
+    }
+
+    puts("test_lock: OK");
+    return 0;
+}
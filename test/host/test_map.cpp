@@ -0,0 +1,38 @@
+// Кэш map(): попадание не открывает файл, запись командами Busybox
+// сбрасывает слот, запись в обход Busybox видна после mapflush()
+
+#include <LittleFS.h>
+#include "Busybox.h"
+#include "shim.h"
+
+using namespace Busybox;
+
+static std::string mapped(const char* path) {
+    MapView view = map(path);
+    std::string text = view ? std::string((const char*)view.data, view.size) : "<none>";
+    unmap(view);
+    return text;
+}
+
+int main() {
+    CHECK(write("/a.txt", "first"));
+    CHECK(mapped("/a.txt") == "first");
+
+    uint32_t opens = LittleFS.opens;
+    for (int i = 0; i < 10; i++) CHECK(mapped("/a.txt") == "first");
+    CHECK(LittleFS.opens == opens);
+
+    CHECK(write("/a.txt", "second"));
+    CHECK(mapped("/a.txt") == "second");
+
+    // Запись напрямую через LittleFS кэш не видит до mapflush()
+    File f = LittleFS.open("/a.txt", "w");
+    f.write((const uint8_t*)"third", 5);
+    f.close();
+    CHECK(mapped("/a.txt") == "second");
+    mapflush();
+    CHECK(mapped("/a.txt") == "third");
+
+    puts("test_map: OK");
+    return 0;
+}
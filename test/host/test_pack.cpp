@@ -0,0 +1,129 @@
+// Образ BBPK, собранный tools/bbpack.py: чтение через map/stat/cat и отказ
+// подключать образы с испорченными записями, слотами и смещениями
+
+#include <LittleFS.h>
+#include "Busybox.h"
+#include "shim.h"
+
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+using namespace Busybox;
+
+static const char* DIR_ = "build/pack_data";
+static const char* IMAGE = "build/pack.bin";
+
+static void put(const std::string& path, const std::string& text) {
+    FILE* f = fopen((std::string(DIR_) + path).c_str(), "wb");
+    CHECK(f);
+    fwrite(text.data(), 1, text.size(), f);
+    fclose(f);
+}
+
+static std::vector<uint32_t> build() {
+    CHECK(system("rm -rf build/pack_data && mkdir -p build/pack_data/css") == 0);
+    put("/index.html", "<html>hello</html>");
+    put("/css/site.css", "body{}");
+    put("/empty.txt", "");
+    std::string blob;
+    for (int i = 0; i < 1000; i++) blob += char('A' + i % 26);
+    put("/blob.bin", blob);
+    std::string cmd = std::string("python3 ../../tools/bbpack.py build ") + DIR_ + " " + IMAGE + " > /dev/null";
+    CHECK(system(cmd.c_str()) == 0);
+
+    FILE* f = fopen(IMAGE, "rb");
+    CHECK(f);
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    std::vector<uint32_t> image((size + 3) / 4);
+    CHECK(fread(image.data(), 1, size, f) == (size_t)size);
+    fclose(f);
+    return image;
+}
+
+static std::string mapped(const char* path) {
+    MapView view = map(path);
+    std::string text = view ? std::string((const char*)view.data, view.size) : "<none>";
+    unmap(view);
+    return text;
+}
+
+// Испорченная копия образа не должна подключаться
+template <typename F>
+static void reject(const std::vector<uint32_t>& image, F damage) {
+    std::vector<uint32_t> copy = image;
+    uint8_t* base = (uint8_t*)copy.data();
+    damage((PackHeader*)base, (PackEntry*)(base + ((PackHeader*)base)->entriesOffset),
+           (uint16_t*)(base + ((PackHeader*)base)->hashOffset));
+    CHECK(!packBegin(base, copy.size() * 4));
+    CHECK(!_packOwns("/rom/index.html"));
+}
+
+int main() {
+    std::vector<uint32_t> image = build();
+    const uint8_t* base = (const uint8_t*)image.data();
+    const PackHeader* h = (const PackHeader*)base;
+    CHECK(h->count == 4);
+
+    // Образ из памяти
+    CHECK(packBegin(base, image.size() * 4));
+    CHECK(mapped("/rom/index.html") == "<html>hello</html>");
+    CHECK(mapped("/rom/css/site.css") == "body{}");
+    CHECK(mapped("/rom/blob.bin").size() == 1000);
+    CHECK(mapped("/rom/missing") == "<none>");
+    FileStat st;
+    CHECK(stat("/rom/empty.txt", st) && st.size == 0 && !st.isDir);
+    CHECK(stat("/rom/css", st) && st.isDir);
+    CHECK(cat("/rom/css/site.css"));
+    ls("/rom");
+    packEnd();
+    CHECK(!_packOwns("/rom/index.html"));
+
+    // Тот же образ в разделе flash
+    std::vector<uint8_t>& part = shimPartition("assets", ESP_PARTITION_TYPE_DATA, 0x40, 0x10000);
+    memcpy(part.data(), base, h->totalSize);
+    CHECK(packBegin("assets"));
+    CHECK(mapped("/rom/index.html") == "<html>hello</html>");
+    packEnd();
+
+    // Образ короче заголовка или обрезан
+    CHECK(!packBegin(base, sizeof(PackHeader) - 1));
+    CHECK(!packBegin(base, h->totalSize - 1));
+
+    // Таблица записей: count * sizeof(PackEntry) переполняет 32 бита
+    reject(image, [](PackHeader* h, PackEntry*, uint16_t*) { h->count = 0x10000000; });
+    reject(image, [](PackHeader* h, PackEntry*, uint16_t*) { h->entriesOffset = 0xFFFFFFF0; });
+    reject(image, [](PackHeader* h, PackEntry*, uint16_t*) { h->hashSlots = 0x80000000; });
+
+    // Имя вне таблицы путей или без завершающего нуля внутри образа
+    reject(image, [](PackHeader* h, PackEntry* e, uint16_t*) { e[1].nameOffset = h->totalSize; });
+    reject(image, [](PackHeader* h, PackEntry* e, uint16_t*) {
+        uint8_t* base = (uint8_t*)h;
+        base[h->totalSize - 1] = 'x';
+        e[0].nameOffset = h->totalSize - 1 - h->namesOffset;
+    });
+
+    // Данные за концом образа, в том числе с переполнением dataOffset + size
+    reject(image, [](PackHeader* h, PackEntry* e, uint16_t*) { e[2].size = h->totalSize; });
+    reject(image, [](PackHeader*, PackEntry* e, uint16_t*) {
+        e[2].dataOffset = 0xFFFFFFF0;
+        e[2].size = 0x20;
+    });
+
+    // Слот хеш-таблицы указывает за последнюю запись
+    reject(image, [](PackHeader* h, PackEntry*, uint16_t* slots) {
+        for (uint32_t i = 0; i < h->hashSlots; i++) {
+            if (slots[i] == 0) slots[i] = h->count + 1;
+        }
+    });
+
+    // После отказов исходный образ подключается как прежде
+    CHECK(packBegin(base, image.size() * 4));
+    CHECK(mapped("/rom/blob.bin").substr(0, 3) == "ABC");
+    packEnd();
+
+    puts("test_pack: OK");
+    return 0;
+}
@@ -0,0 +1,44 @@
+// sort с несколькими проходами слияния: результат и запись блоками при
+// пуле кэша по умолчанию (2 блока)
+
+#include <LittleFS.h>
+#include "Busybox.h"
+#include "shim.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace Busybox;
+
+int main() {
+    std::vector<std::string> lines;
+    std::string text;
+    for (int i = 0; i < 3000; i++) {
+        char line[32];
+        snprintf(line, sizeof(line), "line %08u", (unsigned)((i * 2654435761u) % 1000003));
+        lines.push_back(line);
+        text += line;
+        text += '\n';
+    }
+    File f = LittleFS.open("/in.txt", "w");
+    f.write((const uint8_t*)text.data(), text.size());
+    f.close();
+
+    // 45 КБ при BUSYBOX_SORT_MEMORY 8 КБ: больше BUSYBOX_SORT_FANIN серий, два прохода слияния
+    uint32_t writes = LittleFS.writes;
+    CHECK(sort("/in.txt", "/out.txt"));
+    writes = LittleFS.writes - writes;
+    printf("sort: %u writes\n", writes);
+    CHECK(writes < 200);
+
+    std::sort(lines.begin(), lines.end());
+    std::string expected;
+    for (const std::string& line : lines) expected += line + "\n";
+    const std::vector<uint8_t>& out = LittleFS.nodes["/out.txt"].data;
+    CHECK(std::string(out.begin(), out.end()) == expected);
+    for (auto& kv : LittleFS.nodes) CHECK(kv.first.find(".bb") == std::string::npos);
+
+    puts("test_sort: OK");
+    return 0;
+}
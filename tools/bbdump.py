@@ -0,0 +1,131 @@
+#!/usr/bin/env python3
+"""Извлечение файлов из записи сеанса с выводом dump(path, DumpMode).
+
+Ищет в записи заголовки "BBB64|BBRAW|BBHEX SIZE CRC32 PATH", декодирует
+данные (base64, двоичные, Intel HEX), проверяет длину и CRC-32 и сохраняет
+файлы под их именами в каталог -o.
+
+Пример:
+    stty -F /dev/ttyUSB0 921600 raw -echo
+    cat /dev/ttyUSB0 > session.bin          # на устройстве: dump("/crash.bin", DumpMode::Raw)
+    python3 tools/bbdump.py session.bin -o out
+    python3 tools/bbdump.py --check session.bin
+
+Режим Raw требует записи без преобразования символов (raw-режим порта);
+Base64 и Intel HEX переносят и вывод обычного монитора порта.
+"""
+
+import argparse
+import base64
+import binascii
+import os
+import re
+import sys
+
+HEADER = re.compile(rb"BB(B64|RAW|HEX) (\d+) ([0-9A-Fa-f]{8}) ([^\r\n]*)\r?\n")
+
+
+def decode_base64(data, pos):
+    end = data.find(b"BBEND", pos)
+    if end < 0:
+        raise ValueError("no BBEND")
+    text = b"".join(data[pos:end].split())
+    return base64.b64decode(text, validate=True), end + 5
+
+
+def decode_raw(data, pos, size):
+    if pos + size > len(data):
+        raise ValueError("capture ends after %d of %d bytes" % (len(data) - pos, size))
+    return data[pos:pos + size], pos + size
+
+
+def decode_ihex(data, pos):
+    out = bytearray()
+    upper = 0
+    for line in re.finditer(rb"[^\r\n]+", data[pos:]):
+        record = line.group(0).strip()
+        if not record.startswith(b":"):
+            raise ValueError("bad record %r" % record[:20])
+        raw = binascii.unhexlify(record[1:])
+        if sum(raw) & 0xFF:
+            raise ValueError("checksum error in %r" % record[:20])
+        length, address, kind = raw[0], raw[1] << 8 | raw[2], raw[3]
+        payload = raw[4:4 + length]
+        if kind == 0x00:
+            offset = upper + address
+            if offset != len(out):
+                raise ValueError("gap at 0x%X" % offset)
+            out += payload
+        elif kind == 0x04:
+            upper = (payload[0] << 8 | payload[1]) << 16
+        elif kind == 0x01:
+            return bytes(out), pos + line.end()
+        else:
+            raise ValueError("unsupported record type %02X" % kind)
+    raise ValueError("no end-of-file record")
+
+
+def extract(data):
+    """Найденные файлы: (path, content или None, ошибка)."""
+    pos = 0
+    while True:
+        m = HEADER.search(data, pos)
+        if not m:
+            return
+        mode, size, crc = m.group(1), int(m.group(2)), int(m.group(3), 16)
+        path = m.group(4).decode("utf-8", "replace")
+        try:
+            if mode == b"B64":
+                content, pos = decode_base64(data, m.end())
+            elif mode == b"RAW":
+                content, pos = decode_raw(data, m.end(), size)
+            else:
+                content, pos = decode_ihex(data, m.end())
+        except (ValueError, binascii.Error) as e:
+            pos = m.end()
+            yield path, None, str(e)
+            continue
+        if len(content) != size:
+            yield path, None, "size %d, expected %d" % (len(content), size)
+        elif binascii.crc32(content) & 0xFFFFFFFF != crc:
+            yield path, None, "CRC mismatch"
+        else:
+            yield path, content, None
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode Busybox dump output")
+    parser.add_argument("capture", help="запись сеанса ('-' — stdin)")
+    parser.add_argument("-o", "--out", default=".", help="каталог для файлов")
+    parser.add_argument("--check", action="store_true", help="только проверить, не сохранять")
+    args = parser.parse_args()
+
+    if args.capture == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.capture, "rb") as f:
+            data = f.read()
+
+    found = failed = 0
+    for path, content, error in extract(data):
+        found += 1
+        if error:
+            failed += 1
+            print("%s: %s" % (path, error), file=sys.stderr)
+            continue
+        if args.check:
+            print("%s: %d bytes OK" % (path, len(content)))
+            continue
+        os.makedirs(args.out, exist_ok=True)
+        target = os.path.join(args.out, os.path.basename(path) or "dump.bin")
+        with open(target, "wb") as f:
+            f.write(content)
+        print("%s -> %s (%d bytes)" % (path, target, len(content)))
+
+    if not found:
+        sys.exit("no dump found in %s" % args.capture)
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""Сборка упакованного образа ресурсов Busybox (формат BBPK) из каталога.
+
+Пример:
+    python3 tools/bbpack.py build data/www assets.bin
+    python3 tools/bbpack.py list assets.bin
+    esptool.py write_flash 0x310000 assets.bin   # адрес раздела с образом
+
+Формат описан в Busybox_Pack.h.
+"""
+
+import argparse
+import os
+import struct
+import sys
+
+MAGIC = 0x4B504242  # "BBPK"
+VERSION = 1
+HEADER = struct.Struct("<IHHIIIIII")
+ENTRY = struct.Struct("<IIII")
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in data:
+        h ^= b
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def align_up(value, align):
+    return (value + align - 1) // align * align
+
+
+def collect(root):
+    files = []
+    for dirpath, _, names in os.walk(root):
+        for name in names:
+            full = os.path.join(dirpath, name)
+            rel = os.path.relpath(full, root).replace(os.sep, "/")
+            files.append(("/" + rel).encode("utf-8"))
+    files.sort()
+    return files
+
+
+def build(root, out, align):
+    paths = collect(root)
+    count = len(paths)
+    if count > 0xFFFF:
+        sys.exit("too many files: %d (max 65535)" % count)
+
+    slots = 2
+    while slots < count * 2:
+        slots *= 2
+
+    entries_off = HEADER.size
+    hash_off = entries_off + count * ENTRY.size
+    names_off = align_up(hash_off + slots * 2, 4)
+
+    names = bytearray()
+    name_offsets = []
+    for p in paths:
+        name_offsets.append(len(names))
+        names += p + b"\0"
+
+    data = bytearray()
+    data_start = align_up(names_off + len(names), align)
+    entries = []
+    for i, p in enumerate(paths):
+        with open(os.path.join(root, p.decode("utf-8").lstrip("/")), "rb") as f:
+            content = f.read()
+        data += b"\0" * (align_up(len(data), align) - len(data))
+        entries.append((name_offsets[i], data_start + len(data), len(content), fnv1a(p)))
+        data += content
+
+    table = [0] * slots
+    for i, e in enumerate(entries):
+        j = e[3] & (slots - 1)
+        while table[j]:
+            j = (j + 1) & (slots - 1)
+        table[j] = i + 1
+
+    total = data_start + len(data)
+    image = bytearray(total)
+    HEADER.pack_into(image, 0, MAGIC, VERSION, align, count, slots,
+                     entries_off, hash_off, names_off, total)
+    for i, e in enumerate(entries):
+        ENTRY.pack_into(image, entries_off + i * ENTRY.size, *e)
+    struct.pack_into("<%dH" % slots, image, hash_off, *table)
+    image[names_off:names_off + len(names)] = names
+    image[data_start:total] = data
+
+    with open(out, "wb") as f:
+        f.write(image)
+    print("%s: %d files, %d bytes" % (out, count, total))
+
+
+def read_image(path):
+    with open(path, "rb") as f:
+        image = f.read()
+    magic, version, align, count, slots, entries_off, hash_off, names_off, total = \
+        HEADER.unpack_from(image, 0)
+    if magic != MAGIC or version != VERSION:
+        sys.exit("%s: not a BBPK image" % path)
+    entries = [ENTRY.unpack_from(image, entries_off + i * ENTRY.size) for i in range(count)]
+    table = struct.unpack_from("<%dH" % slots, image, hash_off)
+    return image, entries, table, names_off
+
+
+def list_image(path):
+    image, entries, table, names_off = read_image(path)
+    ok = True
+    for i, (name_off, data_off, size, h) in enumerate(entries):
+        end = image.index(b"\0", names_off + name_off)
+        name = image[names_off + name_off:end]
+        # Проверка, что запись находится через хеш-таблицу
+        j = h & (len(table) - 1)
+        while table[j] and table[j] != i + 1:
+            j = (j + 1) & (len(table) - 1)
+        found = table[j] == i + 1 and fnv1a(name) == h
+        ok = ok and found
+        print("%8d  %08X  %s%s" % (size, data_off, name.decode("utf-8"), "" if found else "  [BAD INDEX]"))
+    return 0 if ok else 1
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    b = sub.add_parser("build", help="собрать образ из каталога")
+    b.add_argument("dir")
+    b.add_argument("out")
+    b.add_argument("--align", type=int, default=16, help="выравнивание данных файлов (по умолчанию 16)")
+    l = sub.add_parser("list", help="вывести содержимое образа и проверить индекс")
+    l.add_argument("image")
+    args = parser.parse_args()
+
+    if args.cmd == "build":
+        if args.align < 4 or args.align & (args.align - 1):
+            sys.exit("align must be a power of two >= 4")
+        build(args.dir, args.out, args.align)
+        return 0
+    return list_image(args.image)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,116 @@
+#!/usr/bin/env python3
+"""Размер кода Busybox по командам в собранной прошивке.
+
+Читает таблицу символов ELF (nm) и суммирует размеры функций и данных
+namespace Busybox по командам и модулям — тем же группам, что и маска
+BUSYBOX_COMMANDS (см. Busybox_Config.h).
+
+Пример:
+    python3 tools/bbsize.py .pio/build/esp32dev/firmware.elf
+    python3 tools/bbsize.py --nm xtensa-lx106-elf-nm build/sketch.ino.elf
+    python3 tools/bbsize.py -v firmware.elf          # с отдельными символами
+
+Функции, встроенные компилятором в место вызова, отдельного символа не имеют
+и учитываются в размере вызывающей функции (обычно это сама команда).
+"""
+
+import argparse
+import re
+import shutil
+import subprocess
+import sys
+from collections import defaultdict
+
+# Префикс имени (без Busybox::) -> группа; проверяются по порядку
+GROUPS = [
+    ("ls", r"(ls|_ls\w*|Ls\w+)$"),
+    ("tree", r"tree$"),
+    ("cat", r"cat$"),
+    ("dump", r"(dump|_dump\w*|_base64\w*|_ihex\w*|_hexByte|Dump\w+)$"),
+    ("view", r"view1?$"),
+    ("sysinfo", r"(sysinfo|resetReasonStr)$"),
+    ("heapprof", r"(heapprof|_heap\w*|HeapProfile|HeapSample)$"),
+    ("top", r"(top|_top\w*|TopState)$"),
+    ("fsbench", r"(fsbench|_bench\w*|LatencyHist)$"),
+    ("async", r"(async\w*|_async\w*|Async\w+)$"),
+    ("pack", r"(pack\w*|_pack\w*|Pack\w+)$"),
+    ("wear", r"(wear\w*|_wear\w*|Wear\w+)$"),
+    ("fsck", r"(fsck|_fsck\w*|Fsck\w+|TreeWalker)$"),
+    ("snapshot", r"(snapshot|diff|_snapshot\w*|_diff\w*|Manifest\w+|Snapshot\w+|DiffReport)$"),
+    ("cp modes", r"(_cp\w*|Cp\w+)$"),
+    ("kv", r"(KV\w*)$"),
+    ("ring", r"(tail|_tail\w*|_ring\w*|Ring\w+)$"),
+    ("reclog", r"(query|_reclog\w*|Record\w+)$"),
+    ("text", r"(wc|uniq|sort|_sort\w*|_text\w*|Sort\w+|LineReader|WcReport)$"),
+    ("watch", r"(_watch\w*|Watch\w*|ChangeEvent|changeOpStr)$"),
+    ("rm glob", r"(_glob\w*|Rm\w+)$"),
+    ("part", r"(part\w*|_part\w*|Part\w+|coredump)$"),
+    ("map", r"(map\w*|unmap|_map\w*|Map\w+)$"),
+    ("cache", r"(cache\w*|_cache\w*|Cache\w+|Block(Reader|Writer))$"),
+    ("stats/lock", r"(stats|lockStats|_stats\w*|_fsLock|\w*Lock|CommandScope|\w*Stats|StatsTable)$"),
+]
+GROUPS = [(name, re.compile(pattern)) for name, pattern in GROUPS]
+
+SYMBOL = re.compile(r"^[0-9a-fA-F]+\s+([0-9a-fA-F]+)\s+(\w)\s+(.*)$")
+
+
+def find_nm(explicit):
+    if explicit:
+        return explicit
+    for name in ("xtensa-esp32-elf-nm", "xtensa-lx106-elf-nm", "riscv32-esp-elf-nm", "nm"):
+        path = shutil.which(name)
+        if path:
+            return path
+    sys.exit("nm not found, use --nm")
+
+
+def classify(symbol):
+    # Busybox::name(...), Busybox::Class::method(...), guard variables и т.п.
+    m = re.search(r"Busybox::(\w+)", symbol)
+    if not m:
+        return None
+    name = m.group(1)
+    for group, pattern in GROUPS:
+        if pattern.match(name):
+            return group
+    return "core"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Busybox code size per command")
+    parser.add_argument("elf")
+    parser.add_argument("--nm", help="nm из тулчейна платы")
+    parser.add_argument("-v", "--verbose", action="store_true", help="вывести символы каждой группы")
+    args = parser.parse_args()
+
+    out = subprocess.run([find_nm(args.nm), "-C", "-S", "--size-sort", args.elf],
+                         check=True, capture_output=True, text=True).stdout
+
+    sizes = defaultdict(int)
+    symbols = defaultdict(list)
+    for line in out.splitlines():
+        m = SYMBOL.match(line)
+        if not m:
+            continue
+        size, kind, symbol = int(m.group(1), 16), m.group(2), m.group(3)
+        group = classify(symbol)
+        if group is None:
+            continue
+        sizes[group] += size
+        symbols[group].append((size, kind, symbol))
+
+    if not sizes:
+        sys.exit("no Busybox symbols in %s" % args.elf)
+
+    total = sum(sizes.values())
+    print("%-12s %8s %6s" % ("command", "bytes", "%"))
+    for group, size in sorted(sizes.items(), key=lambda item: -item[1]):
+        print("%-12s %8d %5.1f%%" % (group, size, size * 100.0 / total))
+        if args.verbose:
+            for size, kind, symbol in sorted(symbols[group], reverse=True):
+                print("    %6d %s %s" % (size, kind, symbol))
+    print("%-12s %8d" % ("total", total))
+
+
+if __name__ == "__main__":
+    main()